@@ -0,0 +1,95 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "functions.hpp"
+
+#include "batch.hpp"
+#include "chain.hpp"
+
+#include <benchmark/benchmark.h>
+#include <pcg_random.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+/// Solves `range(1)` independent problems of dimension `range(0)` one after
+/// another with #dual_annealing::minimize.
+template <class Function> auto bm_many_minimize(benchmark::State& state)
+    -> void
+{
+    auto const dim    = static_cast<size_t>(state.range(0));
+    auto const count  = static_cast<size_t>(state.range(1));
+    auto const params = bench::default_params();
+    pcg32      generator{1230045};
+
+    std::vector<float> xs(dim * count);
+    for (auto _ : state) {
+        state.PauseTiming();
+        bench::random_point(xs, generator);
+        state.ResumeTiming();
+        for (auto i = size_t{0}; i < count; ++i) {
+            benchmark::DoNotOptimize(dual_annealing::minimize(
+                Function{}, gsl::span<float>{xs.data() + i * dim, dim},
+                params, generator));
+        }
+    }
+    state.counters["problems/s"] = benchmark::Counter(
+        static_cast<double>(count),
+        benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/// Same as #bm_many_minimize but using #dual_annealing::minimize_batch.
+template <class Function> auto bm_many_minimize_batch(benchmark::State& state)
+    -> void
+{
+    auto const dim    = static_cast<size_t>(state.range(0));
+    auto const count  = static_cast<size_t>(state.range(1));
+    auto const params = bench::default_params();
+    pcg32      generator{1230045};
+
+    std::vector<float> xs(dim * count);
+    for (auto _ : state) {
+        state.PauseTiming();
+        bench::random_point(xs, generator);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(dual_annealing::minimize_batch(
+            Function{}, xs, dim, params, generator));
+    }
+    state.counters["problems/s"] = benchmark::Counter(
+        static_cast<double>(count),
+        benchmark::Counter::kIsIterationInvariantRate);
+}
+} // namespace
+
+BENCHMARK_TEMPLATE(bm_many_minimize, bench::rastrigin_t)
+    ->ArgsProduct({{2, 8}, {64}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bm_many_minimize_batch, bench::rastrigin_t)
+    ->ArgsProduct({{2, 8}, {64}})
+    ->Unit(benchmark::kMillisecond);
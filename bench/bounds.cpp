@@ -0,0 +1,93 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "functions.hpp"
+
+#include "bounds.hpp"
+
+#include <benchmark/benchmark.h>
+#include <pcg_random.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace {
+/// Random proposals around the origin, some of which leave the box.
+auto make_points(size_t const dim) -> std::vector<float>
+{
+    pcg32                                 generator{1230045};
+    std::vector<float>                    x(dim);
+    std::uniform_real_distribution<float> dist{-20.0f, 20.0f};
+    for (auto& a : x) {
+        a = dist(generator);
+    }
+    return x;
+}
+
+/// Wrapping D coordinates one by one with an `fmod`-based `wrap(x)`.
+auto bm_wrap_fmod(benchmark::State& state) -> void
+{
+    auto const              dim = static_cast<size_t>(state.range(0));
+    auto const              x   = make_points(dim);
+    std::vector<float>      y(dim);
+    bench::to_range_t const wrap{-5.12f, 5.12f};
+    for (auto _ : state) {
+        for (auto i = size_t{0}; i < dim; ++i) {
+            y[i] = wrap(x[i]);
+        }
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(dim));
+}
+BENCHMARK(bm_wrap_fmod)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+/// Same as #bm_wrap_fmod but using #dual_annealing::box_bounds_t::wrap.
+auto bm_wrap_box(benchmark::State& state) -> void
+{
+    auto const dim = static_cast<size_t>(state.range(0));
+    auto const boundary =
+        static_cast<dual_annealing::boundary_t>(state.range(1));
+    auto const                         x = make_points(dim);
+    std::vector<float>                 y(dim);
+    dual_annealing::box_bounds_t const bounds{dim, -5.12f, 5.12f, boundary};
+    for (auto _ : state) {
+        std::copy(x.begin(), x.end(), y.begin());
+        bounds.wrap(y);
+        benchmark::DoNotOptimize(y.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(dim));
+}
+BENCHMARK(bm_wrap_box)->ArgsProduct({benchmark::CreateRange(8, 1 << 15, 8),
+                                     {0, 1}});
+} // namespace
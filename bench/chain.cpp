@@ -0,0 +1,161 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "functions.hpp"
+
+#include "buffers.hpp"
+#include "chain.hpp"
+
+#include <benchmark/benchmark.h>
+#include <pcg_random.hpp>
+
+#include <cstddef>
+
+namespace {
+/// Cost of one iteration of the annealing schedule, i.e. `2 * D` proposals.
+///
+/// Reported time is per iteration. `evals/s` counts all function evaluations
+/// including the single-coordinate ones.
+template <class Function> auto bm_chain_iteration(benchmark::State& state)
+    -> void
+{
+    auto const dim    = static_cast<size_t>(state.range(0));
+    auto const params = bench::default_params();
+    pcg32      generator{1230045};
+
+    dual_annealing::sa_buffers_t buffers{dim};
+    auto                         workspace = buffers.workspace();
+    bench::random_point(workspace.current.x, generator);
+    dual_annealing::sa_chain_t<Function, pcg32> chain{Function{}, workspace,
+                                                      params, generator};
+    auto const evals_before = chain.num_f_evals();
+    for (auto _ : state) {
+        chain();
+    }
+    state.counters["evals/s"] = benchmark::Counter(
+        static_cast<double>(chain.num_f_evals() - evals_before),
+        benchmark::Counter::kIsRate);
+    state.counters["dim"] = static_cast<double>(dim);
+}
+
+/// \brief Same as #bm_chain_iteration, but full visits are replaced by block
+/// moves of `state.range(1)` coordinates (see `param_t::block_size`).
+template <class Function>
+auto bm_chain_iteration_block(benchmark::State& state) -> void
+{
+    auto const dim    = static_cast<size_t>(state.range(0));
+    auto       params = bench::default_params();
+    params.block_size = static_cast<size_t>(state.range(1));
+    pcg32 generator{1230045};
+
+    dual_annealing::sa_buffers_t buffers{dim};
+    auto                         workspace = buffers.workspace();
+    bench::random_point(workspace.current.x, generator);
+    dual_annealing::sa_chain_t<Function, pcg32> chain{Function{}, workspace,
+                                                      params, generator};
+    auto const evals_before = chain.num_f_evals();
+    for (auto _ : state) {
+        chain();
+    }
+    state.counters["evals/s"] = benchmark::Counter(
+        static_cast<double>(chain.num_f_evals() - evals_before),
+        benchmark::Counter::kIsRate);
+    state.counters["dim"] = static_cast<double>(dim);
+}
+
+/// \brief \p Function without `coordinate_deltas`.
+///
+/// The single-coordinate moves are then evaluated one at a time, which allows
+/// to compare against the sweep.
+template <class Function> struct one_at_a_time_t : Function {
+    auto coordinate_deltas(gsl::span<float const>, gsl::span<float const>,
+                           gsl::span<double>) const -> void = delete;
+};
+
+/// Same as #bm_chain_iteration but with the dimension known at compile time.
+template <class Function, size_t N>
+auto bm_chain_iteration_fixed(benchmark::State& state) -> void
+{
+    auto const params = bench::default_params();
+    pcg32      generator{1230045};
+
+    dual_annealing::fixed_workspace_t<N> workspace;
+    bench::random_point(workspace.current.x, generator);
+    dual_annealing::sa_chain_t<Function, pcg32,
+                               dual_annealing::fixed_workspace_t<N>>
+               chain{Function{}, workspace, params, generator};
+    auto const evals_before = chain.num_f_evals();
+    for (auto _ : state) {
+        chain();
+    }
+    state.counters["evals/s"] = benchmark::Counter(
+        static_cast<double>(chain.num_f_evals() - evals_before),
+        benchmark::Counter::kIsRate);
+    state.counters["dim"] = static_cast<double>(N);
+}
+} // namespace
+
+// Full visits cost O(D) evaluations of O(D) each, so one iteration is O(D²)
+// for all functions. Large dimensions therefore run for a single iteration.
+#define DA_BENCHMARK_CHAIN(Function)                                           \
+    BENCHMARK_TEMPLATE(bm_chain_iteration, Function)                           \
+        ->RangeMultiplier(4)                                                   \
+        ->Range(2, 1024);                                                      \
+    BENCHMARK_TEMPLATE(bm_chain_iteration, Function)                           \
+        ->Arg(4096)                                                            \
+        ->Arg(16384)                                                           \
+        ->Arg(100000)                                                          \
+        ->Iterations(1)                                                        \
+        ->Unit(benchmark::kMillisecond)
+
+DA_BENCHMARK_CHAIN(bench::rastrigin_t);
+DA_BENCHMARK_CHAIN(bench::ackley_t);
+DA_BENCHMARK_CHAIN(bench::schwefel_t);
+DA_BENCHMARK_CHAIN(bench::rosenbrock_t);
+DA_BENCHMARK_CHAIN(one_at_a_time_t<bench::rastrigin_t>);
+DA_BENCHMARK_CHAIN(one_at_a_time_t<bench::rosenbrock_t>);
+
+BENCHMARK_TEMPLATE(bm_chain_iteration_fixed, bench::rastrigin_t, 2);
+BENCHMARK_TEMPLATE(bm_chain_iteration_fixed, bench::rastrigin_t, 8);
+BENCHMARK_TEMPLATE(bm_chain_iteration_fixed, bench::rastrigin_t, 32);
+BENCHMARK_TEMPLATE(bm_chain_iteration_fixed, bench::rosenbrock_t, 2);
+BENCHMARK_TEMPLATE(bm_chain_iteration_fixed, bench::rosenbrock_t, 8);
+BENCHMARK_TEMPLATE(bm_chain_iteration_fixed, bench::rosenbrock_t, 32);
+
+// A block move costs O(block_size), so unlike full visits this scales to
+// millions of coordinates.
+#define DA_BENCHMARK_CHAIN_BLOCK(Function)                                     \
+    BENCHMARK_TEMPLATE(bm_chain_iteration_block, Function)                     \
+        ->Args({1024, 8})                                                      \
+        ->Args({1 << 16, 8})                                                   \
+        ->Args({1 << 16, 64})                                                  \
+        ->Args({1 << 20, 8})                                                   \
+        ->Unit(benchmark::kMillisecond)
+
+DA_BENCHMARK_CHAIN_BLOCK(bench::rastrigin_t);
+DA_BENCHMARK_CHAIN_BLOCK(bench::rosenbrock_t);
@@ -0,0 +1,68 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "checkpoint.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdio> // std::remove
+#include <string>
+#include <vector>
+
+namespace {
+/// \brief Cost of one save, which is what the chain pays every
+/// `interval()` iterations.
+///
+/// The write-back to disk happens asynchronously and is not included.
+auto bm_checkpoint_save(benchmark::State& state) -> void
+{
+    auto const dim  = static_cast<size_t>(state.range(0));
+    auto const path = std::string{"bench_checkpoint.bin"};
+    std::remove(path.c_str());
+
+    std::vector<float>     current(dim, 1.0f);
+    std::vector<float>     best(dim, 2.0f);
+    std::vector<std::byte> generator(16);
+    dual_annealing::checkpoint_t checkpoint{path};
+    checkpoint.open(dual_annealing::checkpoint_layout_t{
+        /*dim=*/dim, /*generator_size=*/generator.size(), /*q_V=*/2.62f,
+        /*q_A=*/-5.0f, /*t_0=*/5230.0f});
+    auto info = dual_annealing::checkpoint_state_t{};
+    for (auto _ : state) {
+        ++info.iteration;
+        checkpoint.save(info, current, best, generator);
+    }
+    checkpoint.close();
+    std::remove(path.c_str());
+    state.SetBytesProcessed(
+        static_cast<int64_t>(state.iterations())
+        * static_cast<int64_t>(2 * dim * sizeof(float)));
+}
+BENCHMARK(bm_checkpoint_save)->RangeMultiplier(10)->Range(100, 1000000);
+} // namespace
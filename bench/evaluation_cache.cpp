@@ -0,0 +1,64 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "evaluation_cache.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+/// \brief Overhead of a lookup which hits, i.e. what a repeated point costs
+/// instead of an evaluation.
+auto bm_cache_hit(benchmark::State& state) -> void
+{
+    auto const dim = static_cast<size_t>(state.range(0));
+    auto       cache = dual_annealing::evaluation_cache_t{{1024, 1e-3f}};
+    std::vector<float> x(dim, 0.5f);
+    cache.insert(x, 1.0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.find(x));
+    }
+}
+BENCHMARK(bm_cache_hit)->RangeMultiplier(10)->Range(10, 100000);
+
+/// Cost of a miss followed by an insert into a full cache.
+auto bm_cache_miss(benchmark::State& state) -> void
+{
+    auto const dim = static_cast<size_t>(state.range(0));
+    auto       cache = dual_annealing::evaluation_cache_t{{1024, 0.0f}};
+    std::vector<float> x(dim, 0.5f);
+    for (auto _ : state) {
+        x[0] += 1.0f;
+        benchmark::DoNotOptimize(cache.find(x));
+        cache.insert(x, 1.0);
+    }
+}
+BENCHMARK(bm_cache_miss)->RangeMultiplier(10)->Range(10, 100000);
+} // namespace
@@ -0,0 +1,299 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "chain.hpp"
+#include "separable.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cmath>   // std::cos, std::sin, std::sqrt, std::exp, std::fmod
+#include <cstddef> // size_t
+#include <random>  // std::uniform_real_distribution
+#include <utility> // std::pair
+#include <vector>  // std::vector
+
+/// \file functions.hpp
+/// \brief Standard test functions used by the benchmarks.
+///
+/// Every function provides everything the annealer can make use of:
+/// `value`, a cheap way to re-evaluate after a single-coordinate move,
+/// `value_and_gradient` for the local search, and `wrap`.
+
+namespace bench {
+
+struct to_range_t {
+    float min;
+    float max;
+
+    auto operator()(float const x) const -> float
+    {
+        auto const length = max - min;
+        auto const delta =
+            std::fmod(std::fmod(x - min, length) + length, length);
+        return min + delta;
+    }
+};
+
+/// Rastrigin function on `[-5.12, 5.12]^D`.
+struct rastrigin_terms_t {
+    static constexpr auto A = 10.0;
+    to_range_t            _wrap{-5.12f, 5.12f};
+
+    auto term(size_t /*unused*/, float const x) const -> double
+    {
+        auto const a = static_cast<double>(x);
+        return A + a * a - A * std::cos(2.0 * M_PI * a);
+    }
+
+    auto derivative(size_t /*unused*/, float const x) const -> double
+    {
+        auto const a = static_cast<double>(x);
+        return 2.0 * a + 2.0 * M_PI * A * std::sin(2.0 * M_PI * a);
+    }
+
+    auto wrap(float const x) const -> float { return _wrap(x); }
+};
+
+using rastrigin_t = dual_annealing::separable_t<rastrigin_terms_t>;
+
+/// Schwefel function on `[-500, 500]^D`.
+struct schwefel_terms_t {
+    static constexpr auto A = 418.9828872724338;
+    to_range_t            _wrap{-500.0f, 500.0f};
+
+    auto term(size_t /*unused*/, float const x) const -> double
+    {
+        auto const a = static_cast<double>(x);
+        return A - a * std::sin(std::sqrt(std::abs(a)));
+    }
+
+    auto derivative(size_t /*unused*/, float const x) const -> double
+    {
+        auto const a = static_cast<double>(x);
+        auto const r = std::sqrt(std::abs(a));
+        return -std::sin(r) - 0.5 * r * std::cos(r);
+    }
+
+    auto wrap(float const x) const -> float { return _wrap(x); }
+};
+
+using schwefel_t = dual_annealing::separable_t<schwefel_terms_t>;
+
+/// \brief Ackley function on `[-32.768, 32.768]^D`.
+///
+/// It is not separable, but it only depends on `Σxᵢ²` and `Σcos(2πxᵢ)`, so
+/// it implements the incremental evaluation protocol by caching both sums.
+class ackley_t {
+    static constexpr auto A = 20.0;
+    static constexpr auto B = 0.2;
+
+    to_range_t         _wrap{-32.768f, 32.768f};
+    std::vector<float> _x;        ///< Current point of the chain
+    double             _sum_sq;   ///< Σxᵢ² at #_x
+    double             _sum_cos;  ///< Σcos(2πxᵢ) at #_x
+    size_t             _index;    ///< Coordinate of the pending move
+    float              _proposed; ///< New value of the pending move
+    double             _proposed_sum_sq;
+    double             _proposed_sum_cos;
+
+    static auto from_sums(double const sum_sq, double const sum_cos,
+                          size_t const n) -> double
+    {
+        auto const d = static_cast<double>(n);
+        return -A * std::exp(-B * std::sqrt(sum_sq / d))
+               - std::exp(sum_cos / d) + A + M_E;
+    }
+
+  public:
+    auto value(gsl::span<float const> x) const -> double
+    {
+        auto sum_sq = 0.0, sum_cos = 0.0;
+        for (auto const a : x) {
+            sum_sq += static_cast<double>(a) * static_cast<double>(a);
+            sum_cos += std::cos(2.0 * M_PI * static_cast<double>(a));
+        }
+        return from_sums(sum_sq, sum_cos, x.size());
+    }
+
+    auto value_and_gradient(gsl::span<float const> x, gsl::span<float> g) const
+        -> double
+    {
+        auto sum_sq = 0.0, sum_cos = 0.0;
+        for (auto const a : x) {
+            sum_sq += static_cast<double>(a) * static_cast<double>(a);
+            sum_cos += std::cos(2.0 * M_PI * static_cast<double>(a));
+        }
+        auto const d    = static_cast<double>(x.size());
+        auto const r    = std::sqrt(sum_sq / d);
+        auto const e_sq = r > 0.0 ? A * B * std::exp(-B * r) / (d * r) : 0.0;
+        auto const e_cos = 2.0 * M_PI * std::exp(sum_cos / d) / d;
+        for (auto i = size_t{0}; i < x.size(); ++i) {
+            auto const a = static_cast<double>(x[i]);
+            g[i] = static_cast<float>(e_sq * a
+                                      + e_cos * std::sin(2.0 * M_PI * a));
+        }
+        return from_sums(sum_sq, sum_cos, x.size());
+    }
+
+    auto reset(gsl::span<float const> x) -> void
+    {
+        _x.assign(x.begin(), x.end());
+        _sum_sq  = 0.0;
+        _sum_cos = 0.0;
+        for (auto const a : x) {
+            _sum_sq += static_cast<double>(a) * static_cast<double>(a);
+            _sum_cos += std::cos(2.0 * M_PI * static_cast<double>(a));
+        }
+    }
+
+    auto propose(size_t const i, float const y) -> double
+    {
+        auto const a = static_cast<double>(_x[i]);
+        auto const b = static_cast<double>(y);
+        _index       = i;
+        _proposed    = y;
+        _proposed_sum_sq = _sum_sq - a * a + b * b;
+        _proposed_sum_cos =
+            _sum_cos - std::cos(2.0 * M_PI * a) + std::cos(2.0 * M_PI * b);
+        return from_sums(_proposed_sum_sq, _proposed_sum_cos, _x.size())
+               - from_sums(_sum_sq, _sum_cos, _x.size());
+    }
+
+    auto commit() -> void
+    {
+        _x[_index] = _proposed;
+        _sum_sq    = _proposed_sum_sq;
+        _sum_cos   = _proposed_sum_cos;
+    }
+
+    auto rollback() noexcept -> void {}
+
+    auto wrap(float const x) const -> float { return _wrap(x); }
+};
+
+/// \brief Rosenbrock function on `[-5, 10]^D`.
+///
+/// Coordinate `i` only enters two terms of the sum, so `value_from_diff` is
+/// O(1) and `coordinate_deltas` is O(D).
+struct rosenbrock_t {
+    to_range_t _wrap{-5.0f, 10.0f};
+
+    static auto term(float const x, float const y) -> double
+    {
+        auto const a = static_cast<double>(x);
+        auto const b = static_cast<double>(y);
+        return 100.0 * (b - a * a) * (b - a * a) + (1.0 - a) * (1.0 - a);
+    }
+
+    auto value(gsl::span<float const> x) const -> double
+    {
+        auto sum = 0.0;
+        for (auto i = size_t{1}; i < x.size(); ++i) {
+            sum += term(x[i - 1], x[i]);
+        }
+        return sum;
+    }
+
+    auto value_from_diff(std::pair<gsl::span<float const>, double> current,
+                         std::pair<size_t, float> diff) const -> double
+    {
+        auto const [x, func] = current;
+        auto const [i, y]    = diff;
+        auto result          = func;
+        if (i > 0) { result += term(x[i - 1], y) - term(x[i - 1], x[i]); }
+        if (i + 1 < x.size()) {
+            result += term(y, x[i + 1]) - term(x[i], x[i + 1]);
+        }
+        return result;
+    }
+
+    auto coordinate_deltas(gsl::span<float const> x, gsl::span<float const> ys,
+                           gsl::span<double> out) const -> void
+    {
+        for (auto i = size_t{0}; i < x.size(); ++i) {
+            auto delta = 0.0;
+            if (i > 0) {
+                delta += term(x[i - 1], ys[i]) - term(x[i - 1], x[i]);
+            }
+            if (i + 1 < x.size()) {
+                delta += term(ys[i], x[i + 1]) - term(x[i], x[i + 1]);
+            }
+            out[i] = delta;
+        }
+    }
+
+    /// Coordinate `i` only interacts with `i - 1` and `i + 1`.
+    static constexpr auto coupling() noexcept -> size_t { return 1; }
+
+    auto value_and_gradient(gsl::span<float const> x, gsl::span<float> g) const
+        -> double
+    {
+        for (auto i = size_t{0}; i < x.size(); ++i) {
+            auto const a = static_cast<double>(x[i]);
+            auto       d = 0.0;
+            if (i + 1 < x.size()) {
+                auto const b = static_cast<double>(x[i + 1]);
+                d += -400.0 * a * (b - a * a) - 2.0 * (1.0 - a);
+            }
+            if (i > 0) {
+                auto const c = static_cast<double>(x[i - 1]);
+                d += 200.0 * (a - c * c);
+            }
+            g[i] = static_cast<float>(d);
+        }
+        return value(x);
+    }
+
+    auto wrap(float const x) const -> float { return _wrap(x); }
+};
+
+/// \brief Fills \p x with a random point from `[-2, 2]^D`.
+///
+/// This box lies inside the domains of all the functions above.
+template <class Generator>
+auto random_point(gsl::span<float> x, Generator& generator) -> void
+{
+    std::uniform_real_distribution<float> dist{-2.0f, 2.0f};
+    for (auto& a : x) {
+        a = dist(generator);
+    }
+}
+
+/// Hyper-parameters used by all benchmarks, same as SciPy's defaults.
+inline auto default_params() noexcept -> dual_annealing::param_t
+{
+    return dual_annealing::param_t{/*q_V=*/2.62f,
+                                   /*q_A=*/-5.0f,
+                                   /*t_0=*/5230.0f,
+                                   /*num_iter=*/1000,
+                                   /*patience=*/100};
+}
+
+} // namespace bench
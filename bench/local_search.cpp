@@ -0,0 +1,158 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "functions.hpp"
+
+#include "buffers.hpp"
+#include "chain.hpp"
+
+#include <benchmark/benchmark.h>
+#include <lbfgs/lbfgs.hpp>
+#include <pcg_random.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+/// #sa_chain_t::local_search from a fresh random point.
+///
+/// Compare with #bm_lbfgs to see the overhead the chain adds on top of
+/// L-BFGS itself.
+template <class Function> auto bm_local_search(benchmark::State& state) -> void
+{
+    auto const dim    = static_cast<size_t>(state.range(0));
+    auto const params = bench::default_params();
+    auto const lbfgs_params = tcm::lbfgs::lbfgs_param_t{};
+    pcg32      generator{1230045};
+
+    std::vector<float> start(dim);
+    bench::random_point(start, generator);
+    dual_annealing::sa_buffers_t buffers{dim};
+    auto                         workspace = buffers.workspace();
+
+    auto num_f_evals = size_t{0};
+    for (auto _ : state) {
+        std::memcpy(workspace.current.x.data(), start.data(),
+                    dim * sizeof(float));
+        dual_annealing::sa_chain_t<Function, pcg32> chain{
+            Function{}, workspace, params, generator};
+        benchmark::DoNotOptimize(chain.local_search(lbfgs_params));
+        num_f_evals += chain.num_f_evals();
+    }
+    state.counters["evals/s"] = benchmark::Counter(
+        static_cast<double>(num_f_evals), benchmark::Counter::kIsRate);
+}
+
+/// Plain L-BFGS on the same problem as #bm_local_search.
+template <class Function> auto bm_lbfgs(benchmark::State& state) -> void
+{
+    auto const dim          = static_cast<size_t>(state.range(0));
+    auto const lbfgs_params = tcm::lbfgs::lbfgs_param_t{};
+    pcg32      generator{1230045};
+
+    std::vector<float> start(dim);
+    bench::random_point(start, generator);
+    std::vector<float> x(dim);
+    auto               function = Function{};
+
+    auto num_f_evals = size_t{0};
+    for (auto _ : state) {
+        std::memcpy(x.data(), start.data(), dim * sizeof(float));
+        benchmark::DoNotOptimize(tcm::lbfgs::minimize(
+            [&function, &num_f_evals](gsl::span<float const> y,
+                                      gsl::span<float>       g) {
+                ++num_f_evals;
+                return function.value_and_gradient(y, g);
+            },
+            lbfgs_params, gsl::span<float>{x}));
+    }
+    state.counters["evals/s"] = benchmark::Counter(
+        static_cast<double>(num_f_evals), benchmark::Counter::kIsRate);
+}
+
+/// \brief Repeated #sa_chain_t::local_search from slightly perturbed points.
+///
+/// This is the situation in which warm starts pay off: with
+/// `state.range(1) == 1` the chain keeps its L-BFGS history between calls
+/// (see #dual_annealing::warm_start_param_t), otherwise the history is
+/// dropped every time. Compare the evals/polish counters.
+template <class Function>
+auto bm_repeated_local_search(benchmark::State& state) -> void
+{
+    auto const dim    = static_cast<size_t>(state.range(0));
+    auto const params = bench::default_params();
+    auto       lbfgs_params = dual_annealing::warm_start_param_t{};
+    lbfgs_params.reset_distance =
+        state.range(1) != 0 ? std::numeric_limits<float>::infinity() : 0.0f;
+    pcg32 generator{1230045};
+    std::normal_distribution<float> noise{0.0f, 0.01f};
+
+    std::vector<float> start(dim);
+    bench::random_point(start, generator);
+    dual_annealing::sa_buffers_t buffers{dim};
+    auto                         workspace = buffers.workspace();
+    std::memcpy(workspace.current.x.data(), start.data(), dim * sizeof(float));
+    dual_annealing::sa_chain_t<Function, pcg32> chain{Function{}, workspace,
+                                                      params, generator};
+    auto num_polishes = size_t{0};
+    for (auto _ : state) {
+        chain.sync_best();
+        for (auto& x : workspace.current.x) {
+            x += noise(generator);
+        }
+        workspace.current.func = Function{}.value(workspace.current.x);
+        chain.current_changed();
+        benchmark::DoNotOptimize(chain.local_search(lbfgs_params));
+        ++num_polishes;
+    }
+    state.counters["evals/polish"] =
+        static_cast<double>(chain.num_local_search_f_evals())
+        / static_cast<double>(num_polishes);
+}
+} // namespace
+
+#define DA_BENCHMARK_LOCAL_SEARCH(Function)                                    \
+    BENCHMARK_TEMPLATE(bm_local_search, Function)                              \
+        ->RangeMultiplier(8)                                                   \
+        ->Range(2, 1 << 15)                                                    \
+        ->Unit(benchmark::kMicrosecond);                                       \
+    BENCHMARK_TEMPLATE(bm_lbfgs, Function)                                     \
+        ->RangeMultiplier(8)                                                   \
+        ->Range(2, 1 << 15)                                                    \
+        ->Unit(benchmark::kMicrosecond);                                       \
+    BENCHMARK_TEMPLATE(bm_repeated_local_search, Function)                     \
+        ->ArgsProduct({{16, 256, 4096}, {0, 1}})                               \
+        ->Unit(benchmark::kMicrosecond)
+
+DA_BENCHMARK_LOCAL_SEARCH(bench::rastrigin_t);
+DA_BENCHMARK_LOCAL_SEARCH(bench::ackley_t);
+DA_BENCHMARK_LOCAL_SEARCH(bench::schwefel_t);
+DA_BENCHMARK_LOCAL_SEARCH(bench::rosenbrock_t);
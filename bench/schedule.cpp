@@ -0,0 +1,91 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "chain.hpp"
+#include "schedule.hpp"
+
+#include <benchmark/benchmark.h>
+#include <pcg_random.hpp>
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace {
+/// Cost of one acceptance test for uphill moves.
+///
+/// The argument is `2 * q_A`: -10 hits the integer-power path, -11 the
+/// general `std::pow` one.
+auto bm_acceptance(benchmark::State& state) -> void
+{
+    constexpr auto n = size_t{1024};
+    auto const     q_A = static_cast<float>(state.range(0)) / 2.0f;
+    dual_annealing::detail::acceptance_rule_t const rule{q_A};
+
+    pcg32                                 generator{1230045};
+    std::uniform_real_distribution<float> dist;
+    std::vector<float>                    u(n);
+    std::vector<float>                    dE(n);
+    for (auto i = size_t{0}; i < n; ++i) {
+        u[i]  = dist(generator);
+        dE[i] = 3.0f * dist(generator);
+    }
+    auto count = size_t{0};
+    for (auto _ : state) {
+        for (auto i = size_t{0}; i < n; ++i) {
+            count += static_cast<size_t>(rule.accepts(u[i], dE[i], 5.0f));
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(n));
+}
+BENCHMARK(bm_acceptance)->Arg(-10)->Arg(-11);
+
+/// Visiting parameters computed on the fly vs looked up in a
+/// #dual_annealing::temperature_table_t.
+auto bm_visiting_param(benchmark::State& state) -> void
+{
+    constexpr auto num_iter = size_t{1024};
+    dual_annealing::param_t params{};
+    params.q_V = 2.62f;
+    params.t_0 = 5230.0f;
+    dual_annealing::temperature_table_t const table{params.q_V, params.t_0,
+                                                    num_iter};
+    if (state.range(0) != 0) { params.temperatures = &table; }
+    for (auto _ : state) {
+        for (auto i = size_t{0}; i < num_iter; ++i) {
+            auto const p = dual_annealing::detail::visiting_param(params, i);
+            benchmark::DoNotOptimize(p);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(num_iter));
+}
+BENCHMARK(bm_visiting_param)->Arg(0)->Arg(1);
+} // namespace
@@ -0,0 +1,399 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file time_to_target.cpp
+/// \brief End-to-end quality harness.
+///
+/// Runs #minimize over a matrix of test functions, dimensions, parameter
+/// sets and seeds, and records how long (in seconds and function
+/// evaluations) each run takes to get within `--target` of the global
+/// minimum, which is `0` for all functions in functions.hpp. A run stops as
+/// soon as it reaches the target, exhausts `num_iter` or `patience`, or
+/// exceeds `--time-limit` seconds.
+///
+/// Every run is written as one record (CSV or JSON) to `--output` (default:
+/// stdout), and a summary per cell of the matrix goes to stderr. Field names
+/// map onto SciPy's `OptimizeResult` as `func` → `fun`, `num_f_evals` →
+/// `nfev` and `num_iter` → `nit`, so the same scripts can process the output
+/// of `scipy.optimize.dual_annealing`.
+///
+/// Example:
+///
+///     bench_time_to_target --dims 2,10 --seeds 20 --format json
+
+#include "chain.hpp"
+#include "functions.hpp"
+#include "observers.hpp"
+
+#include <pcg_random.hpp>
+
+#include <algorithm> // std::sort
+#include <chrono>    // std::chrono::steady_clock
+#include <cstdio>    // std::fprintf, std::fopen
+#include <cstdlib>   // EXIT_SUCCESS, EXIT_FAILURE
+#include <cstring>   // std::strcmp
+#include <optional>  // std::optional
+#include <stdexcept> // std::invalid_argument
+#include <string>    // std::string, std::stod, std::stoul
+#include <vector>    // std::vector
+
+namespace {
+
+enum class format_t { csv, json };
+
+/// Hyper-parameters of one column of the matrix.
+struct param_set_t {
+    char const*             name;
+    dual_annealing::param_t params;
+    bool                    local_search;
+};
+
+struct options_t {
+    std::vector<std::string> functions = {"rastrigin", "schwefel", "ackley",
+                                          "rosenbrock"};
+    std::vector<size_t>      dims      = {2, 10};
+    std::vector<std::string> param_sets = {"default", "no_local_search"};
+    size_t                   num_seeds  = 10;
+    double                   target     = 1e-4;
+    double                   time_limit = 60.0; ///< Seconds per run
+    size_t                   num_iter   = 1000;
+    format_t                 format     = format_t::csv;
+    std::string              output;
+};
+
+/// Outcome of one run.
+struct record_t {
+    std::string function;
+    size_t      dim;
+    std::string param_set;
+    size_t      seed;
+    bool        success;
+    double      func;
+    double      wall_time; ///< Seconds
+    size_t      num_f_evals;
+    size_t      num_local_search_f_evals;
+    size_t      num_iter;
+    double      acceptance;
+};
+
+auto make_param_set(std::string const& name, size_t const num_iter)
+    -> param_set_t
+{
+    auto params     = bench::default_params();
+    params.num_iter = num_iter;
+    if (name == "default") { return param_set_t{"default", params, true}; }
+    if (name == "no_local_search") {
+        return param_set_t{"no_local_search", params, false};
+    }
+    if (name == "restarts") {
+        // Reanneal stagnated chains instead of giving up on them
+        params.max_restarts       = 10;
+        params.restart_temp_ratio = 2e-5f;
+        return param_set_t{"restarts", params, true};
+    }
+    if (name == "adaptive") {
+        params.target_acceptance = 0.3f;
+        return param_set_t{"adaptive", params, false};
+    }
+    throw std::invalid_argument{"unknown parameter set: " + name};
+}
+
+/// Runs one cell of the matrix with \p seed.
+template <class Objective>
+auto run_one(Objective obj, size_t const dim, param_set_t const& set,
+             size_t const seed, options_t const& options) -> record_t
+{
+    pcg32 generator{seed};
+    auto  x = std::vector<float>(dim);
+    bench::random_point(x, generator);
+
+    auto const observer = dual_annealing::any_of(
+        dual_annealing::target_value_t{options.target},
+        dual_annealing::time_budget_t{
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>{options.time_limit})});
+    auto const start = std::chrono::steady_clock::now();
+    auto const result =
+        set.local_search
+            ? dual_annealing::minimize(obj, x, set.params,
+                                       tcm::lbfgs::lbfgs_param_t{}, generator,
+                                       observer)
+            : dual_annealing::minimize(obj, x, set.params, generator,
+                                       observer);
+    auto const stop = std::chrono::steady_clock::now();
+    return record_t{
+        /*function=*/{},
+        /*dim=*/dim,
+        /*param_set=*/set.name,
+        /*seed=*/seed,
+        /*success=*/result.func <= options.target,
+        /*func=*/result.func,
+        /*wall_time=*/std::chrono::duration<double>(stop - start).count(),
+        /*num_f_evals=*/result.num_f_evals,
+        /*num_local_search_f_evals=*/result.num_local_search_f_evals,
+        /*num_iter=*/result.num_iter,
+        /*acceptance=*/result.acceptance};
+}
+
+auto run_one(std::string const& function, size_t const dim,
+             param_set_t const& set, size_t const seed,
+             options_t const& options) -> record_t
+{
+    auto record = [&]() {
+        if (function == "rastrigin") {
+            return run_one(bench::rastrigin_t{}, dim, set, seed, options);
+        }
+        if (function == "schwefel") {
+            return run_one(bench::schwefel_t{}, dim, set, seed, options);
+        }
+        if (function == "ackley") {
+            return run_one(bench::ackley_t{}, dim, set, seed, options);
+        }
+        if (function == "rosenbrock") {
+            return run_one(bench::rosenbrock_t{}, dim, set, seed, options);
+        }
+        throw std::invalid_argument{"unknown function: " + function};
+    }();
+    record.function = function;
+    return record;
+}
+
+auto write_csv(std::FILE* out, std::vector<record_t> const& records) -> void
+{
+    std::fprintf(out, "function,dim,param_set,seed,success,func,wall_time,"
+                      "num_f_evals,num_local_search_f_evals,num_iter,"
+                      "acceptance\n");
+    for (auto const& r : records) {
+        std::fprintf(out, "%s,%zu,%s,%zu,%d,%.9g,%.6f,%zu,%zu,%zu,%.6f\n",
+                     r.function.c_str(), r.dim, r.param_set.c_str(), r.seed,
+                     r.success ? 1 : 0, r.func, r.wall_time, r.num_f_evals,
+                     r.num_local_search_f_evals, r.num_iter, r.acceptance);
+    }
+}
+
+auto write_json(std::FILE* out, std::vector<record_t> const& records,
+                options_t const& options) -> void
+{
+    std::fprintf(out, "{\n  \"target\": %.9g,\n  \"time_limit\": %.6f,\n"
+                      "  \"runs\": [",
+                 options.target, options.time_limit);
+    for (auto i = size_t{0}; i < records.size(); ++i) {
+        auto const& r = records[i];
+        std::fprintf(
+            out,
+            "%s\n    {\"function\": \"%s\", \"dim\": %zu, "
+            "\"param_set\": \"%s\", \"seed\": %zu, \"success\": %s, "
+            "\"func\": %.9g, \"wall_time\": %.6f, \"num_f_evals\": %zu, "
+            "\"num_local_search_f_evals\": %zu, \"num_iter\": %zu, "
+            "\"acceptance\": %.6f}",
+            i == 0 ? "" : ",", r.function.c_str(), r.dim,
+            r.param_set.c_str(), r.seed, r.success ? "true" : "false",
+            r.func, r.wall_time, r.num_f_evals, r.num_local_search_f_evals,
+            r.num_iter, r.acceptance);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+/// Prints success rate and medians over the runs [first, last) of one cell.
+auto print_summary(record_t const* first, record_t const* last) -> void
+{
+    auto const n     = static_cast<size_t>(last - first);
+    auto       times = std::vector<double>{};
+    auto       evals = std::vector<size_t>{};
+    for (auto const* r = first; r != last; ++r) {
+        if (r->success) {
+            times.push_back(r->wall_time);
+            evals.push_back(r->num_f_evals);
+        }
+    }
+    std::fprintf(stderr, "%-12s %4zu %-16s %3zu/%-3zu", first->function.c_str(),
+                 first->dim, first->param_set.c_str(), times.size(), n);
+    if (times.empty()) {
+        std::fprintf(stderr, "%12s %12s\n", "-", "-");
+        return;
+    }
+    std::sort(times.begin(), times.end());
+    std::sort(evals.begin(), evals.end());
+    std::fprintf(stderr, "%12.4f %12zu\n", times[times.size() / 2],
+                 evals[evals.size() / 2]);
+}
+
+template <class T, class Parse>
+auto split(char const* list, Parse parse) -> std::vector<T>
+{
+    auto result = std::vector<T>{};
+    auto item   = std::string{};
+    for (auto const* p = list;; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!item.empty()) { result.push_back(parse(item)); }
+            item.clear();
+            if (*p == '\0') { break; }
+        }
+        else {
+            item.push_back(*p);
+        }
+    }
+    return result;
+}
+
+auto usage(char const* name) -> void
+{
+    std::fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "  --functions LIST   rastrigin,schwefel,ackley,rosenbrock\n"
+        "  --dims LIST        Dimensions, e.g. 2,10\n"
+        "  --params LIST      default,no_local_search,restarts,adaptive\n"
+        "  --seeds N          Number of seeds per cell\n"
+        "  --target F         Success threshold on the function value\n"
+        "  --time-limit S     Wall-clock budget per run in seconds\n"
+        "  --num-iter N       Maximal number of iterations per run\n"
+        "  --format csv|json  Format of the per-run records\n"
+        "  --output PATH      Where records go (default: stdout)\n",
+        name);
+}
+
+auto parse_options(int argc, char** argv) -> std::optional<options_t>
+{
+    auto const to_string = [](std::string const& s) { return s; };
+    auto const to_size   = [](std::string const& s) {
+        return static_cast<size_t>(std::stoul(s));
+    };
+    auto options = options_t{};
+    for (auto i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--help") == 0) { return std::nullopt; }
+        if (i + 1 == argc) {
+            throw std::invalid_argument{std::string{"missing value of "}
+                                        + argv[i]};
+        }
+        auto const* key   = argv[i];
+        auto const* value = argv[++i];
+        if (std::strcmp(key, "--functions") == 0) {
+            options.functions = split<std::string>(value, to_string);
+        }
+        else if (std::strcmp(key, "--dims") == 0) {
+            options.dims = split<size_t>(value, to_size);
+        }
+        else if (std::strcmp(key, "--params") == 0) {
+            options.param_sets = split<std::string>(value, to_string);
+        }
+        else if (std::strcmp(key, "--seeds") == 0) {
+            options.num_seeds = to_size(value);
+        }
+        else if (std::strcmp(key, "--target") == 0) {
+            options.target = std::stod(value);
+        }
+        else if (std::strcmp(key, "--time-limit") == 0) {
+            options.time_limit = std::stod(value);
+        }
+        else if (std::strcmp(key, "--num-iter") == 0) {
+            options.num_iter = to_size(value);
+        }
+        else if (std::strcmp(key, "--format") == 0) {
+            if (std::strcmp(value, "csv") == 0) {
+                options.format = format_t::csv;
+            }
+            else if (std::strcmp(value, "json") == 0) {
+                options.format = format_t::json;
+            }
+            else {
+                throw std::invalid_argument{
+                    std::string{"unknown format: "} + value};
+            }
+        }
+        else if (std::strcmp(key, "--output") == 0) {
+            options.output = value;
+        }
+        else {
+            throw std::invalid_argument{std::string{"unknown option: "}
+                                        + key};
+        }
+    }
+    return options;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto options = std::optional<options_t>{};
+    try {
+        options = parse_options(argc, argv);
+    }
+    catch (std::exception const& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!options.has_value()) {
+        usage(argv[0]);
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<record_t> records;
+    std::fprintf(stderr, "%-12s %4s %-16s %7s %12s %12s\n", "function", "dim",
+                 "params", "success", "median_time", "median_evals");
+    try {
+        for (auto const& function : options->functions) {
+            for (auto const dim : options->dims) {
+                for (auto const& name : options->param_sets) {
+                    auto const set = make_param_set(name, options->num_iter);
+                    auto const first = records.size();
+                    for (auto seed = size_t{0}; seed < options->num_seeds;
+                         ++seed) {
+                        records.push_back(
+                            run_one(function, dim, set, seed, *options));
+                    }
+                    if (records.size() != first) {
+                        print_summary(records.data() + first,
+                                      records.data() + records.size());
+                    }
+                }
+            }
+        }
+    }
+    catch (std::exception const& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    auto* out = options->output.empty()
+                    ? stdout
+                    : std::fopen(options->output.c_str(), "w");
+    if (out == nullptr) {
+        std::fprintf(stderr, "failed to open '%s'\n", options->output.c_str());
+        return EXIT_FAILURE;
+    }
+    if (options->format == format_t::csv) {
+        write_csv(out, records);
+    }
+    else {
+        write_json(out, records, *options);
+    }
+    if (out != stdout) { std::fclose(out); }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "streams.hpp"
+#include "tsallis_distribution.hpp"
+
+#include <benchmark/benchmark.h>
+#include <pcg_random.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+constexpr auto q_V = 2.62f;
+constexpr auto t_V = 1.0f;
+
+/// Drawing single numbers from the 1D distribution.
+auto bm_tsallis_scalar(benchmark::State& state) -> void
+{
+    pcg32                                  generator{1230045};
+    dual_annealing::tsallis_distribution_t dist{q_V, t_V};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dist(generator));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(bm_tsallis_scalar);
+
+/// Drawing D-dimensional vectors via #tsallis_distribution_t::many.
+auto bm_tsallis_many(benchmark::State& state) -> void
+{
+    auto const                             dim = static_cast<size_t>(state.range(0));
+    pcg32                                  generator{1230045};
+    dual_annealing::tsallis_distribution_t dist{q_V, t_V};
+    std::vector<float>                     out(dim);
+    for (auto _ : state) {
+        auto sample = dist.many(generator);
+        for (auto& x : out) {
+            x = sample();
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(dim));
+}
+BENCHMARK(bm_tsallis_many)->RangeMultiplier(8)->Range(2, 1 << 15);
+
+/// Drawing D-dimensional vectors via #tsallis_distribution_t::fill.
+template <class Generator> auto bm_tsallis_fill(benchmark::State& state) -> void
+{
+    auto const                             dim = static_cast<size_t>(state.range(0));
+    Generator                              generator{1230045};
+    dual_annealing::tsallis_distribution_t dist{q_V, t_V};
+    std::vector<float>                     out(dim);
+    for (auto _ : state) {
+        dist.fill(generator, out);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations())
+                            * static_cast<int64_t>(dim));
+}
+BENCHMARK_TEMPLATE(bm_tsallis_fill, pcg32)
+    ->RangeMultiplier(8)
+    ->Range(2, 1 << 15);
+BENCHMARK_TEMPLATE(bm_tsallis_fill, dual_annealing::philox4x32_t)
+    ->RangeMultiplier(8)
+    ->Range(2, 1 << 15);
+} // namespace
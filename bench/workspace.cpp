@@ -0,0 +1,99 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "buffers.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+
+namespace {
+/// Steady state of #thread_local_workspace: the buffers are already large
+/// enough, so this measures the lookup only.
+auto bm_thread_local_workspace(benchmark::State& state) -> void
+{
+    auto const dim = static_cast<size_t>(state.range(0));
+    benchmark::DoNotOptimize(dual_annealing::thread_local_workspace(dim));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dual_annealing::thread_local_workspace(dim));
+    }
+}
+BENCHMARK(bm_thread_local_workspace)->RangeMultiplier(32)->Range(2, 1 << 20);
+
+/// Alternating between two sizes of #thread_local_workspace. Shrinking never
+/// reallocates, so this measures what we pay on top of the lookup.
+auto bm_thread_local_workspace_alternating(benchmark::State& state) -> void
+{
+    auto const dim = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            dual_annealing::thread_local_workspace(dim / 2));
+        benchmark::DoNotOptimize(dual_annealing::thread_local_workspace(dim));
+    }
+}
+BENCHMARK(bm_thread_local_workspace_alternating)
+    ->RangeMultiplier(32)
+    ->Range(2, 1 << 20);
+
+/// #sa_buffers_t::resize to a size which fits into existing capacity.
+auto bm_buffers_resize(benchmark::State& state) -> void
+{
+    auto const                   dim = static_cast<size_t>(state.range(0));
+    dual_annealing::sa_buffers_t buffers{dim};
+    for (auto _ : state) {
+        buffers.resize(dim);
+        benchmark::DoNotOptimize(buffers.workspace());
+    }
+}
+BENCHMARK(bm_buffers_resize)->RangeMultiplier(32)->Range(2, 1 << 20);
+
+/// #sa_buffers_t::resize which has to allocate new memory every time.
+auto bm_buffers_resize_grow(benchmark::State& state) -> void
+{
+    auto const dim = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        dual_annealing::sa_buffers_t buffers;
+        buffers.resize(dim);
+        benchmark::DoNotOptimize(buffers.workspace());
+    }
+}
+BENCHMARK(bm_buffers_resize_grow)->RangeMultiplier(32)->Range(2, 1 << 20);
+
+/// Leasing buffers from a #workspace_pool_t and returning them, i.e. the
+/// overhead #minimize pays per call.
+auto bm_pool_acquire(benchmark::State& state) -> void
+{
+    auto const                       dim = static_cast<size_t>(state.range(0));
+    dual_annealing::workspace_pool_t pool;
+    for (auto _ : state) {
+        auto lease = pool.acquire(dim);
+        benchmark::DoNotOptimize(lease.workspace());
+    }
+}
+BENCHMARK(bm_pool_acquire)->RangeMultiplier(32)->Range(2, 1 << 20);
+} // namespace
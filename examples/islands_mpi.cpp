@@ -0,0 +1,89 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "islands.hpp"
+#include "mpi_transport.hpp"
+#include "separable.hpp"
+#include <pcg_random.hpp>
+
+#include <mpi.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/// Rastrigin function written as a sum of per-coordinate terms.
+struct rastrigin_terms_t {
+    static constexpr auto        A = 10.0;
+    dual_annealing::box_bounds_t _bounds{100, -5.12f, 5.12f};
+
+    auto term(size_t /*unused*/, float const x) const -> double
+    {
+        auto const a = static_cast<double>(x);
+        return A + a * a - A * std::cos(2.0 * M_PI * a);
+    }
+
+    auto bounds() const -> dual_annealing::box_bounds_t const&
+    {
+        return _bounds;
+    }
+};
+
+// Run with e.g. `mpirun -np 4 ex_6`
+int main(int argc, char* argv[])
+{
+    MPI_Init(&argc, &argv);
+    {
+        auto const params = dual_annealing::param_t{/*q_V=*/2.67,
+                                                    /*q_A=*/-5.0,
+                                                    /*t_0=*/5230.0,
+                                                    /*num_iter=*/1000,
+                                                    /*patience=*/100};
+        auto island_params               = dual_annealing::island_param_t{};
+        island_params.migration_interval = 20;
+        island_params.topology = dual_annealing::migration_topology_t::ring;
+
+        auto energy_fn = dual_annealing::make_separable(rastrigin_terms_t{});
+        dual_annealing::mpi_transport_t transport{MPI_COMM_WORLD, 100};
+        // Every island needs its own stream of random numbers
+        pcg32 generator{1230045, transport.rank()};
+        std::vector<float> xs(100, 3.0f);
+
+        auto const result = dual_annealing::minimize_islands(
+            energy_fn, xs, params, island_params, generator, transport);
+        std::printf("island %zu: local best %g, sent %zu, received %zu\n",
+                    transport.rank(), result.island.func,
+                    result.num_emigrants, result.num_immigrants);
+        if (transport.rank() == 0) {
+            std::printf("global best: %g\n", result.func);
+        }
+    }
+    MPI_Finalize();
+    return EXIT_SUCCESS;
+}
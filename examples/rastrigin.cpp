@@ -27,6 +27,7 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "chain.hpp"
+#include "separable.hpp"
 #include <pcg_random.hpp>
 
 #include <algorithm>
@@ -38,62 +39,27 @@
 #include <iterator>
 #include <random>
 
-struct to_range_t {
-    float min;
-    float max;
+/// Rastrigin function written as a sum of per-coordinate terms.
+struct rastrigin_terms_t {
+    static constexpr auto        A = 10.0;
+    dual_annealing::box_bounds_t _bounds{100, -5.12f, 5.12f};
 
-    auto operator()(float const x) const -> float
+    auto term(size_t /*unused*/, float const x) const -> double
     {
-        auto const length = max - min;
-        auto const delta =
-            std::fmod(std::fmod(x - min, length) + length, length);
-        return min + delta;
+        auto const a = static_cast<double>(x);
+        return A + a * a - A * std::cos(2.0 * M_PI * a);
     }
-};
-
-struct rastrigin_t {
-    to_range_t _wrap{-5.12f, 5.12f};
 
-    auto value(gsl::span<float const> x) const -> float
+    auto derivative(size_t /*unused*/, float const x) const -> double
     {
-        constexpr auto A = 10.0;
-        auto           E = 0.0;
-        for (auto i = size_t{0}; i < x.size(); ++i) {
-            auto const a = static_cast<double>(x[i]);
-            E += a * a - A * std::cos(2.0 * M_PI * a);
-        }
-        E += A * x.size();
-        return E;
+        auto const a = static_cast<double>(x);
+        return 2.0 * a + 2.0 * M_PI * A * std::sin(2.0 * M_PI * a);
     }
 
-    auto wrap(float const x) const -> float { return _wrap(x); }
-
-    auto value_and_gradient(gsl::span<float const> x, gsl::span<float> g) const
-        -> double
-    {
-        constexpr auto A = 10.0;
-        for (auto i = size_t{0}; i < x.size(); ++i) {
-            auto const a = static_cast<double>(x[i]);
-            g[i]         = static_cast<float>(
-                2 * a + 2 * M_PI * A * std::sin(2.0 * M_PI * a));
-        }
-        return value(x);
-    }
-#if 0
-    auto operator()(size_t const i, float const x, float const value,
-                    gsl::span<float const> xs) const -> float
+    auto bounds() const -> dual_annealing::box_bounds_t const&
     {
-        auto const shift = 0.0f;
-        auto       E     = value;
-        E -=
-            std::pow(xs[i] - shift, 2.0f)
-            - 10.0f
-                  * std::cos(2.0f * static_cast<float>(M_PI) * (xs[i] - shift));
-        E += std::pow(x - shift, 2.0f)
-             - 10.0f * std::cos(2.0f * static_cast<float>(M_PI) * (x - shift));
-        return E;
+        return _bounds;
     }
-#endif
 };
 
 int main(int argc, char* argv[])
@@ -113,7 +79,7 @@ int main(int argc, char* argv[])
                                                 /*patience=*/20};
 
     pcg32 generator{1230045};
-    auto  energy_fn = rastrigin_t{};
+    auto  energy_fn = dual_annealing::make_separable(rastrigin_terms_t{});
 
     std::vector<float> xs(100);
     for (auto& x : xs) {
@@ -0,0 +1,107 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "parallel.hpp"
+#include "streams.hpp"
+#include <pcg_random.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+struct rastrigin_t {
+    auto value(gsl::span<float const> x) const -> double
+    {
+        constexpr auto A = 10.0;
+        auto           E = A * static_cast<double>(x.size());
+        for (auto const y : x) {
+            auto const a = static_cast<double>(y);
+            E += a * a - A * std::cos(2.0 * M_PI * a);
+        }
+        return E;
+    }
+
+    auto wrap(float const x) const -> float
+    {
+        constexpr auto min = -5.12f;
+        constexpr auto max = 5.12f;
+        auto const     length = max - min;
+        return min + std::fmod(std::fmod(x - min, length) + length, length);
+    }
+};
+} // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+    if (argc != 3) {
+        std::fprintf(stderr, "Usage: %s <number_chains> <number_threads>\n",
+                     argv[0]);
+        return EXIT_FAILURE;
+    }
+    auto const num_chains  = static_cast<size_t>(std::atol(argv[1]));
+    auto const num_threads = static_cast<size_t>(std::atol(argv[2]));
+
+    constexpr auto dim    = size_t{20};
+    auto const     params = dual_annealing::param_t{/*q_V=*/2.67,
+                                                /*q_A=*/-5.0,
+                                                /*t_0=*/10.0,
+                                                /*num_iter=*/500,
+                                                /*patience=*/500};
+
+    // Each chain starts from its own random point
+    pcg32              generator{1230045};
+    std::vector<float> starting_points(num_chains * dim);
+    for (auto& x : starting_points) {
+        x = std::uniform_real_distribution<float>{-5.12f, 5.12f}(generator);
+    }
+
+    dual_annealing::thread_pool_t pool{num_threads};
+    std::vector<float>            xs(dim);
+    auto const start  = std::chrono::steady_clock::now();
+    auto const result = dual_annealing::minimize_parallel(
+        rastrigin_t{}, xs, starting_points, params,
+        dual_annealing::stream_factory_t<>{1230045}, pool);
+    auto const stop = std::chrono::steady_clock::now();
+
+    for (auto i = size_t{0}; i < result.chains.size(); ++i) {
+        std::printf("chain %3zu: func=%.5e, num_f_evals=%zu, acceptance=%.3f\n",
+                    i, result.chains[i].func, result.chains[i].num_f_evals,
+                    result.chains[i].acceptance);
+    }
+    std::printf("best: chain %zu with func=%.5e\n", result.best_chain,
+                result.best.func);
+    std::printf(
+        "wall time: %.3fs on %zu threads\n",
+        std::chrono::duration<double>(stop - start).count(),
+        pool.num_threads());
+    return EXIT_SUCCESS;
+}
@@ -1,10 +1,14 @@
 #include "tsallis_distribution.hpp"
 #include <pcg_random.hpp>
 
+#include <algorithm>
 #include <cerrno>
+#include <cmath>
 #include <charconv>
 #include <cstdio>
+#include <memory>
 #include <string>
+#include <vector>
 
 using file_handler_t = std::unique_ptr<std::FILE, void (*)(std::FILE*)>;
 
@@ -25,12 +29,14 @@ auto open_output_file(std::string const& filename) -> file_handler_t
     return file_handler_t{fp, [](auto* p) { std::fclose(p); }};
 }
 
-/// Reads q_V, t_V, and output file from `argv`.
+/// Reads q_V, t_V, output file, and optionally the dimension used for the
+/// batched sampler from `argv`.
 auto parse_arguments(int argc, char* argv[])
-    -> std::tuple<float, float, file_handler_t>
+    -> std::tuple<float, float, file_handler_t, size_t>
 {
-    if (argc != 4) {
-        std::fprintf(stderr, "Usage: %s <q_V> <t_V> <filename>\n", argv[0]);
+    if (argc != 4 && argc != 5) {
+        std::fprintf(stderr, "Usage: %s <q_V> <t_V> <filename> [<dim>]\n",
+                     argv[0]);
         std::exit(1);
     }
     auto const read_real = [](auto* s) {
@@ -45,13 +51,19 @@ auto parse_arguments(int argc, char* argv[])
     auto const q_V = read_real(argv[1]);
     auto const t_V = read_real(argv[2]);
     auto       out = open_output_file(argv[3]);
-    return {q_V, t_V, std::move(out)};
+    auto const dim = argc == 5 ? std::strtoul(argv[4], nullptr, 10) : 10UL;
+    if (dim == 0) {
+        std::fprintf(stderr, "Invalid dim: %s; expected a positive integer\n",
+                     argv[4]);
+        std::exit(1);
+    }
+    return {q_V, t_V, std::move(out), dim};
 }
 } // namespace
 
 auto main(int argc, char* argv[]) -> int
 {
-    auto [q_V, t_V, out] = parse_arguments(argc, argv);
+    auto [q_V, t_V, out, dim] = parse_arguments(argc, argv);
     if (q_V <= 1.0f || q_V >= 3.0f) {
         std::fprintf(stderr, "Invalid q_V: %f; expected 1.0 < q_V < 3.0\n",
                      static_cast<double>(q_V));
@@ -74,23 +86,62 @@ auto main(int argc, char* argv[]) -> int
     constexpr auto max         = 100.0;
     constexpr auto bin_size    = (max - min) / static_cast<double>(number_bins);
     std::vector<size_t> bins(number_bins, size_t{0});
-    auto const          process_sample = [&bins](auto const x) {
+    std::vector<size_t> bins_batched(number_bins, size_t{0});
+    auto const process_sample = [](auto& histogram, auto const x) {
         if (x < min || x > max) { return; }
-        ++bins[static_cast<size_t>((x - min) / bin_size)];
+        ++histogram[static_cast<size_t>((x - min) / bin_size)];
     };
     constexpr auto number_samples = size_t{1000000};
 
     for (auto i = size_t{0}; i < number_samples; ++i) {
-        process_sample(generate_sample());
+        process_sample(bins, generate_sample());
+    }
+
+    // Every coordinate of a D-dimensional Tsallis vector follows the 1D
+    // Tsallis distribution with the same q_V and t_V, so the histogram of all
+    // coordinates produced by `fill` must match `exact<1>()` as well.
+    std::vector<float> buffer(dim);
+    auto const number_batched_samples = (number_samples / dim) * dim;
+    for (auto i = size_t{0}; i < number_batched_samples; i += dim) {
+        dist.fill(generator, buffer);
+        for (auto const x : buffer) {
+            process_sample(bins_batched, static_cast<double>(x));
+        }
     }
 
+    // Columns: x, log of the histogram from operator(), log of the exact
+    // density, log of the histogram from fill().
     auto exact = [p = dist.exact<1>()](auto const x) { return std::log(p(x)); };
+    auto l1_distance  = 0.0;
+    auto l1_reference = 0.0;
     for (auto i = size_t{0}; i < number_bins; ++i) {
         auto const x = min + bin_size * (static_cast<double>(i) + 0.5);
-        std::fprintf(out.get(), "%.5e\t%.5e\t%.5e\n", x,
-                     std::log(static_cast<double>(bins[i])
-                              / static_cast<double>(number_samples)),
-                     exact(x));
+        auto const p = static_cast<double>(bins[i])
+                       / static_cast<double>(number_samples);
+        auto const p_batched = static_cast<double>(bins_batched[i])
+                               / static_cast<double>(number_batched_samples);
+        std::fprintf(out.get(), "%.5e\t%.5e\t%.5e\t%.5e\n", x, std::log(p),
+                     exact(x), std::log(p_batched));
+        l1_distance += std::abs(p_batched - bin_size * std::exp(exact(x)));
+        l1_reference += std::abs(p - bin_size * std::exp(exact(x)));
+    }
+    std::fprintf(stderr, "L1 distance between fill() and exact(): %.5e\n",
+                 l1_distance);
+    // Binning makes both distances non-zero even for perfect samplers, so
+    // fill() is compared against how well operator() does. Coordinates of
+    // one vector are correlated (they share its length), which makes the
+    // histogram of fill() noisier for larger dim. The tolerance is about
+    // twice the largest excess seen for correct samplers, and a 10% error in
+    // the scale of fill() exceeds it for the default dim.
+    auto const tolerance =
+        0.005
+        * std::sqrt(static_cast<double>(std::max(dim, size_t{10})) / 10.0);
+    if (l1_distance > l1_reference + tolerance) {
+        std::fprintf(stderr,
+                     "fill() is off: L1 distance of operator() is only "
+                     "%.5e\n",
+                     l1_reference);
+        return 1;
     }
     return 0;
 }
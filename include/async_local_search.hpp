@@ -0,0 +1,372 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "chain.hpp"
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+#include <lbfgs/lbfgs.hpp>
+
+#include <algorithm>          // std::fill
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // size_t
+#include <cstdint>            // std::uint64_t
+#include <cstring>            // std::memcpy
+#include <exception>          // std::exception_ptr, std::rethrow_exception
+#include <limits>             // std::numeric_limits
+#include <mutex>              // std::mutex, std::unique_lock
+#include <optional>           // std::optional
+#include <thread>             // std::thread
+#include <utility>            // std::move, std::exchange
+#include <vector>             // std::vector
+
+DA_NAMESPACE_BEGIN
+
+/// Parameters of the asynchronous local search, see the #minimize overload at
+/// the bottom of this file.
+struct async_local_search_param_t {
+    tcm::lbfgs::lbfgs_param_t lbfgs; ///< Parameters of L-BFGS
+    /// Whether refined points also replace the current point of the chain
+    /// (if they are better than it), or only the best one.
+    bool replace_current = true;
+};
+
+/// \brief Runs L-BFGS on a background thread.
+///
+/// There is at most one job at a time. Submitting a new candidate while a job
+/// is running cancels it: the cancelled L-BFGS run sees a zero gradient on its
+/// next evaluation and terminates right away, and its result is discarded.
+///
+/// \p Objective is copied into the worker, so the objective used by the
+/// chain and the one used by the local search never share state. Exceptions
+/// thrown by the objective on the worker are re-thrown by the next call to
+/// #try_take or #wait.
+template <class Objective> class async_local_search_t {
+    Objective                 _obj;
+    tcm::lbfgs::lbfgs_param_t _params;
+
+    std::mutex              _mutex;
+    std::condition_variable _job_cv;  ///< Signals new jobs and #_stop
+    std::condition_variable _done_cv; ///< Signals the end of a job
+
+    // All of the following are protected by #_mutex.
+    std::vector<float> _job_x;       ///< Candidate of the next job
+    double             _job_func;    ///< Function value at #_job_x
+    std::uint64_t      _job_id;      ///< Id of the most recent submission
+    bool               _has_job;     ///< Whether #_job_x is waiting
+    bool               _busy;        ///< Whether the worker is running L-BFGS
+    std::vector<float> _result_x;    ///< Refined point of the last job
+    double             _result_func; ///< Function value at #_result_x
+    bool               _has_result;  ///< Whether #_result_x is unclaimed
+    size_t             _num_f_evals; ///< Evaluations of finished jobs
+    std::exception_ptr _error;       ///< Exception thrown by the last job
+    bool               _stop;
+
+    std::atomic<bool> _cancel; ///< Whether the running job is stale
+    std::thread       _worker;
+
+    auto run() -> void
+    {
+        // Only accessed by the worker
+        auto x = std::vector<float>(_job_x.size());
+        for (;;) {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _job_cv.wait(lock, [this]() { return _stop || _has_job; });
+            if (_stop) { return; }
+            x.swap(_job_x);
+            auto const id         = _job_id;
+            auto const start_func = _job_func;
+            _has_job              = false;
+            _busy                 = true;
+            _cancel.store(false, std::memory_order_relaxed);
+            lock.unlock();
+
+            auto num_f_evals = size_t{0};
+            auto last_func   = start_func;
+            auto status      = tcm::lbfgs::status_t::success;
+            auto func        = start_func;
+            auto error       = std::exception_ptr{};
+            try {
+                auto const r = tcm::lbfgs::minimize(
+                    [this, &num_f_evals, &last_func](gsl::span<float const> y,
+                                                     gsl::span<float> g) {
+                        if (_cancel.load(std::memory_order_relaxed)) {
+                            // A zero gradient makes L-BFGS stop immediately
+                            std::fill(g.begin(), g.end(), 0.0f);
+                            return last_func;
+                        }
+                        num_f_evals += detail::gradient_cost(_obj, y.size());
+                        last_func = detail::do_value_and_gradient(_obj, y, g);
+                        return last_func;
+                    },
+                    _params, gsl::span<float>{x});
+                status = r.status;
+                func   = r.func;
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            _busy = false;
+            _num_f_evals += num_f_evals;
+            if (error != nullptr) {
+                _error = std::move(error);
+            }
+            // Results of cancelled jobs are dropped
+            else if (id == _job_id && !_cancel.load(std::memory_order_relaxed)
+                     && detail::is_useful_local_search(status, func,
+                                                       start_func)) {
+                _result_x.swap(x);
+                _result_func = func;
+                _has_result  = true;
+            }
+            lock.unlock();
+            _done_cv.notify_all();
+        }
+    }
+
+    /// Must be called with #_mutex held.
+    auto rethrow_if_failed() -> void
+    {
+        if (_error != nullptr) {
+            std::rethrow_exception(std::exchange(_error, nullptr));
+        }
+    }
+
+  public:
+    async_local_search_t(Objective obj, tcm::lbfgs::lbfgs_param_t const& params,
+                         size_t const dim)
+        : _obj{std::move(obj)}
+        , _params{params}
+        , _mutex{}
+        , _job_cv{}
+        , _done_cv{}
+        , _job_x(dim)
+        , _job_func{std::numeric_limits<double>::quiet_NaN()}
+        , _job_id{0}
+        , _has_job{false}
+        , _busy{false}
+        , _result_x(dim)
+        , _result_func{std::numeric_limits<double>::quiet_NaN()}
+        , _has_result{false}
+        , _num_f_evals{0}
+        , _error{}
+        , _stop{false}
+        , _cancel{false}
+        , _worker{}
+    {
+        _worker = std::thread{[this]() { run(); }};
+    }
+
+    async_local_search_t(async_local_search_t const&) = delete;
+    async_local_search_t(async_local_search_t&&)      = delete;
+    auto operator=(async_local_search_t const&)
+        -> async_local_search_t& = delete;
+    auto operator=(async_local_search_t&&) -> async_local_search_t& = delete;
+
+    ~async_local_search_t() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _stop = true;
+            _cancel.store(true, std::memory_order_relaxed);
+        }
+        _job_cv.notify_one();
+        _worker.join();
+    }
+
+    /// \brief Schedules a local search starting at \p x where the objective
+    /// equals \p func.
+    ///
+    /// A job which is still waiting or running is superseded, and any
+    /// unclaimed result is discarded since \p func is better than it.
+    auto submit(gsl::span<float const> x, double const func) -> void
+    {
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            DUAL_ANNEALING_ASSERT(x.size() == _job_x.size(),
+                                  "incompatible dimensions");
+            std::memcpy(_job_x.data(), x.data(), x.size() * sizeof(float));
+            _job_func = func;
+            ++_job_id;
+            _has_job = true;
+            if (_has_result && _result_func >= func) { _has_result = false; }
+            if (_busy) { _cancel.store(true, std::memory_order_relaxed); }
+        }
+        _job_cv.notify_one();
+    }
+
+    /// \brief Copies the refined point of a finished job into \p x.
+    ///
+    /// Returns its function value, or `std::nullopt` if there is no new
+    /// result. Never blocks for longer than it takes to copy the point.
+    auto try_take(gsl::span<float> x) -> std::optional<double>
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        rethrow_if_failed();
+        if (!_has_result) { return std::nullopt; }
+        std::memcpy(x.data(), _result_x.data(), x.size() * sizeof(float));
+        _has_result = false;
+        return _result_func;
+    }
+
+    /// Blocks until all submitted jobs have finished.
+    auto wait() -> void
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _done_cv.wait(lock, [this]() { return !_busy && !_has_job; });
+        rethrow_if_failed();
+    }
+
+    /// \brief Drops the waiting job and cancels the running one.
+    ///
+    /// Use it before #wait when the result is no longer needed, e.g. because
+    /// the observer stopped the minimisation: #wait then only blocks until
+    /// the running job notices the cancellation.
+    auto cancel() -> void
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _has_job = false;
+        if (_busy) { _cancel.store(true, std::memory_order_relaxed); }
+    }
+
+    /// Number of evaluations of the objective by jobs which have finished.
+    auto num_f_evals() -> size_t
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        return _num_f_evals;
+    }
+};
+
+namespace detail {
+template <class Objective, class Generator, class Workspace, class Observer>
+auto minimize_async_in(
+    Objective&& obj, gsl::span<float> x, param_t const& parameters,
+    async_local_search_param_t const& local_search_parameters,
+    Generator& generator, Workspace& workspace, Observer&& observer)
+    -> result_t
+{
+    using objective_type = unwrap_reference_t<Objective>;
+    std::memcpy(workspace.current.x.data(), x.data(),
+                x.size() * sizeof(float));
+    sa_chain_t<Objective&, Generator, Workspace> chain{obj, workspace,
+                                                       parameters, generator};
+    async_local_search_t<objective_type> local_search{
+        unwrap(obj), local_search_parameters.lbfgs, x.size()};
+    auto refined = std::vector<float>(x.size());
+    // Tries to merge the result of a finished local search into the chain.
+    // Returns whether `best` improved.
+    auto const merge = [&]() {
+        if (auto const func = local_search.try_take(refined);
+            func.has_value()) {
+            return chain.offer(refined, *func,
+                               local_search_parameters.replace_current);
+        }
+        return false;
+    };
+
+    // Evaluations of finished jobs are added to the chain as they come in,
+    // so that max_f_evals and observers see them.
+    auto       counted = size_t{0};
+    auto const account = [&]() {
+        auto const total = local_search.num_f_evals();
+        chain.add_local_search_f_evals(total - counted);
+        counted = total;
+    };
+
+    local_search.submit(workspace.current.x, workspace.current.func);
+    auto driver      = driver_state_t{parameters};
+    driver.best_seen = workspace.best.func;
+    auto stopped     = false;
+    while (chain.iteration() < parameters.num_iter && driver.patience != 0
+           && !out_of_budget(chain, parameters)) {
+        auto const accepted = chain.num_accepted();
+        chain();
+        // Points coming from the local search are already polished, so we
+        // don't submit them again.
+        auto const merged = merge();
+        account();
+        if (driver.update(parameters, workspace) && !merged) {
+            chain.sync_best();
+            local_search.submit(workspace.best.x, workspace.best.func);
+        }
+        maybe_reanneal(chain, parameters, driver, x.size(),
+                       chain.num_accepted() - accepted);
+        if (observe(chain, workspace, observer)) {
+            stopped = true;
+            break;
+        }
+    }
+    // A stopped run must not wait for a full L-BFGS run to finish, and
+    // neither must one which has used up its budget
+    if (stopped || out_of_budget(chain, parameters)) { local_search.cancel(); }
+    local_search.wait();
+    merge();
+    account();
+
+    chain.sync_best();
+    std::memcpy(x.data(), workspace.best.x.data(), x.size() * sizeof(float));
+    return make_result(chain, workspace, driver.num_restarts);
+}
+} // namespace detail
+
+/// \brief Same as #minimize with local search, except that L-BFGS runs on a
+/// separate thread while the chain keeps annealing.
+///
+/// Every improvement of the best point submits a new local search job,
+/// cancelling the previous one if it is still running. Refined points are
+/// merged back into the chain after each iteration (see
+/// #async_local_search_param_t::replace_current). Before returning, we wait
+/// for the last job to finish, unless the observer stopped the minimisation
+/// or `max_f_evals` is used up: then the last job is cancelled. Exceptions
+/// thrown by the objective during local search propagate to the caller.
+///
+/// Reannealing and `max_f_evals` work as for #minimize. Evaluations of the
+/// local search count towards `max_f_evals` once its job has finished.
+///
+/// \note This requires the objective to be copyable: the local search uses
+/// its own copy.
+template <class Objective, class Generator, class Observer = no_observer_t,
+          class = std::enable_if_t<is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, gsl::span<float> x, param_t const& parameters,
+         async_local_search_param_t const& local_search_parameters,
+         Generator& generator, Observer observer = {}) -> result_t
+{
+    auto lease     = thread_local_pool().acquire(x.size());
+    auto workspace = lease.workspace();
+    return detail::minimize_async_in(std::forward<Objective>(obj), x,
+                                     parameters, local_search_parameters,
+                                     generator, workspace, observer);
+}
+
+DA_NAMESPACE_END
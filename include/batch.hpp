@@ -0,0 +1,408 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include "assert.hpp"
+#include "chain.hpp"
+#include "config.hpp"
+#include "objective.hpp"
+#include "random.hpp"
+#include "tsallis_distribution.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>   // std::min, std::any_of
+#include <array>       // std::array
+#include <cstddef>     // size_t
+#include <cstring>     // std::memcpy
+#include <limits>      // std::numeric_limits
+#include <stdexcept>   // std::invalid_argument
+#include <string>      // std::string
+#include <type_traits> // std::remove_reference_t
+#include <vector>      // std::vector
+
+DA_NAMESPACE_BEGIN
+
+namespace detail {
+/// Number of problems which #minimize_batch anneals together by default: one
+/// per lane of a SIMD register of floats.
+#if defined(__AVX512F__)
+inline constexpr size_t default_tile_width = 16;
+#elif defined(__AVX__)
+inline constexpr size_t default_tile_width = 8;
+#else
+inline constexpr size_t default_tile_width = 4;
+#endif
+
+/// \brief Anneals a tile of `Width` independent problems in lock-step.
+///
+/// Points are stored coordinate-major (`x[j * Width + l]` is coordinate `j`
+/// of problem `l`), so every per-coordinate operation is a loop over lanes
+/// which the compiler can vectorise. Acceptance decisions are made
+/// lane-wise and applied with blends rather than branches.
+///
+/// Each lane follows the same algorithm as #sa_chain_t (without local search
+/// and batching of full visits), but the random number stream is shared, so
+/// results differ from calling #minimize once per problem.
+template <class Objective, class Generator, size_t Width>
+class batch_annealer_t {
+    static_assert(Width > 0, "tile width must be positive");
+
+    template <class T> using lanes_t = std::array<T, Width>;
+
+    Objective&             _obj;
+    Generator&             _generator;
+    param_t const&         _params;
+    size_t                 _dim;
+    tsallis_distribution_t _tsallis_dist;
+    acceptance_rule_t      _acceptance;
+    std::vector<float>     _current;  ///< `_dim x Width`
+    std::vector<float>     _proposed; ///< `_dim x Width`
+    std::vector<float>     _best;     ///< `_dim x Width`
+    std::vector<float>     _steps;    ///< Normal numbers, `_dim x Width`
+    /// Points transposed to rows for objectives without `value_soa`.
+    std::vector<float> _rows;
+    lanes_t<double>    _current_func;
+    lanes_t<double>    _proposed_func;
+    lanes_t<double>    _best_func;
+    lanes_t<double>    _patience_func; ///< Best value at the last reset
+    lanes_t<float>     _scales;
+    lanes_t<bool>      _accept;
+    lanes_t<bool>      _active; ///< Lanes which are still annealing
+    lanes_t<size_t>    _patience;
+    lanes_t<size_t>    _num_iter;
+    lanes_t<size_t>    _num_accepted;
+    lanes_t<size_t>    _num_f_evals;
+
+    static constexpr auto supports_soa =
+        has_value_soa_mem_fn_v<unwrap_reference_t<Objective>&>;
+    static constexpr auto supports_batching =
+        has_value_batch_mem_fn_v<unwrap_reference_t<Objective>&>;
+
+    /// Evaluates the objective at all lanes of \p tile.
+    auto evaluate(std::vector<float> const& tile, lanes_t<double>& out)
+        -> void
+    {
+        if constexpr (supports_soa) {
+            unwrap(_obj).value_soa(gsl::span<float const>{tile}, Width,
+                                   gsl::span<double>{out});
+        }
+        else {
+            for (auto l = size_t{0}; l < Width; ++l) {
+                // `value_batch` needs all rows to be valid points
+                if (!supports_batching && !_active[l]) { continue; }
+                auto* row = _rows.data() + l * _dim;
+                for (auto j = size_t{0}; j < _dim; ++j) {
+                    row[j] = tile[j * Width + l];
+                }
+            }
+            if constexpr (supports_batching) {
+                unwrap(_obj).value_batch(gsl::span<float const>{_rows}, Width,
+                                         gsl::span<double>{out});
+            }
+            else {
+                for (auto l = size_t{0}; l < Width; ++l) {
+                    if (!_active[l]) { continue; }
+                    out[l] = do_value(
+                        _obj, gsl::span<float const>{_rows.data() + l * _dim,
+                                                     _dim});
+                }
+            }
+        }
+        for (auto l = size_t{0}; l < Width; ++l) {
+            _num_f_evals[l] += _active[l] ? size_t{1} : size_t{0};
+        }
+    }
+
+    /// Decides lane-wise whether to accept `proposed`. Returns whether any
+    /// lane accepted.
+    auto decide(float const t_A) -> bool
+    {
+        auto any = false;
+        for (auto l = size_t{0}; l < Width; ++l) {
+            auto const dE =
+                static_cast<float>(_proposed_func[l] - _current_func[l]);
+            _accept[l] =
+                _active[l]
+                && (dE < 0.0f
+                    || _acceptance.accepts(uniform_float(_generator), dE,
+                                           t_A));
+            _num_accepted[l] += _accept[l] ? size_t{1} : size_t{0};
+            any = any || _accept[l];
+        }
+        return any;
+    }
+
+    /// Copies `current` into `best` for lanes which improved.
+    auto update_best() -> void
+    {
+        lanes_t<bool> improved;
+        auto          any = false;
+        for (auto l = size_t{0}; l < Width; ++l) {
+            improved[l] = _current_func[l] < _best_func[l];
+            any         = any || improved[l];
+        }
+        if (!any) { return; }
+        for (auto j = size_t{0}; j < _dim; ++j) {
+            auto const* c = _current.data() + j * Width;
+            auto*       b = _best.data() + j * Width;
+            for (auto l = size_t{0}; l < Width; ++l) {
+                b[l] = improved[l] ? c[l] : b[l];
+            }
+        }
+        for (auto l = size_t{0}; l < Width; ++l) {
+            _best_func[l] = improved[l] ? _current_func[l] : _best_func[l];
+        }
+    }
+
+    auto full_visits(float const t_A) -> void
+    {
+        for (auto v = size_t{0}; v < _dim; ++v) {
+            fill_normal(_generator, gsl::span<float>{_steps}, 1.0f);
+            for (auto& scale : _scales) {
+                scale = _tsallis_dist.scale(_generator);
+            }
+            for (auto j = size_t{0}; j < _dim; ++j) {
+                auto const* c = _current.data() + j * Width;
+                auto const* s = _steps.data() + j * Width;
+                auto*       p = _proposed.data() + j * Width;
+                for (auto l = size_t{0}; l < Width; ++l) {
+                    p[l] = do_wrap_one(_obj, j, c[l] + _scales[l] * s[l]);
+                }
+            }
+            evaluate(_proposed, _proposed_func);
+            if (!decide(t_A)) { continue; }
+            for (auto j = size_t{0}; j < _dim; ++j) {
+                auto const* p = _proposed.data() + j * Width;
+                auto*       c = _current.data() + j * Width;
+                for (auto l = size_t{0}; l < Width; ++l) {
+                    c[l] = _accept[l] ? p[l] : c[l];
+                }
+            }
+            for (auto l = size_t{0}; l < Width; ++l) {
+                _current_func[l] =
+                    _accept[l] ? _proposed_func[l] : _current_func[l];
+            }
+            update_best();
+        }
+    }
+
+    auto single_visits(float const t_A) -> void
+    {
+        // `proposed` equals `current` except for the coordinate being visited
+        std::memcpy(_proposed.data(), _current.data(),
+                    _current.size() * sizeof(float));
+        for (auto j = size_t{0}; j < _dim; ++j) {
+            auto* c = _current.data() + j * Width;
+            auto* p = _proposed.data() + j * Width;
+            for (auto l = size_t{0}; l < Width; ++l) {
+                p[l] =
+                    do_wrap_one(_obj, j, c[l] + _tsallis_dist(_generator));
+            }
+            evaluate(_proposed, _proposed_func);
+            decide(t_A);
+            for (auto l = size_t{0}; l < Width; ++l) {
+                c[l] = _accept[l] ? p[l] : c[l];
+                p[l] = c[l];
+                _current_func[l] =
+                    _accept[l] ? _proposed_func[l] : _current_func[l];
+            }
+            update_best();
+        }
+    }
+
+    /// Updates patience and iteration counters after an iteration.
+    auto finish_iteration() -> void
+    {
+        for (auto l = size_t{0}; l < Width; ++l) {
+            if (!_active[l]) { continue; }
+            ++_num_iter[l];
+            if (_best_func[l] < _patience_func[l]) {
+                _patience_func[l] = _best_func[l];
+                _patience[l]      = _params.patience;
+            }
+            else {
+                --_patience[l];
+            }
+            _active[l] = _patience[l] != 0 && _num_iter[l] < _params.num_iter
+                         && (_params.max_f_evals == 0
+                             || _num_f_evals[l] < _params.max_f_evals);
+        }
+    }
+
+  public:
+    batch_annealer_t(Objective& obj, Generator& generator,
+                     param_t const& params, size_t const dim)
+        : _obj{obj}
+        , _generator{generator}
+        , _params{params}
+        , _dim{dim}
+        // t_0 here is arbitrary since we update it every iteration anyway
+        , _tsallis_dist{params.q_V, params.t_0}
+        , _acceptance{params.q_A}
+        , _current(dim * Width)
+        , _proposed(dim * Width)
+        , _best(dim * Width)
+        , _steps(dim * Width)
+        , _rows(supports_soa ? 0 : dim * Width)
+        , _current_func{}
+        , _proposed_func{}
+        , _best_func{}
+        , _patience_func{}
+        , _scales{}
+        , _accept{}
+        , _active{}
+        , _patience{}
+        , _num_iter{}
+        , _num_accepted{}
+        , _num_f_evals{}
+    {}
+
+    /// \brief Minimises problems `[first, first + count)` of \p xs.
+    ///
+    /// `count <= Width`. Unused lanes are filled with copies of the first
+    /// problem and ignored.
+    auto operator()(gsl::span<float> xs, size_t const first, size_t const count,
+                    gsl::span<result_t> results) -> void
+    {
+        DUAL_ANNEALING_ASSERT(0 < count && count <= Width, "invalid count");
+        for (auto l = size_t{0}; l < Width; ++l) {
+            auto const* row = xs.data() + (first + (l < count ? l : 0)) * _dim;
+            for (auto j = size_t{0}; j < _dim; ++j) {
+                _current[j * Width + l] = row[j];
+            }
+            _active[l]       = l < count;
+            _patience[l]     = _params.patience;
+            _num_iter[l]     = 0;
+            _num_accepted[l] = 0;
+            _num_f_evals[l]  = 0;
+        }
+        evaluate(_current, _current_func);
+        _best      = _current;
+        _best_func = _current_func;
+        _patience_func.fill(std::numeric_limits<double>::infinity());
+        for (auto l = size_t{0}; l < Width; ++l) {
+            _active[l] = _active[l] && _params.patience != 0
+                         && _params.num_iter != 0;
+        }
+
+        for (auto i = size_t{0};
+             std::any_of(_active.begin(), _active.end(),
+                         [](auto const a) { return a; });
+             ++i) {
+            auto const visiting = visiting_param(_params, i);
+            auto const t_A = visiting.t_V() / static_cast<float>(i + 1);
+            _tsallis_dist.param(visiting);
+            full_visits(t_A);
+            single_visits(t_A);
+            finish_iteration();
+        }
+
+        for (auto l = size_t{0}; l < count; ++l) {
+            auto* row = xs.data() + (first + l) * _dim;
+            for (auto j = size_t{0}; j < _dim; ++j) {
+                row[j] = _best[j * Width + l];
+            }
+            results[first + l] = result_t{
+                /*func=*/_best_func[l],
+                /*num_iter=*/_num_iter[l],
+                /*num_f_evals=*/_num_f_evals[l],
+                /*acceptance=*/_num_iter[l] == 0
+                    ? std::numeric_limits<double>::quiet_NaN()
+                    : static_cast<double>(_num_accepted[l])
+                          / static_cast<double>(2U * _num_iter[l] * _dim),
+                /*num_local_search_f_evals=*/0,
+                /*num_restarts=*/0,
+                /*num_accepted=*/_num_accepted[l]};
+        }
+    }
+};
+
+/// \brief Throws `std::invalid_argument` if \p params uses features of
+/// #param_t which #batch_annealer_t doesn't implement.
+inline auto check_batch_params(param_t const& params, size_t const dim)
+    -> void
+{
+    auto const reject = [](char const* what) {
+        throw std::invalid_argument{std::string{"minimize_batch: "} + what
+                                    + " is not supported"};
+    };
+    if (params.batch_size > 1) { reject("batch_size > 1"); }
+    if (params.block_size != 0 && params.block_size < dim) {
+        reject("block_size < dim");
+    }
+    if (params.max_restarts != 0 || params.restart_temp_ratio != 0.0f
+        || params.min_acceptance != 0.0f) {
+        reject("reannealing");
+    }
+    if (params.target_acceptance != 0.0f) {
+        reject("adaptive visiting (target_acceptance)");
+    }
+}
+} // namespace detail
+
+/// \brief Minimises many independent problems of the same dimension.
+///
+/// \p xs contains `n = xs.size() / dim` starting points one after another.
+/// Upon return it contains the best points found, and the `i`'th element of
+/// the returned vector describes problem `i`.
+///
+/// Problems are annealed in tiles of \p Width in lock-step with state laid
+/// out as structure-of-arrays. This amortises the setup costs of #minimize
+/// and (if \p obj implements `value_soa`, see
+/// #detail::has_value_soa_mem_fn) allows the objective to vectorise across
+/// problems. Otherwise `value_batch` or `value` are used. The incremental
+/// evaluation protocol is not used, and there's no local search.
+///
+/// Of the optional fields of \p parameters, only #param_t::temperatures and
+/// #param_t::max_f_evals (per problem) are supported. Batching of full visits
+/// (`batch_size > 1`), block moves (`0 < block_size < dim`), reannealing and
+/// adaptive visiting throw `std::invalid_argument`.
+template <size_t Width = detail::default_tile_width, class Objective,
+          class Generator>
+DA_NOINLINE auto minimize_batch(Objective&& obj, gsl::span<float> xs,
+                                size_t const dim, param_t const& parameters,
+                                Generator& generator) -> std::vector<result_t>
+{
+    if (dim == 0 || xs.size() % dim != 0) {
+        throw std::invalid_argument{
+            "minimize_batch: size of `xs` is not a multiple of `dim`"};
+    }
+    detail::check_batch_params(parameters, dim);
+    auto const n       = xs.size() / dim;
+    auto       results = std::vector<result_t>(n);
+    detail::batch_annealer_t<std::remove_reference_t<Objective>, Generator,
+                             Width>
+        annealer{obj, generator, parameters, dim};
+    for (auto first = size_t{0}; first < n; first += Width) {
+        annealer(xs, first, std::min(Width, n - first), results);
+    }
+    return results;
+}
+
+DA_NAMESPACE_END
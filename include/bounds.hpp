@@ -0,0 +1,154 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "assert.hpp"
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cmath>   // std::abs
+#include <cstddef> // size_t
+#include <cstdint> // int32_t
+#include <vector>  // std::vector
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// What happens to points which leave the box, see #box_bounds_t.
+enum class boundary_t {
+    periodic,   ///< Opposite faces of the box are identified
+    reflecting, ///< Points are mirrored back into the box
+};
+
+namespace detail {
+/// `floor(t)` for `|t| <= 2^23`. Unlike `std::floor`, it compiles to
+/// conversions and a blend, which vectorise without SSE4.1.
+DA_FORCEINLINE auto floor_small(float const t) noexcept -> float
+{
+    auto const i = static_cast<float>(static_cast<std::int32_t>(t));
+    return i > t ? i - 1.0f : i;
+}
+
+/// Clamps \p t to `[-2^23, 2^23]` and maps NaN to `-2^23`. Floats outside
+/// this range are integers anyway, so the fractional part is unaffected.
+DA_FORCEINLINE auto clamp_small(float const t) noexcept -> float
+{
+    constexpr auto big = 8388608.0f; // 2^23
+    auto const     y   = !(t > -big) ? -big : t;
+    return y > big ? big : y;
+}
+
+/// Periodic wrap of \p x into `[lower, upper)`.
+DA_FORCEINLINE auto wrap_periodic(float const x, float const lower,
+                                  float const upper, float const length,
+                                  float const inv_length) noexcept -> float
+{
+    auto const t = clamp_small((x - lower) * inv_length);
+    auto const y = lower + (t - floor_small(t)) * length;
+    // `y` may round up to `upper`
+    return y < upper ? y : lower;
+}
+
+/// Reflection of \p x into `[lower, upper]`.
+DA_FORCEINLINE auto wrap_reflecting(float const x, float const lower,
+                                    float const upper, float const length,
+                                    float const inv_length) noexcept -> float
+{
+    auto const t = clamp_small((x - lower) * inv_length);
+    // Reflection has period 2 in units of `length`
+    auto const u = t - 2.0f * floor_small(0.5f * t);
+    auto const y = lower + (1.0f - std::abs(1.0f - u)) * length;
+    auto const z = y < lower ? lower : y;
+    return z > upper ? upper : z;
+}
+} // namespace detail
+
+/// \brief Axis-aligned box `[lower₀, upper₀] × ... × [lower_{D-1},
+/// upper_{D-1}]`.
+///
+/// Objectives which have a member function `bounds()` returning a
+/// #box_bounds_t (or something with the same `wrap` overloads) don't need to
+/// implement `wrap`: #sa_chain_t then uses #wrap(gsl::span<float>) const for
+/// full visits and #wrap(size_t, float) const for single-coordinate ones.
+/// Both are branch-free, and the former is vectorised.
+class box_bounds_t {
+    std::vector<float> _lower;
+    std::vector<float> _upper;
+    std::vector<float> _length;     ///< `upper - lower`
+    std::vector<float> _inv_length; ///< `1 / (upper - lower)`
+    boundary_t         _boundary;
+
+    auto init() -> void;
+
+  public:
+    /// \brief Creates the box `[lower, upper]`.
+    ///
+    /// \throws std::invalid_argument if \p lower and \p upper have different
+    /// sizes or if `lower[i] < upper[i]` does not hold for some `i`.
+    box_bounds_t(gsl::span<float const> lower, gsl::span<float const> upper,
+                 boundary_t boundary = boundary_t::periodic);
+
+    /// Creates the hypercube `[lower, upper]^dim`.
+    box_bounds_t(size_t dim, float lower, float upper,
+                 boundary_t boundary = boundary_t::periodic);
+
+    [[nodiscard]] auto dim() const noexcept -> size_t { return _lower.size(); }
+    [[nodiscard]] auto lower() const noexcept -> gsl::span<float const>
+    {
+        return _lower;
+    }
+    [[nodiscard]] auto upper() const noexcept -> gsl::span<float const>
+    {
+        return _upper;
+    }
+    [[nodiscard]] auto boundary() const noexcept -> boundary_t
+    {
+        return _boundary;
+    }
+
+    /// Returns whether \p x lies inside the box.
+    [[nodiscard]] auto contains(gsl::span<float const> x) const noexcept
+        -> bool;
+
+    /// Maps the \p i'th coordinate \p x into `[lower[i], upper[i]]`.
+    auto wrap(size_t const i, float const x) const noexcept -> float
+    {
+        DUAL_ANNEALING_ASSERT(i < dim(), "index out of bounds");
+        return _boundary == boundary_t::periodic
+                   ? detail::wrap_periodic(x, _lower[i], _upper[i],
+                                           _length[i], _inv_length[i])
+                   : detail::wrap_reflecting(x, _lower[i], _upper[i],
+                                             _length[i], _inv_length[i]);
+    }
+
+    /// Maps every coordinate of \p x into the box in-place.
+    auto wrap(gsl::span<float> x) const noexcept -> void;
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -3,10 +3,14 @@
 #include "assert.hpp"
 #include "config.hpp"
 #include <gsl/gsl-lite.hpp> // gsl::span
+#include <array>            // std::array
 #include <cstddef>          // size_t
+#include <limits>           // std::numeric_limits
 #include <cstring>          // std::memcpy
+#include <memory>           // std::unique_ptr
 #include <optional>         // std::optional
 #include <type_traits>      // std::aligned_storage
+#include <utility>          // std::move
 
 DUAL_ANNEALING_NAMESPACE_BEGIN
 
@@ -47,17 +51,64 @@ struct workspace_t {
     point_t best;
 };
 
+/// \brief Workspace for problems whose dimension is known at compile time.
+///
+/// Points live directly inside the object (i.e. on the stack when the
+/// workspace is a local variable), so no heap allocations or thread-local
+/// lookups are needed. Meant for small \p N: swapping two points copies
+/// `N` floats.
+template <size_t N> struct fixed_workspace_t {
+    static_assert(N > 0, "dimension must be positive");
+
+    struct point_t {
+        double                func = std::numeric_limits<double>::quiet_NaN();
+        std::array<float, N> x    = {};
+    };
+
+    point_t current;
+    point_t proposed;
+    point_t best;
+};
+
+namespace detail {
+inline constexpr size_t dynamic_extent = std::numeric_limits<size_t>::max();
+
+/// Dimension of points in \p Workspace if it's known at compile time and
+/// #dynamic_extent otherwise.
+template <class Workspace>
+struct workspace_extent : std::integral_constant<size_t, dynamic_extent> {};
+
+template <size_t N>
+struct workspace_extent<fixed_workspace_t<N>>
+    : std::integral_constant<size_t, N> {};
+
+template <class Workspace>
+inline constexpr size_t workspace_extent_v =
+    workspace_extent<Workspace>::value;
+} // namespace detail
+
+/// \brief Owning storage for the three points of a #workspace_t.
+///
+/// Buffers only ever grow. Their contents are unspecified after #resize:
+/// #sa_chain_t initialises everything it reads. Allocations of at least 2MiB
+/// are backed by anonymous mappings with transparent huge pages (on Linux),
+/// and since they are not touched before the chain runs, pages end up on the
+/// NUMA node of the thread which uses them.
 struct sa_buffers_t {
   private:
+    friend class workspace_pool_t;
+
     struct impl_t;
     using storage_type = std::aligned_storage_t<64, 8>;
     storage_type _storage;
 
     inline auto impl() noexcept -> impl_t&;
+    inline auto impl() const noexcept -> impl_t const&;
 
   public:
     sa_buffers_t() noexcept;
     explicit sa_buffers_t(size_t size);
+    ~sa_buffers_t() noexcept;
 
     sa_buffers_t(sa_buffers_t const&) = delete;
     sa_buffers_t(sa_buffers_t&&) noexcept;
@@ -66,8 +117,115 @@ struct sa_buffers_t {
 
     auto resize(size_t size) -> void;
     auto workspace() noexcept -> workspace_t;
+
+    /// Returns the number of bytes allocated by the buffers.
+    [[nodiscard]] auto memory_usage() const noexcept -> size_t;
 };
 
+/// Parameters of #workspace_pool_t.
+struct workspace_pool_param_t {
+    /// \brief Upper bound on the memory owned by the pool (in bytes).
+    ///
+    /// This includes both leased and idle buffers. #workspace_pool_t::acquire
+    /// throws `std::bad_alloc` rather than exceed it.
+    size_t max_bytes = std::numeric_limits<size_t>::max();
+    /// \brief Upper bound on the memory kept around for reuse (in bytes).
+    ///
+    /// Buffers which are returned to a pool with more idle memory than this
+    /// are freed immediately.
+    size_t max_idle_bytes = std::numeric_limits<size_t>::max();
+};
+
+/// \brief A thread-safe pool of #sa_buffers_t.
+///
+/// #acquire hands out buffers which are returned to the pool when the lease
+/// is destroyed. Concurrent and nested leases never share memory, e.g.
+/// calling #minimize from within an objective is fine.
+///
+/// \note The pool must outlive all its leases.
+class workspace_pool_t {
+    struct impl_t;
+    std::unique_ptr<impl_t> _impl;
+
+    auto release(sa_buffers_t buffers) noexcept -> void;
+
+  public:
+    /// Buffers leased from a #workspace_pool_t.
+    class lease_t {
+        friend class workspace_pool_t;
+
+        workspace_pool_t* _pool;
+        sa_buffers_t      _buffers;
+
+        lease_t(workspace_pool_t& pool, sa_buffers_t buffers) noexcept
+            : _pool{&pool}, _buffers{std::move(buffers)}
+        {}
+
+      public:
+        lease_t(lease_t const&) = delete;
+        lease_t(lease_t&& other) noexcept
+            : _pool{other._pool}, _buffers{std::move(other._buffers)}
+        {
+            other._pool = nullptr;
+        }
+        auto operator=(lease_t const&) -> lease_t& = delete;
+        auto operator=(lease_t&&) -> lease_t& = delete;
+
+        ~lease_t() noexcept
+        {
+            if (_pool != nullptr) { _pool->release(std::move(_buffers)); }
+        }
+
+        auto workspace() noexcept -> workspace_t
+        {
+            return _buffers.workspace();
+        }
+    };
+
+    explicit workspace_pool_t(workspace_pool_param_t const& params = {});
+    ~workspace_pool_t() noexcept;
+
+    workspace_pool_t(workspace_pool_t const&) = delete;
+    workspace_pool_t(workspace_pool_t&&)      = delete;
+    auto operator=(workspace_pool_t const&) -> workspace_pool_t& = delete;
+    auto operator=(workspace_pool_t&&) -> workspace_pool_t& = delete;
+
+    /// \brief Leases buffers for points of dimension \p size.
+    ///
+    /// Reuses the smallest idle buffers which are large enough. Otherwise, new
+    /// buffers are allocated, freeing idle ones if needed to stay within
+    /// `max_bytes`.
+    ///
+    /// \throws std::bad_alloc if the request can't be satisfied.
+    [[nodiscard]] auto acquire(size_t size) -> lease_t;
+
+    /// Frees all idle buffers.
+    auto trim() noexcept -> void;
+
+    /// Returns the number of bytes in currently leased buffers.
+    [[nodiscard]] auto bytes_in_use() const noexcept -> size_t;
+    /// Returns the number of bytes in idle buffers.
+    [[nodiscard]] auto bytes_idle() const noexcept -> size_t;
+};
+
+/// \brief Returns the pool which #minimize uses when no buffers are given.
+///
+/// There is one pool per thread. It keeps at most 16MiB of idle buffers, so
+/// a thread which once solved a huge problem doesn't hold on to its memory.
+auto thread_local_pool() noexcept -> workspace_pool_t&;
+
+/// \brief Returns a workspace backed by a thread-local #sa_buffers_t.
+///
+/// \deprecated All calls on a thread share the same buffers, so nested calls
+/// alias each other. #minimize now uses #thread_local_pool instead.
 auto thread_local_workspace(size_t size) noexcept -> std::optional<workspace_t>;
 
+namespace detail {
+/// Whether `T` can be passed to #minimize to provide the workspace.
+template <class T>
+inline constexpr auto is_workspace_source_v =
+    std::is_same_v<std::remove_cv_t<T>, sa_buffers_t>
+    || std::is_same_v<std::remove_cv_t<T>, workspace_pool_t>;
+} // namespace detail
+
 DUAL_ANNEALING_NAMESPACE_END
@@ -1,28 +1,121 @@
 #pragma once
 
 #include "assert.hpp"
+#include "bounds.hpp"
 #include "buffers.hpp"
+#include "checkpoint.hpp"
 #include "config.hpp"
+#include "evaluation_cache.hpp"
+#include "finite_difference.hpp"
+#include "instrumentation.hpp"
+#include "local_search_policy.hpp"
+#include "objective.hpp"
+#include "observers.hpp"
+#include "schedule.hpp"
+#include "streams.hpp"
 #include "tsallis_distribution.hpp"
+#include "visiting_scales.hpp"
+#include "warm_lbfgs.hpp"
 
 #include <gsl/gsl-lite.hpp>
 #include <lbfgs/lbfgs.hpp>
 
-#include <cmath> // std::sqrt, std::pow
+#include <algorithm> // std::transform
+#include <array>     // std::array
+#include <cmath>     // std::sqrt, std::pow
 #include <cstddef>
-#include <cstring> // std::memcpy
+#include <cstdint>    // uint8_t
+#include <cstring>    // std::memcpy
+#include <functional> // std::reference_wrapper
+#include <optional>   // std::optional
 #include <random>
 #include <tuple>
 #include <type_traits>
+#include <utility> // std::as_const
+#include <vector>  // std::vector
 
 DA_NAMESPACE_BEGIN
 
+/// \brief Where a chain continues after reannealing, see
+/// #param_t::max_restarts.
+enum class restart_point_t {
+    best,  ///< The best point found so far
+    /// A fresh point: uniformly distributed within `bounds()` if the objective
+    /// has them, and a full visit at the initial temperature around the best
+    /// point otherwise.
+    random,
+};
+
 struct param_t {
     float  q_V;
     float  q_A;
     float  t_0;
     size_t num_iter;
     size_t patience;
+    /// \brief Number of full visits which are evaluated together.
+    ///
+    /// Only has an effect if the objective has a `value_batch` member function
+    /// (see #has_value_batch_mem_fn). Values of `0` and `1` disable batching.
+    ///
+    /// \note Batching changes the sampling: all proposals of a block are
+    /// generated around the point which was current at the start of the
+    /// block. They are then accepted or rejected sequentially against the
+    /// (possibly updated) current point. With `batch_size == 1` this is
+    /// identical to the sequential algorithm.
+    size_t batch_size = 0;
+    /// \brief Number of coordinates changed by a full visit.
+    ///
+    /// `0` (or anything `>= D`) means all of them. Otherwise, full visits are
+    /// replaced by block moves: `block_size` consecutive (modulo `D`)
+    /// coordinates starting at a random position are perturbed by a sample
+    /// of the `block_size`-dimensional visiting distribution. Together with
+    /// `value_from_sparse_diff` (see #has_value_from_sparse_diff_mem_fn) or
+    /// `value_from_diff` a visit then costs `O(block_size)` rather than
+    /// `O(D)`. Takes precedence over #batch_size.
+    size_t block_size = 0;
+    /// \brief Precomputed temperatures, see #temperature_table_t.
+    ///
+    /// Optional. If set, it must have been built for the same `q_V` and
+    /// `t_0`. Iterations beyond its size fall back to computing the
+    /// temperatures on the fly.
+    temperature_table_t const* temperatures = nullptr;
+    /// \brief Maximal number of reannealings, see #restart_temp_ratio.
+    ///
+    /// A chain which has stagnated is restarted at the initial temperature
+    /// (the evaluation budget keeps being counted) rather than idling until
+    /// #num_iter is reached. It has stagnated if after an iteration
+    ///   * `best` didn't improve for #patience iterations,
+    ///   * the visiting temperature dropped below `restart_temp_ratio * t_0`,
+    ///   * or less than a #min_acceptance fraction of its moves were accepted.
+    ///
+    /// `0` disables reannealing, i.e. running out of patience stops the
+    /// minimisation and the other two criteria are ignored.
+    size_t max_restarts = 0;
+    /// Temperature ratio `t_V / t_0` below which the chain is reannealed.
+    /// SciPy uses `2e-5`. `0` disables this criterion.
+    float restart_temp_ratio = 0.0f;
+    /// Fraction of accepted moves in an iteration below which the chain is
+    /// reannealed. `0` disables this criterion.
+    float min_acceptance = 0.0f;
+    /// Where a reannealed chain continues, see #restart_point_t.
+    restart_point_t restart_from = restart_point_t::best;
+    /// \brief Maximal number of function evaluations (including those of local
+    /// search).
+    ///
+    /// It is checked before every iteration, so a run may exceed it by one
+    /// iteration. `0` means no limit.
+    size_t max_f_evals = 0;
+    /// \brief Acceptance rate per coordinate which adaptive visiting aims for.
+    ///
+    /// If positive, every coordinate gets its own scale by which steps of the
+    /// visiting distribution (in full visits, block moves and single visits)
+    /// are multiplied. The scales are updated after every single-coordinate
+    /// move, see #detail::visiting_scales_t. This helps on badly scaled
+    /// objectives where a common `t_V` is too large for stiff coordinates
+    /// and too small for loose ones. `0` disables adaptation.
+    float target_acceptance = 0.0f;
+    /// How fast the scales of #target_acceptance adapt.
+    float scale_adaptation_rate = 0.1f;
 };
 
 struct result_t {
@@ -30,205 +123,208 @@ struct result_t {
     size_t num_iter;
     size_t num_f_evals;
     double acceptance;
+    /// Evaluations spent in local search. They are included in
+    /// #num_f_evals, i.e. annealing used `num_f_evals -
+    /// num_local_search_f_evals` of them.
+    size_t num_local_search_f_evals = 0;
+    size_t num_restarts = 0; ///< Number of reannealings
+    size_t num_accepted = 0; ///< Number of accepted moves
+    /// Accepted single-coordinate moves per coordinate. Only filled if
+    /// adaptive visiting is enabled, see #param_t::target_acceptance.
+    std::vector<size_t> coordinate_num_accepted = {};
+    /// Lookups answered by an evaluation cache in front of the objective
+    /// (see #cached_objective_t). They are included in #num_f_evals.
+    size_t num_cache_hits = 0;
+    size_t num_cache_misses = 0; ///< Lookups which evaluated the objective
 };
 
-namespace detail {
-
-/// \brief Determines whether `T` has a member function `wrap` which can be
-/// called with a single argument of type `X`.
-///
-/// In other words, if we have an object `t` of type `T` and `x` of type `X`,
-/// this trait determines whether `t.wrap(x)` is a valid expression.
-template <class T, class X, class = void>
-struct has_wrap_mem_fn : std::false_type {};
-
-template <class T, class X>
-struct has_wrap_mem_fn<
-    T, X, std::void_t<decltype(std::declval<T>().wrap(std::declval<X>()))>>
-    : std::true_type {};
-
-template <class T, class X>
-inline constexpr auto has_wrap_mem_fn_v = has_wrap_mem_fn<T, X>::value;
-
-/// \brief Determines whether `T` has a member function `value` which can be
-/// called with a single argument of type `gsl::span<float const>`.
-///
-/// In other words, if we have an object `t` of type `T` and `x` of type
-/// `gsl::span<float const>`, this trait determines whether `t.value(x)` is a
-/// valid expression.
-template <class T, class = void> struct has_value_mem_fn : std::false_type {};
-
-template <class T>
-struct has_value_mem_fn<T, std::void_t<decltype(std::declval<T>().value(
-                               std::declval<gsl::span<float const>>()))>>
-    : std::true_type {};
-
-template <class T>
-inline constexpr auto has_value_mem_fn_v = has_value_mem_fn<T>::value;
-
-/// \brief Determines whether `T` has a member function `value_from_diff` which
-/// can be called with `std::pair<gsl::span<float const>, double>` and
-/// `std::pair<size_t, float>`.
+/// \brief Whether `T` can be used as parameters of local search.
 ///
-/// In other words, if we have an object `t` of type `T`, `x` of type
-/// `std::pair<gsl::span<float const>, double>`, and `y` of type
-/// `std::pair<size_t, float>`, this trait determines whether
-/// `t.value_from_diff(x, y)` is a valid expression.
-template <class T, class = void>
-struct has_value_from_diff_mem_fn : std::false_type {};
-
+/// These are `tcm::lbfgs::lbfgs_param_t` (a fresh L-BFGS run for every local
+/// search) and #warm_start_param_t (L-BFGS history is kept between runs).
 template <class T>
-struct has_value_from_diff_mem_fn<
-    T, std::void_t<decltype(std::declval<T>().value_from_diff(
-           std::declval<std::pair<gsl::span<float const>, double>>(),
-           std::declval<std::pair<size_t, float>>()))>> : std::true_type {};
+inline constexpr auto is_local_search_param_v =
+    std::is_same_v<T, tcm::lbfgs::lbfgs_param_t>
+    || std::is_same_v<T, warm_start_param_t>;
 
-template <class T>
-inline constexpr auto has_value_from_diff_mem_fn_v =
-    has_value_from_diff_mem_fn<T>::value;
+namespace detail {
 
-template <class Objective, class = void,
-          class = std::enable_if_t<!has_wrap_mem_fn_v<Objective&, float>>>
-auto do_wrap(Objective& /*unused*/, float const /*unused*/) noexcept -> void
+/// Visiting temperature `t_V` of iteration \p i.
+inline auto visiting_temperature(param_t const& params, size_t const i) noexcept
+    -> float
 {
-    constexpr auto always_false = !std::is_same_v<Objective, Objective>;
-    static_assert(always_false, "Objective is missing 'wrap' member function.");
+    return visiting_temperature(params.q_V, params.t_0, i);
 }
 
-template <class Objective,
-          class = std::enable_if_t<has_wrap_mem_fn_v<Objective&, float>>>
-DA_FORCEINLINE auto do_wrap(Objective& obj, float const x) noexcept(
-    noexcept(std::declval<Objective&>().wrap(std::declval<float>()))) -> float
+/// \brief Parameters of the visiting distribution in iteration \p i.
+///
+/// Taken from `params.temperatures` when possible.
+inline auto visiting_param(param_t const& params, size_t const i) noexcept
+    -> tsallis_distribution_t::param_type
 {
-    return obj.wrap(x);
+    auto const* table = params.temperatures;
+    if (table != nullptr && i < table->size()) {
+        DUAL_ANNEALING_ASSERT(table->q_V() == params.q_V
+                                  && table->t_0() == params.t_0,
+                              "temperature table built for other parameters");
+        return (*table)[i];
+    }
+    return tsallis_distribution_t::param_type{
+        params.q_V, visiting_temperature(params, i)};
 }
 
-template <class Objective>
-DA_FORCEINLINE auto
-do_wrap(std::reference_wrapper<Objective> obj,
-        float const x) noexcept(noexcept(do_wrap(std::declval<Objective&>(),
-                                                 std::declval<float>())))
-    -> float
+template <class F, size_t... Is>
+DA_FORCEINLINE constexpr auto static_for_impl(F&& f,
+                                              std::index_sequence<Is...>)
+    -> void
 {
-    return do_wrap(obj.get(), x);
+    (f(std::integral_constant<size_t, Is>{}), ...);
 }
 
-template <class Objective, class = void,
-          class = std::enable_if_t<!has_value_mem_fn_v<Objective&>>>
-auto do_value(Objective& /*unused*/, gsl::span<float const> /*unused*/) noexcept
-    -> void
+/// Calls `f(0), f(1), ..., f(N - 1)` with the loop fully unrolled.
+template <size_t N, class F>
+DA_FORCEINLINE constexpr auto static_for(F&& f) -> void
 {
-    constexpr auto always_false = !std::is_same_v<Objective, Objective>;
-    static_assert(always_false,
-                  "Objective is missing 'value' member function.");
-}
-
-template <class Objective,
-          class = std::enable_if_t<has_value_mem_fn_v<Objective&>>>
-DA_FORCEINLINE auto
-do_value(Objective& obj, gsl::span<float const> x) noexcept(noexcept(
-    std::declval<Objective&>().value(std::declval<gsl::span<float const>>())))
-    -> double
-{
-    return obj.value(x);
-}
-
-template <class Objective>
-DA_FORCEINLINE auto do_value(
-    std::reference_wrapper<Objective> obj,
-    gsl::span<float const>
-        x) noexcept(noexcept(do_value(std::declval<Objective&>(),
-                                      std::declval<gsl::span<float const>>())))
-    -> double
-{
-    return do_value(obj.get(), x);
-}
-
-template <class Objective, class = void,
-          class = std::enable_if_t<!has_value_from_diff_mem_fn_v<Objective&>>>
-DA_FORCEINLINE auto do_value_from_diff(
-    Objective& obj, std::pair<gsl::span<float const>, double> current,
-    std::pair<size_t, float>
-        diff) noexcept(noexcept(do_value(std::declval<Objective&>(),
-                                         std::declval<
-                                             gsl::span<float const>>())))
-    -> double
-{
-    auto undo = gsl::finally(
-        [p = current.first.data(), i = diff.first,
-         x = current.first[diff.first]]() { const_cast<float*>(p)[i] = x; });
-    const_cast<float*>(current.first.data())[diff.first] = diff.second;
-    return do_value(obj, current.first);
-}
-
-template <class Objective,
-          class = std::enable_if_t<has_value_from_diff_mem_fn_v<Objective&>>>
-DA_FORCEINLINE auto do_value_from_diff(
-    Objective& obj, std::pair<gsl::span<float const>, double> current,
-    std::pair<size_t, float>
-        diff) noexcept(noexcept(std::declval<Objective&>()
-                                    .value_from_diff(
-                                        std::declval<std::pair<
-                                            gsl::span<float const>, double>>(),
-                                        std::declval<
-                                            std::pair<size_t, float>>())))
-    -> double
-{
-    return obj.value_from_diff(current, diff);
-}
-
-template <class Objective>
-DA_FORCEINLINE auto do_value_from_diff(
-    std::reference_wrapper<Objective>         obj,
-    std::pair<gsl::span<float const>, double> current,
-    std::pair<size_t, float>
-        diff) noexcept(noexcept(do_value_from_diff(std::declval<Objective&>(),
-                                                   std::declval<std::pair<
-                                                       gsl::span<float const>,
-                                                       double>>(),
-                                                   std::declval<std::pair<
-                                                       size_t, float>>())))
-    -> double
-{
-    return do_value_from_diff(obj.get(), current, diff);
+    static_for_impl(std::forward<F>(f), std::make_index_sequence<N>{});
 }
 
 } // namespace detail
 
-template <class TargetFn, class Generator> class sa_chain_t { // {{{
+template <class TargetFn, class Generator, class Workspace = workspace_t>
+class sa_chain_t { // {{{
   public:
     using target_fn_type = TargetFn;
     using urnbg_type     = Generator;
+    using workspace_type = Workspace;
+
+    /// Dimension of the parameter space if it's known at compile time.
+    static constexpr auto extent = detail::workspace_extent_v<workspace_type>;
 
   private:
+    /// An edit of `current` which happened after it became the best point.
+    struct edit_t {
+        size_t index; ///< Coordinate which was modified
+        float  x;     ///< Value of the coordinate before the modification
+    };
+    using journal_type =
+        std::conditional_t<extent == detail::dynamic_extent,
+                           std::vector<edit_t>, std::array<edit_t, extent>>;
+
     target_fn_type         _target_fn;
-    workspace_t&           _workspace;
+    workspace_type&        _workspace;
     tsallis_distribution_t _tsallis_dist;
+    detail::acceptance_rule_t _acceptance; ///< Acceptance rule for `q_A`
     urnbg_type&            _generator;    ///< Random number generator
     param_t const&         _params;       ///< Algorithm hyper-parameters
     size_t                 _i;            ///< Current iteration.
+    /// Iterations since the start or the last #reanneal. Determines the
+    /// temperatures.
+    size_t                 _step;
     size_t                 _num_accepted; ///< Number of moves accepted so far
     size_t _num_f_evals; ///< Number of function evaluations till now
+    size_t _num_local_search_f_evals; ///< Part of #_num_f_evals due to L-BFGS
+    std::vector<float>  _batch_xs;    ///< Proposals of the current block
+    std::vector<double> _batch_funcs; ///< Function values at #_batch_xs
+    std::vector<float> _block_steps; ///< Step of the current block move
+    /// The current block move as `(index, new value)` pairs.
+    std::vector<std::pair<size_t, float>> _block_diff;
+    /// Per-coordinate scales of steps, see #param_t::target_acceptance.
+    detail::visiting_scales_t _scales;
+    /// Counters of the objective's evaluation cache (if any) when the chain
+    /// was created.
+    cache_counters_t _initial_cache_counters;
+    /// Buffers of #single_visits_sweep, empty unless it is used.
+    struct sweep_buffers_t {
+        std::vector<float>        ys;     ///< Proposed coordinates
+        std::vector<double>       deltas; ///< Changes of the function value
+        std::vector<float>        dE;     ///< #deltas as `float`s
+        std::vector<float>        us;     ///< Uniform random numbers
+        std::vector<std::uint8_t> accept; ///< Acceptance decisions
+    } _sweep;
+    /// \brief Edits of `current` since it was the best point.
+    ///
+    /// Only meaningful if #_best_is_lazy is `true`. Replaying the edits in
+    /// reverse order on a copy of `current` yields `best`.
+    journal_type _journal;
+    size_t       _journal_size; ///< Number of valid entries in #_journal
+    /// Whether `best.x` is out of date and has to be reconstructed from
+    /// `current` and #_journal.
+    bool _best_is_lazy;
+    /// Profiling hooks, no-ops unless compiled with `DA_INSTRUMENTATION`.
+    detail::instrumentation_t _instrumentation;
+    /// L-BFGS state kept between local searches, see #warm_start_param_t.
+    /// Doesn't allocate unless warm-started local search is used.
+    lbfgs_history_t _lbfgs_history;
+
+    static constexpr auto supports_batching =
+        detail::has_value_batch_mem_fn_v<
+            detail::unwrap_reference_t<target_fn_type>&>;
+    /// Whether the objective wraps whole points at once, either via
+    /// `bounds()` or via `wrap(gsl::span<float>)`.
+    static constexpr auto has_bulk_wrap =
+        detail::has_bounds_mem_fn_v<
+            detail::unwrap_reference_t<target_fn_type>&>
+        || detail::has_wrap_mem_fn_v<
+            detail::unwrap_reference_t<target_fn_type>&, gsl::span<float>>;
+    /// Whether all single-coordinate moves can be evaluated in one pass.
+    static constexpr auto supports_sweep =
+        detail::has_coordinate_deltas_mem_fn_v<
+            detail::unwrap_reference_t<target_fn_type>&>;
 
   public:
-    sa_chain_t(target_fn_type target_fn, workspace_t& workspace,
-               param_t const& params, urnbg_type& generator) noexcept
+    /// \brief Creates a chain which starts at `workspace.current.x`.
+    ///
+    /// If \p saved is not `nullptr`, the chain continues from it (see
+    /// #restore) instead: `workspace.current.x` and `workspace.best.x` must
+    /// then hold the points of \p saved, and the objective isn't evaluated.
+    sa_chain_t(target_fn_type target_fn, workspace_type& workspace,
+               param_t const& params, urnbg_type& generator,
+               checkpoint_state_t const* saved = nullptr)
         : _target_fn{target_fn}
         , _workspace{workspace}
         // t_0 here is arbitrary since we'll update it in operator() anyway
         , _tsallis_dist{params.q_V, params.t_0}
+        , _acceptance{params.q_A}
         , _generator{generator}
         , _params{params}
         , _i{0}
+        , _step{0}
         , _num_accepted{0}
         , _num_f_evals{0}
+        , _num_local_search_f_evals{0}
+        , _batch_xs{}
+        , _batch_funcs{}
+        , _block_steps{}
+        , _block_diff{}
+        , _scales{}
+        , _initial_cache_counters{do_cache_counters()}
+        , _sweep{}
+        , _journal{}
+        , _journal_size{0}
+        , _best_is_lazy{false}
+        , _instrumentation{}
+        , _lbfgs_history{}
     {
-        // We only rely on `_workspace.current.x` being properly initialised.
-        _workspace.current.func = value(_workspace.current.x);
-        _workspace.best         = _workspace.current;
+        if constexpr (extent == detail::dynamic_extent) {
+            // Once the journal is full, we materialise `best` which costs
+            // O(dim()). With this capacity the amortised cost per edit is
+            // O(1), and the journal occupies at most half as much memory as a
+            // point.
+            _journal.resize(std::max<size_t>(dim() / 4, 1));
+        }
+        _scales.init(dim(), params.target_acceptance,
+                     params.scale_adaptation_rate);
         std::memset(_workspace.proposed.x.data(), 0,
                     _workspace.proposed.x.size() * sizeof(float));
         _workspace.proposed.func = std::numeric_limits<double>::quiet_NaN();
+        if (saved != nullptr) {
+            restore(*saved);
+            return;
+        }
+        // We only rely on `_workspace.current.x` being properly initialised.
+        _workspace.current.func = value(_workspace.current.x);
+        _workspace.best         = _workspace.current;
+        detail::do_reset(_target_fn, _workspace.current.x);
     }
 
     sa_chain_t(sa_chain_t const&) = delete;
@@ -236,12 +332,213 @@ template <class TargetFn, class Generator> class sa_chain_t { // {{{
     sa_chain_t& operator=(sa_chain_t const&) = delete;
     sa_chain_t& operator=(sa_chain_t&&) = delete;
 
+    /// Runs one iteration of the annealing schedule.
     inline auto operator()() -> void;
+
+    /// \brief Runs the Markov chain at constant visiting temperature \p t_V
+    /// and acceptance temperature \p t_A.
+    ///
+    /// This is the body of #operator() without the temperature schedule. It
+    /// is exposed for drivers which manage temperatures themselves (e.g.
+    /// #replica_exchange). It still counts as one iteration.
+    inline auto step(float t_V, float t_A) -> void;
+
+  private:
+    /// Same as above, but with the visiting distribution given up front.
+    inline auto step(tsallis_distribution_t::param_type const& visiting,
+                     float t_A) -> void;
+
+  public:
     inline auto local_search(tcm::lbfgs::lbfgs_param_t const&)
         -> tcm::lbfgs::status_t;
 
+    /// \brief Same as above, but continues from the L-BFGS history of the
+    /// previous call unless `current` moved too far since then.
+    inline auto local_search(warm_start_param_t const&)
+        -> tcm::lbfgs::status_t;
+
+    /// \brief Notifies the chain that `current` was modified externally.
+    ///
+    /// Drivers which replace the current point of the workspace (e.g.
+    /// #replica_exchange) must call this function afterwards such that
+    /// objectives implementing the incremental evaluation protocol can update
+    /// their caches.
+    ///
+    /// \note #sync_best must be called *before* modifying `current`.
+    auto current_changed() -> void
+    {
+        DUAL_ANNEALING_ASSERT(!_best_is_lazy,
+                              "sync_best() must be called before modifying "
+                              "current");
+        detail::do_reset(_target_fn, _workspace.current.x);
+    }
+
+    /// \brief Makes `best.x` of the workspace up to date.
+    ///
+    /// To avoid copying the whole point on every improvement, the chain only
+    /// updates `best.func` eagerly. `best.x` is reconstructed on demand from
+    /// `current` and a journal of edits. Call this function before reading
+    /// `best.x` or modifying `current` from outside the chain.
+    auto sync_best() -> void
+    {
+        if (!_best_is_lazy) { return; }
+        std::memcpy(_workspace.best.x.data(), _workspace.current.x.data(),
+                    dim() * sizeof(float));
+        undo_edits(_workspace.best.x);
+        _best_is_lazy = false;
+    }
+
+    /// \brief Restarts the temperature schedule (reannealing).
+    ///
+    /// The next iteration uses the temperatures of the very first one again,
+    /// and `current` is replaced by a point chosen according to \p from.
+    /// Counters (#iteration, #num_f_evals, ...) keep running, so random
+    /// streams which depend on the iteration (see #philox4x32_t) don't
+    /// repeat.
+    auto reanneal(restart_point_t const from) -> void
+    {
+        sync_best();
+        std::memcpy(_workspace.current.x.data(), _workspace.best.x.data(),
+                    dim() * sizeof(float));
+        _workspace.current.func = _workspace.best.func;
+        if (from == restart_point_t::random) {
+            if constexpr (detail::has_bounds_mem_fn_v<
+                              detail::unwrap_reference_t<target_fn_type>&>) {
+                auto const& bounds = detail::unwrap(_target_fn).bounds();
+                auto const  lower  = bounds.lower();
+                auto const  upper  = bounds.upper();
+                for (auto i = size_t{0}; i < dim(); ++i) {
+                    _workspace.current.x[i] =
+                        lower[i]
+                        + detail::uniform_float(_generator)
+                              * (upper[i] - lower[i]);
+                }
+            }
+            else {
+                using std::swap;
+                _tsallis_dist.param(
+                    tsallis_distribution_t::param_type{q_V(), t_0()});
+                generate_full(_workspace.proposed.x);
+                swap(_workspace.current, _workspace.proposed);
+            }
+            _workspace.current.func = value(_workspace.current.x);
+            update_best();
+        }
+        _step = 0;
+        detail::do_reset(_target_fn, _workspace.current.x);
+    }
+
+    /// \brief Offers a point found outside of the chain, e.g. by an
+    /// asynchronous local search.
+    ///
+    /// `best` is replaced if \p func is lower than `best.func`. If
+    /// \p replace_current is `true`, `current` is replaced as well when
+    /// \p func is lower than `current.func`. Returns whether `best` was
+    /// updated.
+    auto offer(gsl::span<float const> x, double const func,
+               bool const replace_current) -> bool
+    {
+        DUAL_ANNEALING_ASSERT(x.size() == dim(), "incompatible dimensions");
+        if (replace_current && func < _workspace.current.func) {
+            // `best` may still refer to the old `current`
+            sync_best();
+            std::memcpy(_workspace.current.x.data(), x.data(),
+                        dim() * sizeof(float));
+            _workspace.current.func = func;
+            detail::do_reset(_target_fn, _workspace.current.x);
+        }
+        if (func < _workspace.best.func) {
+            std::memcpy(_workspace.best.x.data(), x.data(),
+                        dim() * sizeof(float));
+            _workspace.best.func = func;
+            _best_is_lazy        = false;
+            _journal_size        = 0;
+            DUAL_ANNEALING_TRACE("updating best from outside: func=%.5e\n",
+                                 func);
+            return true;
+        }
+        return false;
+    }
+
+    /// Accounts for \p count evaluations done by a local search on behalf of
+    /// the chain.
+    auto add_local_search_f_evals(size_t const count) noexcept -> void
+    {
+        _num_f_evals += count;
+        _num_local_search_f_evals += count;
+    }
+
+    /// \brief Continues from a state saved in a #checkpoint_t.
+    ///
+    /// `current.x` and `best.x` of the workspace must already hold the saved
+    /// points. The fields of \p state which belong to the driver
+    /// (`patience`, `num_restarts` and `best_seen`) are ignored.
+    auto restore(checkpoint_state_t const& state) -> void
+    {
+        _i                        = state.iteration;
+        _step                     = state.temperature_step;
+        _num_accepted             = state.num_accepted;
+        _num_f_evals              = state.num_f_evals;
+        _num_local_search_f_evals = state.num_local_search_f_evals;
+        _workspace.current.func   = state.current_func;
+        _workspace.best.func      = state.best_func;
+        _best_is_lazy             = false;
+        _journal_size             = 0;
+        detail::do_reset(_target_fn, _workspace.current.x);
+    }
+
     constexpr auto iteration() const noexcept { return _i; }
+    /// Returns the number of iterations since the start or the last
+    /// #reanneal.
+    constexpr auto temperature_step() const noexcept { return _step; }
+    constexpr auto num_accepted() const noexcept { return _num_accepted; }
+    /// Returns the number of accepted single-coordinate moves per coordinate
+    /// if adaptive visiting is enabled, and an empty span otherwise.
+    auto coordinate_num_accepted() const noexcept
+    {
+        return _scales.num_accepted();
+    }
+    /// Returns the current per-coordinate scales of the visiting
+    /// distribution if adaptive visiting is enabled, and an empty span
+    /// otherwise.
+    auto visiting_scales() const noexcept { return _scales.scales(); }
+    /// Continues adaptive visiting from saved #visiting_scales and
+    /// #coordinate_num_accepted.
+    auto restore_visiting_scales(gsl::span<float const>  scales,
+                                 gsl::span<size_t const> num_accepted) noexcept
+        -> void
+    {
+        _scales.restore(scales, num_accepted);
+    }
+    /// Returns the visiting temperature used in the last iteration.
+    constexpr auto visiting_temperature() const noexcept
+    {
+        return _tsallis_dist.t_V();
+    }
     constexpr auto num_f_evals() const noexcept { return _num_f_evals; }
+    constexpr auto num_local_search_f_evals() const noexcept
+    {
+        return _num_local_search_f_evals;
+    }
+
+    /// \brief Hits and misses of the objective's evaluation cache (see
+    /// #cached_objective_t) since the chain was created.
+    ///
+    /// Zeros if the objective has no cache.
+    auto cache_counters() const noexcept -> cache_counters_t
+    {
+        auto const now = do_cache_counters();
+        return cache_counters_t{now.hits - _initial_cache_counters.hits,
+                                now.misses - _initial_cache_counters.misses};
+    }
+
+    /// \brief Per-phase timings and acceptance counts of this chain.
+    ///
+    /// All zeros unless compiled with `DA_INSTRUMENTATION_COUNTERS` or higher.
+    auto counters() const noexcept -> chain_counters_t
+    {
+        return _instrumentation.counters();
+    }
     constexpr auto acceptance() const noexcept
     {
         if (_i == 0) { return std::numeric_limits<double>::quiet_NaN(); }
@@ -251,50 +548,75 @@ template <class TargetFn, class Generator> class sa_chain_t { // {{{
     }
 
   private:
+    auto do_cache_counters() const noexcept -> cache_counters_t
+    {
+        if constexpr (detail::has_cache_counters_mem_fn_v<
+                          detail::unwrap_reference_t<target_fn_type> const&>) {
+            return detail::unwrap(_target_fn).cache_counters();
+        }
+        else {
+            return cache_counters_t{0, 0};
+        }
+    }
+
     constexpr auto t_0() const noexcept { return _params.t_0; }
     constexpr auto q_V() const noexcept { return _params.q_V; }
     constexpr auto q_A() const noexcept { return _params.q_A; }
     /// Returns the dimension of the parameter space.
-    constexpr auto dim() const noexcept { return _workspace.current.x.size(); }
+    constexpr auto dim() const noexcept -> size_t
+    {
+        if constexpr (extent != detail::dynamic_extent) { return extent; }
+        else {
+            return _workspace.current.x.size();
+        }
+    }
 
     /// Calculates the visiting temperature `t_V` for iteration \p i.
     [[nodiscard]] auto temperature(size_t i) const noexcept -> float
     {
-        auto const num = t_0() * (std::pow(2.0f, q_V() - 1.0f) - 1.0f);
-        auto const den =
-            std::pow(static_cast<float>(2 + i), q_V() - 1.0f) - 1.0f;
-        return num / den;
+        return detail::visiting_temperature(_params, i);
     }
 
     auto value(gsl::span<float const> x) -> double
     {
         ++_num_f_evals;
-        return detail::do_value(_target_fn, x);
+        auto const start = _instrumentation.start();
+        auto const func  = detail::do_value(_target_fn, x);
+        _instrumentation.evaluated(start, 1);
+        return func;
     }
 
     auto value_from_diff(std::pair<gsl::span<float const>, double> current,
                          std::pair<size_t, float> diff) -> double
     {
         ++_num_f_evals;
-        return detail::do_value_from_diff(_target_fn, current, diff);
+        auto const start = _instrumentation.start();
+        auto const func  = [this, &current, &diff]() {
+            if constexpr (detail::has_incremental_protocol_v<
+                              detail::unwrap_reference_t<target_fn_type>&>) {
+                // The objective knows the current point from the last `reset`
+                // or `commit`, so just the difference is enough. NOTE: we
+                // must call `commit` or `rollback` afterwards!
+                return current.second
+                       + detail::do_propose(_target_fn, diff.first,
+                                            diff.second);
+            }
+            else {
+                return detail::do_value_from_diff(_target_fn, current, diff);
+            }
+        }();
+        _instrumentation.evaluated(start, 1);
+        return func;
     }
 
     template <class Accept, class Reject>
     auto accept_or_reject(float const dE, float const t_A, Accept&& accept,
                           Reject&& reject)
     {
-        // Always accept moves that reduce the energy
+        // Always accept moves that reduce the energy. NOTE: no random number
+        // is drawn for them.
         if (dE < 0.0f) { return std::forward<Accept>(accept)(); }
-
-        // Eq. (5)
-        //
-        // pqv_temp = (q_A - 1.0) * (e - self.energy_state.current_energy) / (
-        //   self.temperature_step + 1.)
-        //
-        auto const factor = 1.0f + (q_A() - 1.0f) * dE / t_A;
-        auto const P_qA =
-            factor <= 0.0f ? 0.0f : std::pow(factor, 1.0f / (1.0f - q_A()));
-        if (std::uniform_real_distribution<float>{}(_generator) <= P_qA) {
+        if (_acceptance.accepts(detail::uniform_float(_generator), dE, t_A)) {
             return std::forward<Accept>(accept)();
         }
         else {
@@ -302,46 +624,223 @@ template <class TargetFn, class Generator> class sa_chain_t { // {{{
         }
     }
 
+    /// Evaluates the objective at the first \p n proposals in #_batch_xs.
+    auto value_batch(size_t const n) -> void
+    {
+        _num_f_evals += n;
+        auto const start = _instrumentation.start();
+        detail::unwrap(_target_fn)
+            .value_batch(gsl::span<float const>{_batch_xs.data(), n * dim()},
+                         n, gsl::span<double>{_batch_funcs.data(), n});
+        _instrumentation.evaluated(start, n);
+    }
+
+    /// \brief Updates `best` if `current` is better.
+    ///
+    /// Only `best.func` is updated, `best.x` is marked as lazy.
+    auto update_best() -> void
+    {
+        if (_workspace.current.func < _workspace.best.func) {
+            _workspace.best.func = _workspace.current.func;
+            _best_is_lazy        = true;
+            _journal_size        = 0;
+            DUAL_ANNEALING_TRACE("updating best: func=%.5e\n",
+                                 _workspace.best.func);
+        }
+    }
+
+    /// Must be called before `current.x[i]` is modified.
+    auto record_edit(size_t const i) -> void
+    {
+        if (!_best_is_lazy) { return; }
+        if (DUAL_ANNEALING_UNLIKELY(_journal_size == _journal.size())) {
+            sync_best();
+            return;
+        }
+        _journal[_journal_size++] = edit_t{i, _workspace.current.x[i]};
+    }
+
+    /// Replays the journal in reverse order on \p x and clears it.
+    auto undo_edits(gsl::span<float> x) -> void
+    {
+        for (auto k = _journal_size; k-- > 0;) {
+            x[_journal[k].index] = _journal[k].x;
+        }
+        _journal_size = 0;
+    }
+
+    /// \brief Materialises `best.x` using the storage of \p point.
+    ///
+    /// \p point must contain the data `current` had at the time of the call to
+    /// #record_edit or #update_best, e.g. after `current` and `proposed` have
+    /// been swapped. The contents of \p point are unspecified afterwards,
+    /// but, unlike #sync_best, this costs O(1) for #workspace_t.
+    template <class Point> auto materialise_best_from(Point& point) -> void
+    {
+        if (!_best_is_lazy) { return; }
+        undo_edits(point.x);
+        using std::swap;
+        swap(_workspace.best.x, point.x);
+        _best_is_lazy = false;
+    }
+
+    /// Writes a random point around `current` into \p out.
+    inline auto generate_full(gsl::span<float> out) -> void
+    {
+        // First generate the step and then add it to the current point
+        _tsallis_dist.fill(_generator, out);
+        if (_scales.enabled()) { _scales.apply(out); }
+        if constexpr (extent != detail::dynamic_extent && !has_bulk_wrap) {
+            detail::static_for<extent>([this, out](auto const i) {
+                out[i] = detail::do_wrap(_target_fn,
+                                         _workspace.current.x[i] + out[i]);
+            });
+        }
+        else {
+            detail::do_wrap_step(_target_fn, _workspace.current.x, out);
+        }
+    }
+
     inline auto generate_full() -> void
     {
-        using std::begin, std::end;
-        auto g = _tsallis_dist.many(_generator);
-        std::transform(begin(_workspace.current.x), end(_workspace.current.x),
-                       begin(_workspace.proposed.x), [this, &g](auto const x) {
-                           return detail::do_wrap(_target_fn, x + g());
-                       });
+        generate_full(_workspace.proposed.x);
         _workspace.proposed.func = value(_workspace.proposed.x);
     }
 
+    inline auto full_visits(float t_A) -> void;
+    inline auto full_visits_batched(float t_A, size_t batch_size) -> void;
+    inline auto full_visits_block(float t_A, size_t block_size) -> void;
+    inline auto single_visits(float t_A) -> void;
+    inline auto single_visits_sweep(float t_A) -> void;
+
+    /// \brief Common part of both #local_search overloads.
+    ///
+    /// \p run is called with an objective (`value_and_gradient` with
+    /// evaluation counting) and `proposed.x`, and runs the optimiser.
+    template <class Run>
+    inline auto run_local_search(Run&& run) -> tcm::lbfgs::status_t;
+
+    /// \brief Writes a random block move into #_block_diff and returns the
+    /// function value after it.
+    inline auto generate_block() -> double
+    {
+        auto const k = _block_diff.size();
+        _tsallis_dist.fill(_generator, _block_steps);
+        auto i = detail::uniform_index(_generator, dim());
+        for (auto m = size_t{0}; m < k; ++m, ++i) {
+            if (i == dim()) { i = 0; }
+            _block_diff[m] = std::make_pair(
+                i, detail::do_wrap_one(_target_fn, i,
+                                       _workspace.current.x[i]
+                                           + scaled_step(i, _block_steps[m])));
+        }
+
+        ++_num_f_evals;
+        auto const start = _instrumentation.start();
+        auto const func  = detail::do_value_from_sparse_diff(
+            _target_fn,
+            std::make_pair(gsl::span<float const>{_workspace.current.x},
+                           _workspace.current.func),
+            gsl::span<std::pair<size_t, float>>{_block_diff});
+        _instrumentation.evaluated(start, 1);
+        return func;
+    }
+
+    /// Returns \p step scaled for coordinate \p i, see #_scales.
+    auto scaled_step(size_t const i, float const step) const noexcept -> float
+    {
+        return _scales.enabled() ? _scales[i] * step : step;
+    }
+
+    /// Adapts the scale of coordinate \p i after a single-coordinate move.
+    auto adapt_scale(size_t const i, bool const accepted) noexcept -> void
+    {
+        if (_scales.enabled()) { _scales.update(i, accepted); }
+    }
+
     inline auto generate_one(size_t const i) -> std::tuple<float, double>
     {
-        auto const x = detail::do_wrap(_target_fn, _tsallis_dist(_generator));
+        auto const step = scaled_step(i, _tsallis_dist(_generator));
+        auto const x =
+            detail::do_wrap_one(_target_fn, i, _workspace.current.x[i] + step);
         auto const func = value_from_diff(
-            std::make_pair(_workspace.current.x, _workspace.current.func),
+            std::make_pair(gsl::span<float const>{_workspace.current.x},
+                           _workspace.current.func),
             std::make_pair(i, x));
         return {x, func};
     }
 };
 
-template <class TargetFn, class Generator>
-auto sa_chain_t<TargetFn, Generator>::operator()() -> void
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::operator()() -> void
 {
     // (iv) Calculate new temperature...
-    auto const t_V = temperature(_i);
-    auto const t_A = t_V / static_cast<float>(_i + 1);
-    _tsallis_dist.param(tsallis_distribution_t::param_type{q_V(), t_V});
+    auto const visiting = detail::visiting_param(_params, _step);
+    step(visiting, visiting.t_V() / static_cast<float>(_step + 1));
+}
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::step(float const t_V, float const t_A)
+    -> void
+{
+    step(tsallis_distribution_t::param_type{q_V(), t_V}, t_A);
+}
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::step(
+    tsallis_distribution_t::param_type const& visiting, float const t_A)
+    -> void
+{
+    if constexpr (detail::has_set_iteration_mem_fn_v<urnbg_type>) {
+        // Makes the random numbers of this iteration independent of how many
+        // were consumed before, see philox4x32_t.
+        _generator.set_iteration(_i);
+    }
+    _tsallis_dist.param(visiting);
 
     // Markov chain at constant temperature
+    auto accepted_before = _num_accepted;
+    auto start           = _instrumentation.start();
+    if (_params.block_size != 0 && _params.block_size < dim()) {
+        full_visits_block(t_A, _params.block_size);
+    }
+    else if constexpr (supports_batching) {
+        if (_params.batch_size > 1) {
+            full_visits_batched(t_A, _params.batch_size);
+        }
+        else {
+            full_visits(t_A);
+        }
+    }
+    else {
+        full_visits(t_A);
+    }
+    _instrumentation.stop(phase_t::full_visits, start, _i,
+                          _num_accepted - accepted_before, dim());
+
+    accepted_before = _num_accepted;
+    start           = _instrumentation.start();
+    single_visits(t_A);
+    _instrumentation.stop(phase_t::single_visits, start, _i,
+                          _num_accepted - accepted_before, dim());
+    _instrumentation.flush();
+
+    // NOTE: Don't forget this!
+    ++_i;
+    ++_step;
+}
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::full_visits(float const t_A) -> void
+{
     for (auto j = 0U; j < dim(); ++j) {
         auto const accept = [this]() {
             using std::swap;
             ++_num_accepted;
             swap(_workspace.current, _workspace.proposed);
-            if (_workspace.current.func < _workspace.best.func) {
-                _workspace.best = _workspace.current;
-                DUAL_ANNEALING_TRACE("updating best: func=%.5e\n",
-                                     _workspace.best.func);
-            }
+            materialise_best_from(_workspace.proposed);
+            detail::do_reset(_target_fn, _workspace.current.x);
+            update_best();
         };
         auto const reject = []() {};
         generate_full(); // In-place updates _workspace.proposed
@@ -349,39 +848,204 @@ auto sa_chain_t<TargetFn, Generator>::operator()() -> void
                                             - _workspace.current.func),
                          t_A, accept, reject);
     }
+}
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::full_visits_batched(
+    float const t_A, size_t const batch_size) -> void
+{
+    _batch_xs.resize(batch_size * dim());
+    _batch_funcs.resize(batch_size);
+    for (auto j = size_t{0}; j < dim(); j += batch_size) {
+        auto const n = std::min(batch_size, dim() - j);
+        // All proposals are generated around the same point. See the note on
+        // param_t::batch_size.
+        for (auto k = size_t{0}; k < n; ++k) {
+            generate_full(
+                gsl::span<float>{_batch_xs.data() + k * dim(), dim()});
+        }
+        value_batch(n);
+        for (auto k = size_t{0}; k < n; ++k) {
+            auto const func   = _batch_funcs[k];
+            auto const accept = [this, k, func]() {
+                ++_num_accepted;
+                materialise_best_from(_workspace.current);
+                std::memcpy(_workspace.current.x.data(),
+                            _batch_xs.data() + k * dim(),
+                            dim() * sizeof(float));
+                _workspace.current.func = func;
+                detail::do_reset(_target_fn, _workspace.current.x);
+                update_best();
+            };
+            auto const reject = []() {};
+            accept_or_reject(static_cast<float>(func - _workspace.current.func),
+                             t_A, accept, reject);
+        }
+    }
+}
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::full_visits_block(
+    float const t_A, size_t const block_size) -> void
+{
+    constexpr auto incremental = detail::has_incremental_protocol_v<
+        detail::unwrap_reference_t<target_fn_type>&>;
+    _block_steps.resize(block_size);
+    _block_diff.resize(block_size);
+    for (auto j = size_t{0}; j < dim(); ++j) {
+        auto const func   = generate_block();
+        auto const accept = [this, func]() {
+            ++_num_accepted;
+            for (auto const& [i, x] : _block_diff) {
+                if constexpr (incremental) {
+                    // Keeps the caches of the objective up to date in O(k)
+                    // rather than O(D) for a `reset`.
+                    static_cast<void>(detail::do_propose(_target_fn, i, x));
+                    detail::do_commit(_target_fn);
+                }
+                record_edit(i);
+                _workspace.current.x[i] = x;
+            }
+            _workspace.current.func = func;
+            update_best();
+        };
+        auto const reject = []() {};
+        accept_or_reject(static_cast<float>(func - _workspace.current.func),
+                         t_A, accept, reject);
+    }
+}
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::single_visits(float const t_A) -> void
+{
+    if constexpr (supports_sweep) {
+        single_visits_sweep(t_A);
+        return;
+    }
     for (auto j = 0U; j < dim(); ++j) {
         auto const [x, func] = generate_one(j);
         auto const accept    = [this, j, x = x, func = func]() {
             ++_num_accepted;
+            detail::do_commit(_target_fn);
+            record_edit(j);
             _workspace.current.x[j] = x;
             _workspace.current.func = func;
-            if (_workspace.current.func < _workspace.best.func) {
-                _workspace.best = _workspace.current;
-                DUAL_ANNEALING_TRACE("updating best: func=%.5e\n",
-                                     _workspace.best.func);
-            }
+            update_best();
+            adapt_scale(j, true);
+        };
+        auto const reject = [this, j]() {
+            detail::do_rollback(_target_fn);
+            adapt_scale(j, false);
         };
-        auto const reject = []() {};
         accept_or_reject(static_cast<float>(func - _workspace.current.func),
                          t_A, accept, reject);
     }
+}
 
-    // NOTE: Don't forget this!
-    ++_i;
+/// \brief Single-coordinate moves with all proposals evaluated up front.
+///
+/// Same Markov chain as the loop in #single_visits, but the sampling, the
+/// evaluation (`coordinate_deltas`), and the acceptance tests of all `D`
+/// moves are done in bulk. The accepted moves are then applied in order.
+/// Only a move whose coordinate is coupled to an earlier accepted one (see
+/// #has_coupling_mem_fn) must be re-evaluated and tested again.
+///
+/// \note The random numbers are consumed in a different order than by the
+/// scalar loop, and a uniform number is drawn for every move.
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::single_visits_sweep(
+    float const t_A) -> void
+{
+    auto const n = dim();
+    _sweep.ys.resize(n);
+    _sweep.deltas.resize(n);
+    _sweep.dE.resize(n);
+    _sweep.us.resize(n);
+    _sweep.accept.resize(n);
+
+    // Sampling. Coordinates are visited once per sweep, so all proposals can
+    // use the coordinates `current` has now.
+    auto const ys = gsl::span<float>{_sweep.ys};
+    _tsallis_dist.fill_independent(_generator, ys);
+    if (_scales.enabled()) { _scales.apply(ys); }
+    detail::do_wrap_step(_target_fn, _workspace.current.x, ys);
+
+    // Evaluation
+    _num_f_evals += n;
+    auto const start = _instrumentation.start();
+    detail::unwrap(_target_fn)
+        .coordinate_deltas(gsl::span<float const>{_workspace.current.x},
+                           gsl::span<float const>{ys},
+                           gsl::span<double>{_sweep.deltas});
+    _instrumentation.evaluated(start, n);
+
+    // Acceptance tests
+    for (auto j = size_t{0}; j < n; ++j) {
+        _sweep.dE[j] = static_cast<float>(_sweep.deltas[j]);
+        _sweep.us[j] = detail::uniform_float(_generator);
+    }
+    _acceptance.accepts(_sweep.us, _sweep.dE, t_A, _sweep.accept);
+
+    auto const coupling = detail::do_coupling(_target_fn);
+    auto       last     = std::optional<size_t>{}; // Last accepted move
+    for (auto j = size_t{0}; j < n; ++j) {
+        auto delta    = _sweep.deltas[j];
+        auto accepted = _sweep.accept[j] != 0;
+        if (coupling != 0 && last.has_value() && j - *last <= coupling) {
+            // A coordinate which the j'th term depends on has changed
+            ++_num_f_evals;
+            auto const eval_start = _instrumentation.start();
+            auto const func       = detail::do_value_from_diff(
+                _target_fn,
+                std::make_pair(gsl::span<float const>{_workspace.current.x},
+                               _workspace.current.func),
+                std::make_pair(j, ys[j]));
+            _instrumentation.evaluated(eval_start, 1);
+            delta = func - _workspace.current.func;
+            accepted = _acceptance.accepts(
+                _sweep.us[j], static_cast<float>(delta), t_A);
+        }
+        adapt_scale(j, accepted);
+        if (!accepted) { continue; }
+        ++_num_accepted;
+        record_edit(j);
+        _workspace.current.x[j] = ys[j];
+        _workspace.current.func += delta;
+        update_best();
+        last = j;
+    }
+    // The objective's caches (if any) didn't see the accepted moves
+    if (last.has_value()) {
+        detail::do_reset(_target_fn, _workspace.current.x);
+    }
 }
 
-template <class TargetFn, class Generator>
-auto sa_chain_t<TargetFn, Generator>::local_search(
-    tcm::lbfgs::lbfgs_param_t const& params) -> tcm::lbfgs::status_t
+template <class TargetFn, class Generator, class Workspace>
+template <class Run>
+auto sa_chain_t<TargetFn, Generator, Workspace>::run_local_search(Run&& run)
+    -> tcm::lbfgs::status_t
 {
+    auto       moved  = false; // Whether `current` was replaced
+    auto const start  = _instrumentation.start();
+    auto const record = gsl::finally([this, start, &moved]() {
+        _instrumentation.stop(phase_t::local_search, start, _i,
+                              moved ? 1 : 0, 1);
+        _instrumentation.flush();
+    });
+
     _workspace.proposed = _workspace.current;
-    auto r              = tcm::lbfgs::minimize(
+    auto r              = run(
         [this](gsl::span<float const> x, gsl::span<float> g) {
             // NOTE: We keep track of the number of function evaluations
-            ++_num_f_evals;
-            return _target_fn.value_and_gradient(x, g);
+            auto const cost = detail::gradient_cost(_target_fn, x.size());
+            _num_f_evals += cost;
+            _num_local_search_f_evals += cost;
+            auto const eval_start = _instrumentation.start();
+            auto const func = detail::do_value_and_gradient(_target_fn, x, g);
+            _instrumentation.evaluated(eval_start, cost);
+            return func;
         },
-        params, _workspace.proposed.x);
+        gsl::span<float>{_workspace.proposed.x});
     _workspace.proposed.func = r.func;
 
     switch (r.status) {
@@ -400,12 +1064,10 @@ auto sa_chain_t<TargetFn, Generator>::local_search(
     case tcm::lbfgs::status_t::success:
         using std::swap;
         swap(_workspace.proposed, _workspace.current);
-        if (_workspace.current.func < _workspace.best.func) {
-            _workspace.best = _workspace.current;
-            DUAL_ANNEALING_TRACE(
-                "updating best after local search: func=%.5e\n",
-                _workspace.best.func);
-        }
+        materialise_best_from(_workspace.proposed);
+        detail::do_reset(_target_fn, _workspace.current.x);
+        update_best();
+        moved = true;
         return tcm::lbfgs::status_t::success;
         break;
     default:
@@ -415,83 +1077,779 @@ auto sa_chain_t<TargetFn, Generator>::local_search(
     } // end switch
     return r.status;
 }
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::local_search(
+    tcm::lbfgs::lbfgs_param_t const& params) -> tcm::lbfgs::status_t
+{
+    return run_local_search([&params](auto&& f, gsl::span<float> x) {
+        return tcm::lbfgs::minimize(f, params, x);
+    });
+}
+
+template <class TargetFn, class Generator, class Workspace>
+auto sa_chain_t<TargetFn, Generator, Workspace>::local_search(
+    warm_start_param_t const& params) -> tcm::lbfgs::status_t
+{
+    return run_local_search([this, &params](auto&& f, gsl::span<float> x) {
+        return detail::minimize_warm(f, params, _lbfgs_history, x);
+    });
+}
 // }}}
 
-template <class Objective, class Generator>
-DA_NOINLINE auto minimize(Objective&& obj, gsl::span<float> x,
-                          param_t const& parameters, Generator& generator)
-    -> result_t
+namespace detail {
+/// \brief Whether the outcome of L-BFGS is worth keeping.
+///
+/// Same logic as in #sa_chain_t::local_search: "questionable" statuses are
+/// fine as long as L-BFGS managed to reduce the loss.
+inline auto is_useful_local_search(tcm::lbfgs::status_t const status,
+                                   double const func, double const start_func)
+    -> bool
+{
+    switch (status) {
+    case tcm::lbfgs::status_t::success: return true;
+    case tcm::lbfgs::status_t::too_many_iterations:
+    case tcm::lbfgs::status_t::maximum_step_reached:
+    case tcm::lbfgs::status_t::minimum_step_reached:
+    case tcm::lbfgs::status_t::too_many_function_evaluations:
+    case tcm::lbfgs::status_t::interval_too_small:
+    case tcm::lbfgs::status_t::rounding_errors_prevent_progress:
+        return func < start_func;
+    default: return false;
+    } // end switch
+}
+
+/// A no-op `OnIteration` callback for #minimize_impl.
+struct ignore_iteration_fn {
+    template <class Workspace>
+    constexpr auto operator()(Workspace const& /*unused*/) const noexcept
+        -> void
+    {}
+};
+
+/// Calls \p on_iteration with a fully synchronised \p workspace.
+template <class Chain, class Workspace, class OnIteration>
+DA_FORCEINLINE auto notify(Chain& chain, Workspace const& workspace,
+                           OnIteration& on_iteration) -> void
+{
+    if constexpr (!std::is_same_v<std::decay_t<OnIteration>,
+                                  ignore_iteration_fn>) {
+        chain.sync_best();
+        on_iteration(workspace);
+    }
+}
+
+/// \brief Calls \p observer with the state of \p chain.
+///
+/// Returns whether the observer asked to stop.
+template <class Chain, class Workspace, class Observer>
+DA_FORCEINLINE auto observe(Chain const& chain, Workspace const& workspace,
+                            Observer& observer) -> bool
 {
-    auto workspace = thread_local_workspace(x.size());
-    if (!workspace.has_value()) {
-        // Memory allocation failed
-        // TODO(twesterhout): Convert this to error_codes
-        throw std::bad_alloc{};
+    if constexpr (std::is_same_v<std::decay_t<Observer>, no_observer_t>) {
+        return false;
     }
+    else {
+        auto const info = iteration_info_t{
+            /*iteration=*/chain.iteration(),
+            /*current_func=*/workspace.current.func,
+            /*best_func=*/workspace.best.func,
+            /*num_f_evals=*/chain.num_f_evals(),
+            /*acceptance=*/chain.acceptance(),
+            /*t_V=*/chain.visiting_temperature()};
+        return observer(info) == observer_action_t::stop;
+    }
+}
+
+/// Summarises a finished run of \p chain. `best` must be up to date.
+template <class Chain, class Workspace>
+auto make_result(Chain const& chain, Workspace const& workspace,
+                 size_t const num_restarts) -> result_t
+{
+    auto const per_coordinate = chain.coordinate_num_accepted();
+    auto const cache          = chain.cache_counters();
+    return result_t{
+        /*func=*/workspace.best.func,
+        /*num_iter=*/chain.iteration(),
+        /*num_f_evals=*/chain.num_f_evals(),
+        /*acceptance=*/chain.acceptance(),
+        /*num_local_search_f_evals=*/chain.num_local_search_f_evals(),
+        /*num_restarts=*/num_restarts,
+        /*num_accepted=*/chain.num_accepted(),
+        /*coordinate_num_accepted=*/
+        std::vector<size_t>(per_coordinate.begin(), per_coordinate.end()),
+        /*num_cache_hits=*/cache.hits,
+        /*num_cache_misses=*/cache.misses};
+}
+
+/// State of the loop in #minimize_in which doesn't belong to the chain.
+struct driver_state_t {
+    size_t patience;     ///< Patience at the start of the next iteration
+    double best_seen;    ///< Best value we have reacted to
+    size_t num_restarts; ///< Number of reannealings so far
 
-    std::memcpy(workspace->current.x.data(), x.data(),
+    explicit driver_state_t(param_t const& parameters) noexcept
+        : patience{parameters.patience}
+        , best_seen{std::numeric_limits<double>::infinity()}
+        , num_restarts{0}
+    {}
+
+    /// \brief Accounts for an iteration which has just finished.
+    ///
+    /// Returns whether `best` improved.
+    template <class Workspace>
+    auto update(param_t const& parameters, Workspace const& workspace) noexcept
+        -> bool
+    {
+        auto const improved = workspace.best.func < best_seen;
+        if (improved) {
+            best_seen = workspace.best.func;
+            patience  = parameters.patience;
+        }
+        --patience;
+        return improved;
+    }
+};
+
+/// Whether the budget of function evaluations is used up.
+template <class Chain>
+auto out_of_budget(Chain const& chain, param_t const& parameters) noexcept
+    -> bool
+{
+    return parameters.max_f_evals != 0
+           && chain.num_f_evals() >= parameters.max_f_evals;
+}
+
+/// \brief Reanneals \p chain if it has stagnated, see
+/// #param_t::max_restarts.
+///
+/// \p accepted is the number of moves accepted in the last iteration.
+template <class Chain>
+auto maybe_reanneal(Chain& chain, param_t const& parameters,
+                    driver_state_t& driver, size_t const dim,
+                    size_t const accepted) -> void
+{
+    if (driver.num_restarts >= parameters.max_restarts) { return; }
+    auto const stagnated =
+        driver.patience == 0
+        || chain.visiting_temperature()
+               < parameters.restart_temp_ratio * parameters.t_0
+        || static_cast<float>(accepted)
+               < parameters.min_acceptance * static_cast<float>(2 * dim);
+    if (!stagnated) { return; }
+    DUAL_ANNEALING_TRACE("reannealing at iteration %zu\n", chain.iteration());
+    chain.reanneal(parameters.restart_from);
+    driver.patience = parameters.patience;
+    ++driver.num_restarts;
+}
+
+/// Checkpointing hooks of #minimize_in which do nothing.
+struct no_checkpoint_t {
+    template <class Workspace, class Generator>
+    constexpr auto load(Workspace& /*unused*/, Generator& /*unused*/,
+                        param_t const& /*unused*/) const noexcept
+        -> checkpoint_state_t const*
+    {
+        return nullptr;
+    }
+
+    template <class Chain>
+    constexpr auto resume(Chain& /*unused*/,
+                          driver_state_t& /*unused*/) const noexcept -> void
+    {}
+
+    template <class Chain, class Workspace, class Generator>
+    constexpr auto save(Chain& /*unused*/, Workspace const& /*unused*/,
+                        Generator const& /*unused*/,
+                        driver_state_t const& /*unused*/,
+                        bool /*unused*/) const noexcept -> void
+    {}
+};
+
+/// Checkpointing hooks of #minimize_in backed by a #checkpoint_t.
+class checkpoint_hooks_t {
+    checkpoint_t& _checkpoint;
+    /// Iteration of the last save, to avoid saving the same state twice.
+    std::optional<size_t> _last_saved;
+    /// What #load read and #resume still has to hand over.
+    checkpoint_state_t  _state;
+    std::vector<float>  _scales;
+    std::vector<size_t> _scale_num_accepted;
+
+    template <class Generator>
+    static auto as_bytes(Generator& generator) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<Generator>,
+                      "checkpointing requires a trivially copyable generator");
+        using byte_type = std::conditional_t<std::is_const_v<Generator>,
+                                             std::byte const, std::byte>;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return gsl::span<byte_type>{reinterpret_cast<byte_type*>(
+                                        std::addressof(generator)),
+                                    sizeof(Generator)};
+    }
+
+  public:
+    explicit checkpoint_hooks_t(checkpoint_t& checkpoint) noexcept
+        : _checkpoint{checkpoint}
+        , _last_saved{}
+        , _state{}
+        , _scales{}
+        , _scale_num_accepted{}
+    {}
+
+    /// \brief Opens the checkpoint and loads the state it holds (if any).
+    ///
+    /// Points go straight to \p workspace and \p generator is overwritten.
+    /// Returns the state to construct the chain from (see #sa_chain_t), or
+    /// `nullptr` if there is nothing to continue from. The rest is handed
+    /// over by #resume once the chain exists.
+    template <class Workspace, class Generator>
+    auto load(Workspace& workspace, Generator& generator,
+              param_t const& parameters) -> checkpoint_state_t const*
+    {
+        auto const dim        = workspace.current.x.size();
+        auto const num_scales = visiting_scales_t::size(
+            dim, parameters.target_acceptance);
+        auto const layout = checkpoint_layout_t{
+            /*dim=*/dim,
+            /*generator_size=*/sizeof(Generator),
+            /*q_V=*/parameters.q_V, /*q_A=*/parameters.q_A,
+            /*t_0=*/parameters.t_0, /*num_scales=*/num_scales};
+        if (!_checkpoint.open(layout)) { return nullptr; }
+        _scales.resize(num_scales);
+        _scale_num_accepted.resize(num_scales);
+        _checkpoint.load(_state, workspace.current.x, workspace.best.x,
+                         as_bytes(generator), _scales, _scale_num_accepted);
+        _last_saved = _state.iteration;
+        return &_state;
+    }
+
+    /// Continues \p chain and \p driver from what #load read, if anything.
+    template <class Chain>
+    auto resume(Chain& chain, driver_state_t& driver) -> void
+    {
+        if (!_last_saved.has_value()) { return; }
+        if (!_scales.empty()) {
+            chain.restore_visiting_scales(_scales, _scale_num_accepted);
+        }
+        driver.patience     = _state.patience;
+        driver.best_seen    = _state.best_seen;
+        driver.num_restarts = _state.num_restarts;
+    }
+
+    /// Saves the state if an interval has passed or \p force is set.
+    template <class Chain, class Workspace, class Generator>
+    auto save(Chain& chain, Workspace const& workspace,
+              Generator const& generator, driver_state_t const& driver,
+              bool const force) -> void
+    {
+        auto const i = chain.iteration();
+        if (_last_saved == i) { return; }
+        if (!force && i % _checkpoint.interval() != 0) { return; }
+        chain.sync_best();
+        _checkpoint.save(
+            checkpoint_state_t{
+                /*iteration=*/i,
+                /*num_accepted=*/chain.num_accepted(),
+                /*num_f_evals=*/chain.num_f_evals(),
+                /*num_local_search_f_evals=*/chain.num_local_search_f_evals(),
+                /*patience=*/driver.patience,
+                /*temperature_step=*/chain.temperature_step(),
+                /*num_restarts=*/driver.num_restarts,
+                /*current_func=*/workspace.current.func,
+                /*best_func=*/workspace.best.func,
+                /*best_seen=*/driver.best_seen},
+            workspace.current.x, workspace.best.x, as_bytes(generator),
+            chain.visiting_scales(), chain.coordinate_num_accepted());
+        _last_saved = i;
+    }
+};
+
+/// \brief Runs the annealing loop (without local search) in \p workspace.
+///
+/// \p on_iteration is called after each iteration of the chain (and after a
+/// possible reannealing, like \p observer) with the current workspace as
+/// argument. It allows drivers such as
+/// #minimize_parallel to peek into the state of the chain without having to
+/// duplicate the main loop. \p observer is the user-provided observer, see
+/// #is_observer_v. \p checkpoint is either #no_checkpoint_t or
+/// #checkpoint_hooks_t.
+template <class Objective, class Generator, class Workspace, class OnIteration,
+          class Observer, class Checkpoint = no_checkpoint_t>
+auto minimize_in(Objective&& obj, gsl::span<float> x,
+                 param_t const& parameters, Generator& generator,
+                 Workspace& workspace, OnIteration&& on_iteration,
+                 Observer&& observer, Checkpoint&& checkpoint = {})
+    -> result_t
+{
+    std::memcpy(workspace.current.x.data(), x.data(),
                 x.size() * sizeof(float));
-    sa_chain_t<Objective&, Generator> chain{obj, *workspace, parameters,
-                                            generator};
-    auto best     = std::numeric_limits<double>::infinity();
-    auto patience = parameters.patience;
-    for (; chain.iteration() < parameters.num_iter && patience != 0;
-         --patience) {
+    auto const* saved = checkpoint.load(workspace, generator, parameters);
+    sa_chain_t<Objective&, Generator, Workspace> chain{
+        obj, workspace, parameters, generator, saved};
+    auto driver = driver_state_t{parameters};
+    checkpoint.resume(chain, driver);
+    while (chain.iteration() < parameters.num_iter && driver.patience != 0
+           && !out_of_budget(chain, parameters)) {
+        auto const accepted = chain.num_accepted();
         chain();
-        if (workspace->best.func < best) { patience = parameters.patience; }
+        driver.update(parameters, workspace);
+        maybe_reanneal(chain, parameters, driver, x.size(),
+                       chain.num_accepted() - accepted);
+        notify(chain, workspace, on_iteration);
+        checkpoint.save(chain, workspace, generator, driver, /*force=*/false);
+        if (observe(chain, workspace, observer)) { break; }
     }
-    std::memcpy(x.data(), workspace->best.x.data(), x.size() * sizeof(float));
-    return result_t{/*func=*/workspace->best.func,
-                    /*num_iter=*/chain.iteration(),
-                    /*num_f_evals=*/chain.num_f_evals(),
-                    /*acceptance=*/chain.acceptance()};
+    checkpoint.save(chain, workspace, generator, driver, /*force=*/true);
+    chain.sync_best();
+    std::memcpy(x.data(), workspace.best.x.data(), x.size() * sizeof(float));
+    return make_result(chain, workspace, driver.num_restarts);
 }
 
-template <class Objective, class Generator>
-DA_NOINLINE auto
-minimize(Objective&& obj, gsl::span<float> x, param_t const& parameters,
-         tcm::lbfgs::lbfgs_param_t const& local_search_parameters,
-         Generator&                       generator) -> result_t
+/// Parameters of a cold L-BFGS run.
+inline auto lbfgs_params(tcm::lbfgs::lbfgs_param_t const& p) noexcept
+    -> tcm::lbfgs::lbfgs_param_t const&
+{
+    return p;
+}
+
+inline auto lbfgs_params(warm_start_param_t const& p) noexcept
+    -> tcm::lbfgs::lbfgs_param_t const&
 {
-    auto workspace = thread_local_workspace(x.size());
-    if (!workspace.has_value()) {
-        // Memory allocation failed
-        // TODO(twesterhout): Convert this to error_codes
-        throw std::bad_alloc{};
+    return p.lbfgs;
+}
+
+/// \brief Determines whether `T` defers local search like #candidate_pool_t.
+///
+/// Such policies have `due(iteration)` and `size()` member functions, and
+/// #minimize_in flushes them with #polish_candidates.
+template <class T, class = void>
+struct is_deferred_policy : std::false_type {};
+
+template <class T>
+struct is_deferred_policy<
+    T, std::void_t<decltype(std::declval<T&>().due(std::declval<size_t>())),
+                   decltype(std::declval<T&>().size())>> : std::true_type {};
+
+template <class T>
+inline constexpr auto is_deferred_policy_v =
+    is_deferred_policy<unwrap_reference_t<std::decay_t<T>>>::value;
+
+/// \brief Determines whether a combination of policies contains a deferred
+/// one.
+///
+/// Combinators only forward the call operator, so a nested
+/// #candidate_pool_t would record candidates which are never polished.
+template <class T> struct contains_deferred_policy : std::false_type {};
+
+template <class... Policies>
+struct contains_deferred_policy<all_of_t<Policies...>>
+    : std::bool_constant<(
+          (is_deferred_policy_v<Policies>
+           || contains_deferred_policy<
+               unwrap_reference_t<std::decay_t<Policies>>>::value)
+          || ...)> {};
+
+template <class T>
+inline constexpr auto contains_deferred_policy_v =
+    contains_deferred_policy<unwrap_reference_t<std::decay_t<T>>>::value;
+
+/// \brief Runs L-BFGS from all candidates in \p candidates concurrently and
+/// offers the results to \p chain.
+///
+/// Every task works with its own copy of \p obj and a cold L-BFGS, since the
+/// history of a warm start can't be shared between threads. Candidates for
+/// which L-BFGS fails are dropped. The pool is empty afterwards.
+template <class Objective, class Candidates, class Chain>
+auto polish_candidates(Objective& obj,
+                       tcm::lbfgs::lbfgs_param_t const& parameters,
+                       Candidates& candidates, Chain& chain) -> void
+{
+    auto const n           = candidates.size();
+    auto       funcs       = std::vector<double>(n);
+    auto       num_f_evals = std::vector<size_t>(n);
+    candidates.pool().for_each(n, [&](size_t const i) {
+        auto local_obj = obj;
+        auto count     = size_t{0};
+        auto const r   = tcm::lbfgs::minimize(
+            [&local_obj, &count](gsl::span<float const> y,
+                                 gsl::span<float>       g) {
+                count += gradient_cost(local_obj, y.size());
+                return do_value_and_gradient(local_obj, y, g);
+            },
+            parameters, candidates.x(i));
+        num_f_evals[i] = count;
+        funcs[i] = is_useful_local_search(r.status, r.func, candidates.func(i))
+                       ? r.func
+                       : std::numeric_limits<double>::infinity();
+    });
+    for (auto i = size_t{0}; i < n; ++i) {
+        chain.add_local_search_f_evals(num_f_evals[i]);
+        if (funcs[i] < std::numeric_limits<double>::infinity()) {
+            chain.offer(candidates.x(i), funcs[i], /*replace_current=*/true);
+        }
     }
+    candidates.clear();
+}
 
-    std::memcpy(workspace->current.x.data(), x.data(),
+/// \brief Runs the annealing loop with local search in \p workspace.
+///
+/// See the other overload for an explanation of \p on_iteration. \p policy
+/// decides which improvements are worth polishing, see
+/// #is_local_search_policy_v. A #candidate_pool_t (possibly passed as
+/// `std::ref(pool)`, but not inside a combinator such as #all_of_t) defers
+/// local search and runs it in parallel batches instead.
+template <class Objective, class LocalSearchParams, class Generator,
+          class Workspace, class OnIteration, class Observer, class Policy,
+          class Checkpoint = no_checkpoint_t>
+auto minimize_in(Objective&& obj, gsl::span<float> x,
+                 param_t const&           parameters,
+                 LocalSearchParams const& local_search_parameters,
+                 Generator& generator, Workspace& workspace,
+                 OnIteration&& on_iteration, Observer&& observer,
+                 Policy&& policy, Checkpoint&& checkpoint = {}) -> result_t
+{
+    constexpr auto is_deferred = is_deferred_policy_v<Policy>;
+    static_assert(!contains_deferred_policy_v<Policy>,
+                  "a candidate_pool_t can't be combined with other policies: "
+                  "it would never be flushed");
+    std::memcpy(workspace.current.x.data(), x.data(),
                 x.size() * sizeof(float));
-    sa_chain_t<Objective&, Generator> chain{obj, *workspace, parameters,
-                                            generator};
-    auto best     = std::numeric_limits<double>::infinity();
-    auto patience = parameters.patience;
-    auto finalise = [x, &workspace, &chain]() {
-        std::memcpy(x.data(), workspace->best.x.data(),
+    auto const* saved = checkpoint.load(workspace, generator, parameters);
+    sa_chain_t<Objective&, Generator, Workspace> chain{
+        obj, workspace, parameters, generator, saved};
+    auto driver = driver_state_t{parameters};
+    checkpoint.resume(chain, driver);
+    auto finalise = [x, &workspace, &chain, &generator, &checkpoint,
+                     &driver]() {
+        checkpoint.save(chain, workspace, generator, driver, /*force=*/true);
+        chain.sync_best();
+        std::memcpy(x.data(), workspace.best.x.data(),
                     x.size() * sizeof(float));
-        return result_t{/*func=*/workspace->best.func,
-                        /*num_iter=*/chain.iteration(),
-                        /*num_f_evals=*/chain.num_f_evals(),
-                        /*acceptance=*/chain.acceptance()};
+        return make_result(chain, workspace, driver.num_restarts);
+    };
+    // Local search always starts at `current`, so that's what policies get to
+    // see.
+    auto const should_polish = [&workspace, &chain, &policy]() {
+        return policy(local_search_candidate_t{
+            /*x=*/workspace.current.x,
+            /*func=*/workspace.current.func,
+            /*iteration=*/chain.iteration(),
+            /*num_f_evals=*/chain.num_f_evals(),
+            /*num_local_search_f_evals=*/chain.num_local_search_f_evals()});
     };
 
-    if (auto status = chain.local_search(local_search_parameters);
-        status != tcm::lbfgs::status_t::success) {
-        return finalise();
+    // A resumed run has polished its starting point already
+    if (saved == nullptr && should_polish()) {
+        if (auto status = chain.local_search(local_search_parameters);
+            status != tcm::lbfgs::status_t::success) {
+            return finalise();
+        }
     }
-    for (; chain.iteration() < parameters.num_iter && patience != 0;
-         --patience) {
+    while (chain.iteration() < parameters.num_iter && driver.patience != 0
+           && !out_of_budget(chain, parameters)) {
+        auto const accepted = chain.num_accepted();
         chain();
-        if (workspace->best.func < best) {
-            best     = workspace->best.func;
-            patience = parameters.patience;
+        if (driver.update(parameters, workspace) && should_polish()) {
             if (auto status = chain.local_search(local_search_parameters);
                 status != tcm::lbfgs::status_t::success) {
                 return finalise();
             }
         }
+        if constexpr (is_deferred) {
+            if (unwrap(policy).due(chain.iteration())) {
+                polish_candidates(obj, lbfgs_params(local_search_parameters),
+                                  unwrap(policy), chain);
+            }
+        }
+        maybe_reanneal(chain, parameters, driver, x.size(),
+                       chain.num_accepted() - accepted);
+        notify(chain, workspace, on_iteration);
+        checkpoint.save(chain, workspace, generator, driver, /*force=*/false);
+        if (observe(chain, workspace, observer)) { break; }
+    }
+    if constexpr (is_deferred) {
+        if (unwrap(policy).size() != 0) {
+            polish_candidates(obj, lbfgs_params(local_search_parameters),
+                              unwrap(policy), chain);
+        }
     }
     return finalise();
 }
 
+/// Buffers for a workspace of dimension \p size taken from \p buffers.
+inline auto workspace_from(sa_buffers_t& buffers, size_t const size)
+    -> sa_buffers_t&
+{
+    buffers.resize(size);
+    return buffers;
+}
+
+inline auto workspace_from(workspace_pool_t& pool, size_t const size)
+    -> workspace_pool_t::lease_t
+{
+    return pool.acquire(size);
+}
+
+/// \brief Implementation of #minimize without local search.
+///
+/// Same as #minimize_in except that the workspace comes from \p source
+/// (see #is_workspace_source_v).
+template <class Objective, class Generator, class OnIteration,
+          class Observer = no_observer_t,
+          class Source   = workspace_pool_t,
+          class          = std::enable_if_t<is_observer_v<Observer>>>
+auto minimize_impl(Objective&& obj, gsl::span<float> x,
+                   param_t const& parameters, Generator& generator,
+                   OnIteration&& on_iteration, Observer&& observer = {},
+                   Source& source = thread_local_pool()) -> result_t
+{
+    auto&& buffers   = workspace_from(source, x.size());
+    auto   workspace = buffers.workspace();
+    return minimize_in(std::forward<Objective>(obj), x, parameters, generator,
+                       workspace, std::forward<OnIteration>(on_iteration),
+                       std::forward<Observer>(observer));
+}
+
+/// \brief Implementation of #minimize with local search.
+///
+/// Same as #minimize_in except that the workspace comes from \p source
+/// (see #is_workspace_source_v).
+template <class Objective, class LocalSearchParams, class Generator,
+          class OnIteration, class Observer = no_observer_t,
+          class Policy = always_polish_t, class Source = workspace_pool_t,
+          class = std::enable_if_t<is_local_search_param_v<LocalSearchParams>>>
+auto minimize_impl(Objective&& obj, gsl::span<float> x,
+                   param_t const&           parameters,
+                   LocalSearchParams const& local_search_parameters,
+                   Generator& generator, OnIteration&& on_iteration,
+                   Observer&& observer = {}, Policy&& policy = {},
+                   Source& source = thread_local_pool()) -> result_t
+{
+    auto&& buffers   = workspace_from(source, x.size());
+    auto   workspace = buffers.workspace();
+    return minimize_in(std::forward<Objective>(obj), x, parameters,
+                       local_search_parameters, generator, workspace,
+                       std::forward<OnIteration>(on_iteration),
+                       std::forward<Observer>(observer),
+                       std::forward<Policy>(policy));
+}
+} // namespace detail
+
+/// \brief Minimises \p obj starting at \p x.
+///
+/// Upon return \p x contains the best point found. \p observer is called
+/// after every iteration and may stop the minimisation early (see
+/// #is_observer_v and the built-in observers in observers.hpp). Stateful
+/// observers can be passed via `std::ref`.
+template <class Objective, class Generator, class Observer = no_observer_t,
+          class = std::enable_if_t<is_observer_v<Observer>>>
+DA_NOINLINE auto minimize(Objective&& obj, gsl::span<float> x,
+                          param_t const& parameters, Generator& generator,
+                          Observer observer = {}) -> result_t
+{
+    return detail::minimize_impl(std::forward<Objective>(obj), x, parameters,
+                                 generator, detail::ignore_iteration_fn{},
+                                 observer);
+}
+
+/// \brief Same as above, but with local search.
+///
+/// \p local_search_parameters is either `tcm::lbfgs::lbfgs_param_t` or
+/// #warm_start_param_t (see #is_local_search_param_v).
+template <class Objective, class LocalSearchParams, class Generator,
+          class Observer = no_observer_t,
+          class          = std::enable_if_t<
+              is_local_search_param_v<LocalSearchParams>
+              && is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, gsl::span<float> x, param_t const& parameters,
+         LocalSearchParams const& local_search_parameters,
+         Generator& generator, Observer observer = {}) -> result_t
+{
+    return detail::minimize_impl(std::forward<Objective>(obj), x, parameters,
+                                 local_search_parameters, generator,
+                                 detail::ignore_iteration_fn{}, observer);
+}
+
+/// \brief Same as above, but \p policy decides when to run local search.
+///
+/// See #is_local_search_policy_v and the built-in policies in
+/// local_search_policy.hpp. \p policy is taken by reference, so its state
+/// (e.g. the points remembered by #min_distance_t) can be inspected
+/// afterwards.
+template <class Objective, class LocalSearchParams, class Policy,
+          class Generator, class Observer = no_observer_t,
+          class = std::enable_if_t<is_local_search_param_v<LocalSearchParams>
+                                   && is_local_search_policy_v<Policy>
+                                   && is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, gsl::span<float> x, param_t const& parameters,
+         LocalSearchParams const& local_search_parameters,
+         Policy&& policy, Generator& generator, Observer observer = {})
+    -> result_t
+{
+    return detail::minimize_impl(std::forward<Objective>(obj), x, parameters,
+                                 local_search_parameters, generator,
+                                 detail::ignore_iteration_fn{}, observer,
+                                 std::forward<Policy>(policy));
+}
+
+/// \brief Same as the overloads above, but the workspace comes from
+/// \p buffers rather than #thread_local_pool.
+///
+/// \p buffers is either an #sa_buffers_t, which is resized and reused, or a
+/// #workspace_pool_t to lease buffers from. This gives the caller control
+/// over where the memory lives and how much of it is kept around.
+template <class Objective, class Generator, class Buffers,
+          class Observer = no_observer_t,
+          class = std::enable_if_t<detail::is_workspace_source_v<Buffers>
+                                   && is_observer_v<Observer>>>
+DA_NOINLINE auto minimize(Objective&& obj, gsl::span<float> x,
+                          param_t const& parameters, Generator& generator,
+                          Buffers& buffers, Observer observer = {})
+    -> result_t
+{
+    return detail::minimize_impl(std::forward<Objective>(obj), x, parameters,
+                                 generator, detail::ignore_iteration_fn{},
+                                 observer, buffers);
+}
+
+template <class Objective, class LocalSearchParams, class Generator,
+          class Buffers, class Observer = no_observer_t,
+          class = std::enable_if_t<is_local_search_param_v<LocalSearchParams>
+                                   && detail::is_workspace_source_v<Buffers>
+                                   && is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, gsl::span<float> x, param_t const& parameters,
+         LocalSearchParams const& local_search_parameters,
+         Generator& generator, Buffers& buffers, Observer observer = {})
+    -> result_t
+{
+    return detail::minimize_impl(std::forward<Objective>(obj), x, parameters,
+                                 local_search_parameters, generator,
+                                 detail::ignore_iteration_fn{}, observer,
+                                 always_polish_t{}, buffers);
+}
+
+template <class Objective, class LocalSearchParams, class Policy,
+          class Generator, class Buffers, class Observer = no_observer_t,
+          class = std::enable_if_t<is_local_search_param_v<LocalSearchParams>
+                                   && is_local_search_policy_v<Policy>
+                                   && detail::is_workspace_source_v<Buffers>
+                                   && is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, gsl::span<float> x, param_t const& parameters,
+         LocalSearchParams const& local_search_parameters,
+         Policy&& policy, Generator& generator, Buffers& buffers,
+         Observer observer = {}) -> result_t
+{
+    return detail::minimize_impl(std::forward<Objective>(obj), x, parameters,
+                                 local_search_parameters, generator,
+                                 detail::ignore_iteration_fn{}, observer,
+                                 std::forward<Policy>(policy), buffers);
+}
+
+/// \brief Same as the overloads above, but the state is saved to
+/// \p checkpoint every `checkpoint.interval()` iterations and when the
+/// minimisation ends.
+///
+/// If the checkpoint file already holds a state of a run with the same
+/// dimension, generator type, and `q_V`, `q_A`, `t_0`, the minimisation
+/// continues from it (ignoring the contents of \p x and the state of
+/// \p generator) and follows the same trajectory as if it had never been
+/// interrupted. See #checkpoint_t for what isn't saved.
+template <class Objective, class Generator, class Observer = no_observer_t,
+          class = std::enable_if_t<is_observer_v<Observer>>>
+DA_NOINLINE auto minimize(Objective&& obj, gsl::span<float> x,
+                          param_t const& parameters, Generator& generator,
+                          checkpoint_t& checkpoint, Observer observer = {})
+    -> result_t
+{
+    auto&& buffers   = detail::workspace_from(thread_local_pool(), x.size());
+    auto   workspace = buffers.workspace();
+    return detail::minimize_in(std::forward<Objective>(obj), x, parameters,
+                               generator, workspace,
+                               detail::ignore_iteration_fn{}, observer,
+                               detail::checkpoint_hooks_t{checkpoint});
+}
+
+template <class Objective, class LocalSearchParams, class Generator,
+          class Observer = no_observer_t,
+          class          = std::enable_if_t<
+              is_local_search_param_v<LocalSearchParams>
+              && is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, gsl::span<float> x, param_t const& parameters,
+         LocalSearchParams const& local_search_parameters,
+         Generator& generator, checkpoint_t& checkpoint,
+         Observer observer = {}) -> result_t
+{
+    auto&& buffers   = detail::workspace_from(thread_local_pool(), x.size());
+    auto   workspace = buffers.workspace();
+    return detail::minimize_in(std::forward<Objective>(obj), x, parameters,
+                               local_search_parameters, generator, workspace,
+                               detail::ignore_iteration_fn{}, observer,
+                               always_polish_t{},
+                               detail::checkpoint_hooks_t{checkpoint});
+}
+
+/// \brief Overload for problems whose dimension \p N is known at compile time.
+///
+/// All state of the chain lives on the stack: there are no heap allocations
+/// or thread-local lookups, and loops over coordinates have a constant trip
+/// count. Use it for small problems where the overhead of #workspace_t
+/// dominates the cost of the objective.
+template <class Objective, class Generator, size_t N,
+          class Observer = no_observer_t,
+          class          = std::enable_if_t<is_observer_v<Observer>>>
+DA_NOINLINE auto minimize(Objective&& obj, std::array<float, N>& x,
+                          param_t const& parameters, Generator& generator,
+                          Observer observer = {}) -> result_t
+{
+    fixed_workspace_t<N> workspace;
+    return detail::minimize_in(std::forward<Objective>(obj),
+                               gsl::span<float>{x}, parameters, generator,
+                               workspace, detail::ignore_iteration_fn{},
+                               observer);
+}
+
+template <class Objective, class LocalSearchParams, class Generator, size_t N,
+          class Observer = no_observer_t,
+          class          = std::enable_if_t<
+              is_local_search_param_v<LocalSearchParams>
+              && is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, std::array<float, N>& x, param_t const& parameters,
+         LocalSearchParams const& local_search_parameters,
+         Generator& generator, Observer observer = {}) -> result_t
+{
+    fixed_workspace_t<N> workspace;
+    return detail::minimize_in(std::forward<Objective>(obj),
+                               gsl::span<float>{x}, parameters,
+                               local_search_parameters, generator, workspace,
+                               detail::ignore_iteration_fn{}, observer,
+                               always_polish_t{});
+}
+
+template <class Objective, class LocalSearchParams, class Policy,
+          class Generator, size_t N, class Observer = no_observer_t,
+          class = std::enable_if_t<is_local_search_param_v<LocalSearchParams>
+                                   && is_local_search_policy_v<Policy>
+                                   && is_observer_v<Observer>>>
+DA_NOINLINE auto
+minimize(Objective&& obj, std::array<float, N>& x, param_t const& parameters,
+         LocalSearchParams const& local_search_parameters,
+         Policy&& policy, Generator& generator, Observer observer = {})
+    -> result_t
+{
+    fixed_workspace_t<N> workspace;
+    return detail::minimize_in(std::forward<Objective>(obj),
+                               gsl::span<float>{x}, parameters,
+                               local_search_parameters, generator, workspace,
+                               detail::ignore_iteration_fn{}, observer,
+                               std::forward<Policy>(policy));
+}
+
 DA_NAMESPACE_END
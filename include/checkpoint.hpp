@@ -0,0 +1,151 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file checkpoint.hpp
+/// \brief Saving the state of a chain to disk and resuming from it.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cstddef> // size_t, std::byte
+#include <cstdint> // uint64_t
+#include <memory>  // std::unique_ptr
+#include <string>  // std::string
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// \brief Shape of the state stored in a #checkpoint_t.
+///
+/// A checkpoint can only be resumed by a run with the same layout.
+struct checkpoint_layout_t {
+    size_t dim;            ///< Number of coordinates
+    size_t generator_size; ///< `sizeof` of the random number generator
+    float  q_V;
+    float  q_A;
+    float  t_0;
+    /// Number of adaptive visiting scales (see #param_t::target_acceptance):
+    /// `dim` if adaptive visiting is enabled and `0` otherwise.
+    size_t num_scales = 0;
+};
+
+/// \brief Scalar state of a chain and of the loop driving it.
+///
+/// Together with `current.x`, `best.x`, and the random number generator this
+/// is everything #minimize needs to continue the same trajectory.
+struct checkpoint_state_t {
+    std::uint64_t iteration;                ///< Number of finished iterations
+    std::uint64_t num_accepted;             ///< Accepted moves so far
+    std::uint64_t num_f_evals;              ///< Function evaluations so far
+    std::uint64_t num_local_search_f_evals; ///< Part of the above due to L-BFGS
+    std::uint64_t patience;                 ///< Remaining patience
+    std::uint64_t temperature_step;         ///< Iterations since reannealing
+    std::uint64_t num_restarts;             ///< Reannealings so far
+    double        current_func;             ///< Function value at `current.x`
+    double        best_func;                ///< Function value at `best.x`
+    /// Best value the driver has reacted to (e.g. by resetting patience).
+    double best_seen;
+};
+
+/// \brief A checkpoint file of a single chain.
+///
+/// The file is memory-mapped and holds a versioned header and two slots.
+/// Saves alternate between the slots, and each slot carries a sequence number
+/// and a checksum, so a save which was interrupted (e.g. because the machine
+/// was pre-empted) never destroys the previous one. Saving copies the state
+/// into the mapping and asks the kernel to write the dirty pages back
+/// asynchronously, i.e. the chain doesn't wait for the disk.
+///
+/// Pass it to #minimize to save the state every #interval iterations. If the
+/// file already holds a state of a run with the same #checkpoint_layout_t,
+/// #minimize resumes from it instead of starting at `x`.
+///
+/// \note The random number generator is stored as raw bytes. Resuming thus
+/// requires the same generator type and a binary built for the same platform.
+/// Observers, local search policies and the history of warm-started L-BFGS
+/// are not part of the checkpoint.
+class checkpoint_t {
+  public:
+    /// \brief Checkpoints stored at \p path, saved every \p interval
+    /// iterations.
+    ///
+    /// The file is only opened (or created) by #open.
+    explicit checkpoint_t(std::string path, size_t interval = 100);
+    ~checkpoint_t() noexcept;
+
+    checkpoint_t(checkpoint_t const&) = delete;
+    checkpoint_t(checkpoint_t&&) noexcept;
+    auto operator=(checkpoint_t const&) -> checkpoint_t& = delete;
+    auto operator=(checkpoint_t&&) noexcept -> checkpoint_t&;
+
+    [[nodiscard]] auto path() const noexcept -> std::string const&;
+    [[nodiscard]] auto interval() const noexcept -> size_t;
+    /// Number of saves since the checkpoint was opened.
+    [[nodiscard]] auto num_saved() const noexcept -> size_t;
+    /// Whether #open found a state to resume from.
+    [[nodiscard]] auto resumed() const noexcept -> bool;
+
+    /// \brief Maps the file, creating it if necessary.
+    ///
+    /// Returns whether the file holds a valid state. Throws
+    /// `std::runtime_error` if the file can't be opened or belongs to a run
+    /// with a different \p layout.
+    auto open(checkpoint_layout_t const& layout) -> bool;
+
+    /// \brief Copies the newest valid state into the arguments.
+    ///
+    /// Requires that #open returned `true`. \p scales and
+    /// \p scale_num_accepted must have `num_scales` elements, see
+    /// #checkpoint_layout_t.
+    auto load(checkpoint_state_t& state, gsl::span<float> current,
+              gsl::span<float> best, gsl::span<std::byte> generator,
+              gsl::span<float>  scales             = {},
+              gsl::span<size_t> scale_num_accepted = {}) const -> void;
+
+    /// Writes a new state to the file.
+    auto save(checkpoint_state_t const& state, gsl::span<float const> current,
+              gsl::span<float const> best,
+              gsl::span<std::byte const> generator,
+              gsl::span<float const>     scales             = {},
+              gsl::span<size_t const>    scale_num_accepted = {}) -> void;
+
+    /// \brief Flushes and unmaps the file.
+    ///
+    /// Blocks until all saves have reached the disk.
+    auto close() -> void;
+
+  private:
+    struct impl_t;
+    std::string             _path;
+    size_t                  _interval;
+    std::unique_ptr<impl_t> _impl;
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -68,6 +68,16 @@
 #    define DUAL_ANNEALING_RESTRICT __restrict__
 #endif
 
+// Function multi-versioning: the compiler generates one clone of the function
+// for each of the listed instruction sets and the dynamic loader picks the
+// best one for the CPU we are running on. This relies on ifunc support, so we
+// only enable it on x86-64 Linux.
+#if !defined(_MSV_VER) && defined(__x86_64__) && defined(__linux__)
+#    define DA_TARGET_CLONES(...) __attribute__((target_clones(__VA_ARGS__)))
+#else
+#    define DA_TARGET_CLONES(...)
+#endif
+
 #if defined(NDEBUG)
 #    define TCM_CONSTEXPR constexpr
 #else
@@ -83,10 +93,29 @@
 #define DA_NAMESPACE_END }             // namespace dual_annealing
 #define DUAL_ANNEALING_NAMESPACE_END } // namespace dual_annealing
 
-#include <cstdio>
-#define DUAL_ANNEALING_TRACE(fmt, ...)                                         \
-    do {                                                                       \
-        ::std::fprintf(                                                        \
-            stderr, "\x1b[1m\x1b[97m%s:%i:\x1b[0m \x1b[90mtrace:\x1b[0m " fmt, \
-            __FILE__, __LINE__, __VA_ARGS__);                                  \
-    } while (false)
+// Instrumentation levels, see instrumentation.hpp. The level is selected at
+// compile time by defining DA_INSTRUMENTATION to one of these values.
+#define DA_INSTRUMENTATION_OFF 0
+#define DA_INSTRUMENTATION_COUNTERS 1
+#define DA_INSTRUMENTATION_EVENTS 2
+
+#if !defined(DA_INSTRUMENTATION)
+#    define DA_INSTRUMENTATION DA_INSTRUMENTATION_OFF
+#endif
+
+// Trace messages are written to stderr from the innermost loops, so they are
+// only compiled in when explicitly requested.
+#if defined(DA_TRACE) && DA_TRACE
+#    include <cstdio>
+#    define DUAL_ANNEALING_TRACE(fmt, ...)                                     \
+        do {                                                                   \
+            ::std::fprintf(stderr,                                             \
+                           "\x1b[1m\x1b[97m%s:%i:\x1b[0m "                     \
+                           "\x1b[90mtrace:\x1b[0m " fmt,                       \
+                           __FILE__, __LINE__, __VA_ARGS__);                   \
+        } while (false)
+#else
+#    define DUAL_ANNEALING_TRACE(fmt, ...)                                     \
+        do {                                                                   \
+        } while (false)
+#endif
@@ -0,0 +1,195 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file dual_annealing.h
+/// \brief C interface of the precompiled annealing engine.
+///
+/// The engine lives in the `dual_annealing` shared library, so neither C nor
+/// C++ callers need to include (and instantiate) the templates of
+/// chain.hpp. The objective is passed as a table of function pointers, and
+/// all buffers are owned by the caller and used in place.
+///
+/// Structs of this header never change within an #DA_ABI_VERSION. Functions
+/// don't throw: they return a #da_status_t and #da_last_error describes the
+/// last failure of the calling thread.
+
+#ifndef DUAL_ANNEALING_H
+#define DUAL_ANNEALING_H
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DA_ABI_VERSION 1
+
+typedef enum da_status {
+    DA_SUCCESS          = 0,
+    DA_INVALID_ARGUMENT = 1, ///< E.g. a `NULL` pointer or a wrong dimension
+    DA_OUT_OF_MEMORY    = 2,
+    DA_RUNTIME_ERROR    = 3, ///< Any other error inside of the engine
+} da_status_t;
+
+typedef enum da_boundary {
+    DA_BOUNDARY_PERIODIC   = 0,
+    DA_BOUNDARY_REFLECTING = 1,
+} da_boundary_t;
+
+/// \brief An objective as a table of callbacks.
+///
+/// Only #value is required. The others are optional (`NULL`):
+///   * without #value_from_diff the engine evaluates single-coordinate moves
+///     with #value;
+///   * without #value_and_gradient local search uses forward differences;
+///   * without #value_batch batches (see da_param_t::batch_size) are
+///     evaluated point by point with #value;
+///   * #lower and #upper describe a box (see `box_bounds_t`) which replaces
+///     #wrap. Without both of them, #wrap maps a coordinate back into the
+///     domain, and without #wrap the domain is unbounded.
+typedef struct da_objective {
+    void* context; ///< Passed as the first argument to all callbacks
+    double (*value)(void* context, float const* x, size_t dim);
+    /// Value at `x` with `x[i]` replaced by `x_i`, given that the value at
+    /// `x` is `func`.
+    double (*value_from_diff)(void* context, float const* x, size_t dim,
+                              double func, size_t i, float x_i);
+    /// Value at `x`, storing the gradient in `gradient`.
+    double (*value_and_gradient)(void* context, float const* x,
+                                 float* gradient, size_t dim);
+    /// Values of the `n` points stored row by row in `xs`, written to `out`.
+    void (*value_batch)(void* context, float const* xs, size_t n, size_t dim,
+                        double* out);
+    float (*wrap)(void* context, float x);
+    float const*  lower; ///< `dim` lower bounds, or `NULL`
+    float const*  upper; ///< `dim` upper bounds, or `NULL`
+    da_boundary_t boundary;
+} da_objective_t;
+
+/// Hyper-parameters, see `param_t`. Use #da_param_init for the defaults.
+typedef struct da_param {
+    float    q_V;
+    float    q_A;
+    float    t_0;
+    uint64_t num_iter;
+    uint64_t patience;
+    uint64_t batch_size; ///< See da_objective_t::value_batch
+    uint64_t block_size;
+    uint64_t max_restarts;
+    float    restart_temp_ratio;
+    float    min_acceptance;
+    int      restart_from_random; ///< Non-zero: fresh points, otherwise best
+    uint64_t max_f_evals;
+    float    target_acceptance;
+    float    scale_adaptation_rate;
+} da_param_t;
+
+/// Parameters of L-BFGS local search.
+typedef struct da_local_search_param {
+    uint64_t m;        ///< Number of corrections kept
+    float    epsilon;  ///< Tolerance of the gradient norm
+    uint64_t max_iter; ///< `0` means no limit
+} da_local_search_param_t;
+
+/// State passed to #da_observer_t after every iteration.
+typedef struct da_iteration_info {
+    uint64_t iteration;
+    double   current_func;
+    double   best_func;
+    uint64_t num_f_evals;
+    double   acceptance;
+    float    t_V;
+} da_iteration_info_t;
+
+typedef struct da_observer {
+    void* context;
+    /// Returns non-zero to stop the minimisation.
+    int (*callback)(void* context, da_iteration_info_t const* info);
+} da_observer_t;
+
+typedef struct da_result {
+    double   func;
+    uint64_t num_iter;
+    uint64_t num_f_evals;
+    double   acceptance;
+    uint64_t num_local_search_f_evals;
+    uint64_t num_restarts;
+    uint64_t num_accepted;
+} da_result_t;
+
+typedef enum da_generator_kind {
+    DA_GENERATOR_PCG32  = 0,
+    DA_GENERATOR_PCG64  = 1,
+    DA_GENERATOR_PHILOX = 2, ///< `philox4x32_t`
+} da_generator_kind_t;
+
+/// Opaque random number generator, created by #da_generator_create.
+typedef struct da_generator da_generator_t;
+
+/// Returns the #DA_ABI_VERSION the library was built with.
+int da_abi_version(void);
+
+/// Describes the last failure on the calling thread. Never `NULL`.
+char const* da_last_error(void);
+
+/// Fills \p params with the defaults of `param_t` and SciPy's `q_V`, `q_A`
+/// and `t_0`.
+void da_param_init(da_param_t* params);
+void da_local_search_param_init(da_local_search_param_t* params);
+
+/// \brief Creates generator \p kind for stream \p stream of \p seed.
+///
+/// Returns `NULL` on failure.
+da_generator_t* da_generator_create(da_generator_kind_t kind, uint64_t seed,
+                                    uint64_t stream);
+void da_generator_destroy(da_generator_t* generator);
+
+/// Number of floats #da_minimize needs as workspace for dimension \p dim.
+size_t da_workspace_size(size_t dim);
+
+/// \brief Minimises \p objective starting at \p x.
+///
+/// Upon success \p x (of length \p dim) contains the best point found. The
+/// arguments \p local_search (no local search), \p observer, \p workspace
+/// (a thread-local pool is used instead) and \p result may be `NULL`. If
+/// given, \p workspace must hold #da_workspace_size floats. The generator
+/// continues from its current state, so successive calls see different
+/// random numbers.
+da_status_t da_minimize(da_objective_t const* objective, float* x, size_t dim,
+                        da_param_t const*              params,
+                        da_local_search_param_t const* local_search,
+                        da_generator_t*                generator,
+                        da_observer_t const*           observer,
+                        float* workspace, da_result_t* result);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // DUAL_ANNEALING_H
@@ -0,0 +1,167 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file evaluation_cache.hpp
+/// \brief A bounded cache of function values for expensive objectives.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cstddef>     // size_t
+#include <memory>      // std::unique_ptr
+#include <optional>    // std::optional
+#include <type_traits> // std::true_type, std::false_type, std::void_t
+#include <utility>     // std::declval, std::move
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// Parameters of #evaluation_cache_t.
+struct evaluation_cache_param_t {
+    /// Maximal number of points kept. The least recently used one is evicted
+    /// when the cache is full.
+    size_t capacity = 1024;
+    /// \brief Quantisation step.
+    ///
+    /// Points whose coordinates round to the same multiples of `tolerance`
+    /// share a function value. `0` means that only bitwise identical points
+    /// (up to the sign of zeros) do.
+    float tolerance = 0.0f;
+};
+
+/// Hit and miss counts of an #evaluation_cache_t.
+struct cache_counters_t {
+    size_t hits;
+    size_t misses;
+};
+
+/// \brief A least-recently-used cache of function values keyed by quantised
+/// points.
+///
+/// Lookups hash the quantised point and compare it against the stored key,
+/// so they cost `O(dim)`. This only pays off for objectives which are much
+/// more expensive than that. It is not thread-safe.
+///
+/// \note Copies start out empty (but with the same parameters), such that
+/// per-chain copies of an objective (e.g. in #minimize_parallel) don't share
+/// or duplicate entries. A moved-from cache is empty and still usable.
+class evaluation_cache_t {
+  public:
+    explicit evaluation_cache_t(evaluation_cache_param_t const& params = {});
+    ~evaluation_cache_t() noexcept;
+
+    evaluation_cache_t(evaluation_cache_t const& other);
+    evaluation_cache_t(evaluation_cache_t&&) noexcept;
+    auto operator=(evaluation_cache_t const& other) -> evaluation_cache_t&;
+    auto operator=(evaluation_cache_t&&) noexcept -> evaluation_cache_t&;
+
+    [[nodiscard]] auto params() const noexcept
+        -> evaluation_cache_param_t const&;
+    /// Number of points currently stored.
+    [[nodiscard]] auto size() const noexcept -> size_t;
+    [[nodiscard]] auto counters() const noexcept -> cache_counters_t;
+
+    /// Returns the function value at \p x if it is cached. Counts as a hit or
+    /// a miss.
+    auto find(gsl::span<float const> x) -> std::optional<double>;
+
+    /// Stores \p func as the function value at \p x, evicting the least
+    /// recently used entry if the cache is full.
+    auto insert(gsl::span<float const> x, double func) -> void;
+
+    /// Removes all entries. Counters are kept.
+    auto clear() noexcept -> void;
+
+  private:
+    struct impl_t;
+    evaluation_cache_param_t _params;
+    cache_counters_t         _counters;
+    std::unique_ptr<impl_t>  _impl; ///< `nullptr` after a move
+};
+
+namespace detail {
+/// \brief Determines whether `T` has a member function `cache_counters`
+/// returning a #cache_counters_t.
+template <class T, class = void>
+struct has_cache_counters_mem_fn : std::false_type {};
+
+template <class T>
+struct has_cache_counters_mem_fn<
+    T, std::void_t<decltype(static_cast<cache_counters_t>(
+           std::declval<T>().cache_counters()))>> : std::true_type {};
+
+template <class T>
+inline constexpr auto has_cache_counters_mem_fn_v =
+    has_cache_counters_mem_fn<T>::value;
+} // namespace detail
+
+/// \brief Puts an #evaluation_cache_t in front of `value` of \p Objective.
+///
+/// All other member functions (`wrap`, `value_from_diff`, `value_batch`, the
+/// incremental evaluation protocol, ...) are inherited from \p Objective and
+/// bypass the cache. Forward-difference gradients (see
+/// #finite_difference_t) go through `value`, so the starting point of a
+/// local search which the chain has evaluated before is a hit. The chain
+/// reports the counters in #result_t.
+template <class Objective> class cached_objective_t : public Objective {
+    evaluation_cache_t _cache;
+
+  public:
+    explicit cached_objective_t(Objective                       obj,
+                                evaluation_cache_param_t const& params = {})
+        : Objective{std::move(obj)}, _cache{params}
+    {}
+
+    auto value(gsl::span<float const> x) -> double
+    {
+        if (auto const func = _cache.find(x); func.has_value()) {
+            return *func;
+        }
+        auto const func = static_cast<double>(Objective::value(x));
+        _cache.insert(x, func);
+        return func;
+    }
+
+    [[nodiscard]] auto cache_counters() const noexcept -> cache_counters_t
+    {
+        return _cache.counters();
+    }
+
+    [[nodiscard]] auto cache() noexcept -> evaluation_cache_t&
+    {
+        return _cache;
+    }
+    [[nodiscard]] auto cache() const noexcept -> evaluation_cache_t const&
+    {
+        return _cache;
+    }
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -0,0 +1,293 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include "config.hpp"
+#include "objective.hpp"
+#include "thread_pool.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>   // std::min, std::max
+#include <cmath>       // std::abs, std::sqrt, std::cbrt, std::nextafter
+#include <cstddef>     // size_t
+#include <cstring>     // std::memcpy
+#include <limits>      // std::numeric_limits
+#include <type_traits> // std::true_type, std::false_type, std::void_t
+#include <utility>     // std::declval, std::move
+#include <vector>      // std::vector
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+enum class difference_scheme_t {
+    forward, ///< `(f(x + h) - f(x)) / h`, costs `dim + 1` evaluations
+    central, ///< `(f(x + h) - f(x - h)) / 2h`, costs `2 dim + 1` evaluations
+};
+
+/// Parameters of the finite-difference gradient, see #finite_difference_t.
+struct finite_difference_param_t {
+    difference_scheme_t scheme = difference_scheme_t::forward;
+    /// \brief Step relative to `max(1, |x_i|)`.
+    ///
+    /// `0` picks the usual optimum for the scheme: `sqrt(eps)` for forward and
+    /// `cbrt(eps)` for central differences, where `eps` is the machine epsilon
+    /// of `float`.
+    float relative_step = 0.0f;
+    /// \brief Pool to distribute the evaluations over, or `nullptr`.
+    ///
+    /// The objective's `value` is then called concurrently, so it must be
+    /// thread-safe. Ignored if the objective has `value_batch` (see
+    /// #detail::has_value_batch_mem_fn): the batched hook is used instead.
+    thread_pool_t* pool = nullptr;
+};
+
+namespace detail {
+/// \brief Determines whether `T` has a member function `value_and_gradient`
+/// which can be called with `gsl::span<float const>` and `gsl::span<float>`.
+template <class T, class = void>
+struct has_value_and_gradient_mem_fn : std::false_type {};
+
+template <class T>
+struct has_value_and_gradient_mem_fn<
+    T, std::void_t<decltype(std::declval<T>().value_and_gradient(
+           std::declval<gsl::span<float const>>(),
+           std::declval<gsl::span<float>>()))>> : std::true_type {};
+
+template <class T>
+inline constexpr auto has_value_and_gradient_mem_fn_v =
+    has_value_and_gradient_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `gradient_cost` which
+/// can be called with `size_t`.
+///
+/// `t.gradient_cost(dim)` returns how many function evaluations one call to
+/// `t.value_and_gradient` costs. Objectives without it are assumed to compute
+/// analytic gradients at the cost of one evaluation.
+template <class T, class = void>
+struct has_gradient_cost_mem_fn : std::false_type {};
+
+template <class T>
+struct has_gradient_cost_mem_fn<
+    T, std::void_t<decltype(static_cast<size_t>(
+           std::declval<T>().gradient_cost(std::declval<size_t>())))>>
+    : std::true_type {};
+
+template <class T>
+inline constexpr auto has_gradient_cost_mem_fn_v =
+    has_gradient_cost_mem_fn<T>::value;
+
+/// Number of function evaluations done by one finite-difference gradient.
+constexpr auto finite_difference_cost(difference_scheme_t const scheme,
+                                      size_t const dim) noexcept -> size_t
+{
+    return scheme == difference_scheme_t::forward ? dim + 1 : 2 * dim + 1;
+}
+
+/// Scratch space of #finite_difference_gradient, reused between calls.
+struct finite_difference_scratch_t {
+    std::vector<float>  xs;    ///< Points to evaluate
+    std::vector<double> funcs; ///< Function values at `xs`
+};
+
+inline auto finite_difference_scratch() -> finite_difference_scratch_t&
+{
+    static thread_local finite_difference_scratch_t scratch;
+    return scratch;
+}
+
+/// \brief Estimates the gradient of \p obj at \p x using finite differences.
+///
+/// Stores the result in \p g and returns `obj.value(x)`. Evaluations go
+/// through `value_batch` if \p obj has it, otherwise they are distributed
+/// over `params.pool` (if any).
+template <class Objective>
+auto finite_difference_gradient(Objective& obj, gsl::span<float const> x,
+                                gsl::span<float>                 g,
+                                finite_difference_param_t const& params)
+    -> double
+{
+    constexpr auto epsilon = std::numeric_limits<float>::epsilon();
+    auto const     dim     = x.size();
+    auto const     central = params.scheme == difference_scheme_t::central;
+    auto const     relative_step =
+        params.relative_step > 0.0f
+            ? params.relative_step
+            : (central ? std::cbrt(epsilon) : std::sqrt(epsilon));
+    // `g` holds the steps until it's overwritten with the derivatives. Using
+    // `(x + h) - x` rather than `h` accounts for the rounding of `x + h`.
+    for (auto i = size_t{0}; i < dim; ++i) {
+        auto const h = relative_step * std::max(1.0f, std::abs(x[i]));
+        auto       y = x[i] + h;
+        if (y == x[i]) {
+            y = std::nextafter(x[i], std::numeric_limits<float>::infinity());
+        }
+        g[i] = y - x[i];
+    }
+    auto const derivative = [central](double const f_0, double const f_plus,
+                                      double const f_minus, float const h) {
+        return static_cast<float>(central ? (f_plus - f_minus) / (2.0 * h)
+                                          : (f_plus - f_0) / h);
+    };
+
+    auto& scratch = finite_difference_scratch();
+    if constexpr (has_value_batch_mem_fn_v<Objective&>) {
+        // Point 0 is `x`, points `1 + i` are `x + h_i e_i` and (for central
+        // differences) points `1 + dim + i` are `x - h_i e_i`. They are
+        // evaluated in blocks to keep memory usage at O(dim).
+        constexpr auto block_floats = size_t{1} << 16U;
+        auto const     n = finite_difference_cost(params.scheme, dim);
+        auto const     block_size = std::max<size_t>(block_floats / dim, 1);
+        scratch.funcs.resize(n);
+        for (auto first = size_t{0}; first < n; first += block_size) {
+            auto const count = std::min(block_size, n - first);
+            scratch.xs.resize(count * dim);
+            for (auto r = size_t{0}; r < count; ++r) {
+                auto* row = scratch.xs.data() + r * dim;
+                std::memcpy(row, x.data(), dim * sizeof(float));
+                if (auto const k = first + r; k > 0) {
+                    auto const i = (k - 1) % dim;
+                    row[i]       = k <= dim ? x[i] + g[i] : x[i] - g[i];
+                }
+            }
+            obj.value_batch(
+                gsl::span<float const>{scratch.xs.data(), count * dim}, count,
+                gsl::span<double>{scratch.funcs.data() + first, count});
+        }
+        auto const* funcs = scratch.funcs.data();
+        for (auto i = size_t{0}; i < dim; ++i) {
+            g[i] = derivative(funcs[0], funcs[1 + i],
+                              central ? funcs[1 + dim + i] : 0.0, g[i]);
+        }
+        return funcs[0];
+    }
+    else {
+        auto const f_0 = static_cast<double>(obj.value(x));
+        // Processes coordinates [first, last) using y as a copy of x.
+        auto const run = [&obj, x, g, f_0, central,
+                          &derivative](float* y, size_t const first,
+                                       size_t const last) {
+            for (auto i = first; i < last; ++i) {
+                auto const h = g[i];
+                y[i]         = x[i] + h;
+                auto const f_plus = static_cast<double>(
+                    obj.value(gsl::span<float const>{y, x.size()}));
+                auto f_minus = 0.0;
+                if (central) {
+                    y[i]    = x[i] - h;
+                    f_minus = static_cast<double>(
+                        obj.value(gsl::span<float const>{y, x.size()}));
+                }
+                y[i] = x[i];
+                g[i] = derivative(f_0, f_plus, f_minus, h);
+            }
+        };
+        if (params.pool != nullptr && params.pool->num_threads() > 1) {
+            auto const num_tasks = std::min(params.pool->num_threads(), dim);
+            params.pool->for_each(num_tasks, [&run, x, num_tasks,
+                                              dim](size_t const t) {
+                auto y = std::vector<float>(x.begin(), x.end());
+                run(y.data(), t * dim / num_tasks, (t + 1) * dim / num_tasks);
+            });
+        }
+        else {
+            scratch.xs.assign(x.begin(), x.end());
+            run(scratch.xs.data(), 0, dim);
+        }
+        return f_0;
+    }
+}
+
+/// \brief Calls `obj.value_and_gradient` if \p obj has it and falls back to
+/// forward differences otherwise.
+template <class Objective>
+auto do_value_and_gradient(Objective& obj, gsl::span<float const> x,
+                           gsl::span<float> g) -> double
+{
+    if constexpr (has_value_and_gradient_mem_fn_v<
+                      unwrap_reference_t<Objective>&>) {
+        return static_cast<double>(unwrap(obj).value_and_gradient(x, g));
+    }
+    else {
+        return finite_difference_gradient(unwrap(obj), x, g,
+                                          finite_difference_param_t{});
+    }
+}
+
+/// Number of function evaluations done by `do_value_and_gradient(obj, x, g)`
+/// when `x.size() == dim`.
+template <class Objective>
+constexpr auto gradient_cost(Objective& obj, size_t const dim) -> size_t
+{
+    using T = unwrap_reference_t<Objective>&;
+    if constexpr (has_gradient_cost_mem_fn_v<T>) {
+        return static_cast<size_t>(unwrap(obj).gradient_cost(dim));
+    }
+    else if constexpr (has_value_and_gradient_mem_fn_v<T>) {
+        return 1;
+    }
+    else {
+        return finite_difference_cost(difference_scheme_t::forward, dim);
+    }
+}
+} // namespace detail
+
+/// \brief Adds a finite-difference `value_and_gradient` to \p Objective.
+///
+/// Objectives without `value_and_gradient` get forward differences
+/// automatically when used with local search. Wrap them in this class to
+/// choose the scheme, the step, or a thread pool. All other member functions
+/// (`wrap`, `value_batch`, the incremental evaluation protocol, ...) are
+/// inherited from \p Objective.
+///
+/// \note Perturbed points are not passed through `wrap`, so they may lie
+/// slightly outside of the domain.
+template <class Objective>
+class finite_difference_t : public Objective {
+    finite_difference_param_t _finite_difference_params;
+
+  public:
+    explicit finite_difference_t(Objective                 obj,
+                                 finite_difference_param_t params = {})
+        : Objective{std::move(obj)}, _finite_difference_params{params}
+    {}
+
+    auto value_and_gradient(gsl::span<float const> x, gsl::span<float> g)
+        -> double
+    {
+        return detail::finite_difference_gradient(
+            static_cast<Objective&>(*this), x, g, _finite_difference_params);
+    }
+
+    constexpr auto gradient_cost(size_t const dim) const noexcept -> size_t
+    {
+        return detail::finite_difference_cost(
+            _finite_difference_params.scheme, dim);
+    }
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -0,0 +1,302 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <array>   // std::array
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::steady_clock
+#include <cstddef> // size_t
+#include <cstdint> // std::uint64_t, std::uint32_t
+#include <memory>  // std::unique_ptr
+
+/// \file instrumentation.hpp
+/// \brief Optional profiling of the annealing chains.
+///
+/// The amount of instrumentation is selected at compile time via the
+/// `DA_INSTRUMENTATION` macro:
+///
+///   * `DA_INSTRUMENTATION_OFF` (default): nothing is recorded and all hooks
+///     compile to nothing;
+///   * `DA_INSTRUMENTATION_COUNTERS`: every chain accumulates per-phase
+///     timings and acceptance counts (see #chain_counters_t). After each
+///     iteration they are added to process-wide totals which can be read with
+///     #global_counters;
+///   * `DA_INSTRUMENTATION_EVENTS`: additionally, one #event_t per phase and
+///     iteration is pushed into #global_event_log.
+///
+/// Neither level ever blocks the chain: counters are published with relaxed
+/// atomic additions and events are dropped when the log is full.
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// Parts of an iteration which are timed separately.
+enum class phase_t : std::uint8_t {
+    full_visits   = 0, ///< Markov chain over full-dimensional moves
+    single_visits = 1, ///< Markov chain over single-coordinate moves
+    local_search  = 2, ///< L-BFGS
+    evaluation    = 3, ///< Calls to the objective function
+};
+
+inline constexpr size_t num_phases = 4;
+
+/// \brief Statistics of one #phase_t.
+///
+/// \note Phases nest: time spent evaluating the objective during full visits
+/// is counted both in #phase_t::full_visits and #phase_t::evaluation.
+struct phase_counters_t {
+    std::uint64_t time_ns;       ///< Total wall-clock time
+    std::uint64_t count;         ///< Number of times the phase was entered
+    std::uint64_t num_accepted;  ///< Number of accepted moves
+    std::uint64_t num_attempted; ///< Number of proposed moves
+};
+
+struct chain_counters_t {
+    std::array<phase_counters_t, num_phases> phases;
+
+    constexpr auto operator[](phase_t const phase) noexcept
+        -> phase_counters_t&
+    {
+        return phases[static_cast<size_t>(phase)];
+    }
+
+    constexpr auto operator[](phase_t const phase) const noexcept
+        -> phase_counters_t const&
+    {
+        return phases[static_cast<size_t>(phase)];
+    }
+};
+
+/// \brief Process-wide totals of the counters of all chains.
+///
+/// Only non-zero when compiled with `DA_INSTRUMENTATION_COUNTERS` or higher.
+auto global_counters() noexcept -> chain_counters_t;
+
+/// Sets the process-wide counters to zero.
+auto reset_global_counters() noexcept -> void;
+
+/// One phase of one iteration of a chain.
+struct event_t {
+    std::uint64_t source;        ///< Unique id of the chain
+    std::uint64_t iteration;     ///< Iteration of the chain
+    std::uint64_t start_ns;      ///< Start time, see #detail::timestamp
+    std::uint64_t duration_ns;   ///< Wall-clock time
+    std::uint32_t num_accepted;  ///< Number of accepted moves
+    std::uint32_t num_attempted; ///< Number of proposed moves or evaluations
+    phase_t       phase;
+};
+
+/// \brief Bounded lock-free queue of events.
+///
+/// Any number of threads may push and pop concurrently. Neither operation
+/// ever blocks: #try_push fails if the queue is full and #try_pop fails if it
+/// is empty.
+class event_log_t {
+  public:
+    /// Creates a queue which can hold at least \p capacity events.
+    explicit event_log_t(size_t capacity);
+    ~event_log_t() noexcept;
+
+    event_log_t(event_log_t const&) = delete;
+    event_log_t(event_log_t&&)      = delete;
+    auto operator=(event_log_t const&) -> event_log_t& = delete;
+    auto operator=(event_log_t&&) -> event_log_t& = delete;
+
+    [[nodiscard]] auto capacity() const noexcept -> size_t;
+
+    /// \brief Appends \p event to the queue.
+    ///
+    /// Returns `false` if the queue is full. The event is then counted in
+    /// #num_dropped.
+    auto try_push(event_t const& event) noexcept -> bool;
+
+    /// \brief Removes the oldest event from the queue and stores it in
+    /// \p event.
+    ///
+    /// Returns `false` if the queue is empty.
+    auto try_pop(event_t& event) noexcept -> bool;
+
+    /// \brief Calls \p fn for each event currently in the queue.
+    ///
+    /// Returns the number of processed events.
+    template <class Function> auto drain(Function&& fn) -> size_t
+    {
+        auto    count = size_t{0};
+        event_t event;
+        while (try_pop(event)) {
+            fn(event);
+            ++count;
+        }
+        return count;
+    }
+
+    /// Number of events lost because the queue was full.
+    [[nodiscard]] auto num_dropped() const noexcept -> std::uint64_t;
+
+  private:
+    struct slot_t;
+
+    std::unique_ptr<slot_t[]> _slots;
+    size_t                    _mask;
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+    alignas(64) std::atomic<std::uint64_t> _num_dropped;
+};
+
+/// The event log all chains write to when compiled with
+/// `DA_INSTRUMENTATION_EVENTS`.
+auto global_event_log() noexcept -> event_log_t&;
+
+namespace detail {
+/// Nanoseconds since some unspecified point in time.
+inline auto timestamp() noexcept -> std::uint64_t
+{
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+auto accumulate_global_counters(chain_counters_t const&) noexcept
+    -> void;
+auto next_event_source() noexcept -> std::uint64_t;
+
+#if DA_INSTRUMENTATION == DA_INSTRUMENTATION_OFF
+/// Per-chain instrumentation hooks. This version does nothing.
+class instrumentation_t {
+  public:
+    static constexpr auto start() noexcept -> std::uint64_t { return 0; }
+    constexpr auto        stop(phase_t /*unused*/, std::uint64_t /*unused*/,
+                        size_t /*unused*/, size_t /*unused*/,
+                        size_t /*unused*/) noexcept -> void
+    {}
+    constexpr auto evaluated(std::uint64_t /*unused*/,
+                             size_t /*unused*/) noexcept -> void
+    {}
+    constexpr auto flush() noexcept -> void {}
+    constexpr auto counters() const noexcept -> chain_counters_t
+    {
+        return {};
+    }
+};
+#else
+/// Per-chain instrumentation hooks.
+class instrumentation_t {
+    chain_counters_t _totals;  ///< Since the construction of the chain
+    chain_counters_t _pending; ///< Not yet added to the global counters
+    std::uint64_t    _source;
+    std::uint64_t    _iteration;  ///< Last iteration passed to #stop
+    std::uint64_t    _eval_start; ///< Start of the first pending evaluation
+
+    static auto add(phase_counters_t& counters, std::uint64_t const time_ns,
+                    size_t const num_accepted, size_t const num_attempted)
+        -> void
+    {
+        counters.time_ns += time_ns;
+        ++counters.count;
+        counters.num_accepted += num_accepted;
+        counters.num_attempted += num_attempted;
+    }
+
+  public:
+    instrumentation_t() noexcept
+        : _totals{}
+        , _pending{}
+        , _source{next_event_source()}
+        , _iteration{0}
+        , _eval_start{0}
+    {}
+
+    instrumentation_t(instrumentation_t const&) = delete;
+    instrumentation_t(instrumentation_t&&)      = delete;
+    auto operator=(instrumentation_t const&) -> instrumentation_t& = delete;
+    auto operator=(instrumentation_t&&) -> instrumentation_t& = delete;
+
+    ~instrumentation_t() noexcept { flush(); }
+
+    static auto start() noexcept -> std::uint64_t { return timestamp(); }
+
+    /// Records one execution of \p phase which started at \p start.
+    auto stop(phase_t const phase, std::uint64_t const start,
+              size_t const iteration, size_t const num_accepted,
+              size_t const num_attempted) noexcept -> void
+    {
+        auto const time_ns = timestamp() - start;
+        add(_totals[phase], time_ns, num_accepted, num_attempted);
+        add(_pending[phase], time_ns, num_accepted, num_attempted);
+        _iteration = iteration;
+#    if DA_INSTRUMENTATION >= DA_INSTRUMENTATION_EVENTS
+        global_event_log().try_push(
+            event_t{_source, iteration, start, time_ns,
+                    static_cast<std::uint32_t>(num_accepted),
+                    static_cast<std::uint32_t>(num_attempted), phase});
+#    endif
+    }
+
+    /// Records \p count evaluations of the objective which started at
+    /// \p start.
+    auto evaluated(std::uint64_t const start, size_t const count) noexcept
+        -> void
+    {
+        auto const time_ns = timestamp() - start;
+        auto&      pending = _pending[phase_t::evaluation];
+        if (pending.count == 0) { _eval_start = start; }
+        add(_totals[phase_t::evaluation], time_ns, 0, count);
+        add(pending, time_ns, 0, count);
+    }
+
+    /// \brief Publishes the counters recorded since the last call.
+    ///
+    /// Evaluations are aggregated into a single event since there are too
+    /// many of them to log individually.
+    auto flush() noexcept -> void
+    {
+#    if DA_INSTRUMENTATION >= DA_INSTRUMENTATION_EVENTS
+        auto const& evaluation = _pending[phase_t::evaluation];
+        if (evaluation.count != 0) {
+            global_event_log().try_push(event_t{
+                _source, _iteration, _eval_start, evaluation.time_ns, 0,
+                static_cast<std::uint32_t>(evaluation.num_attempted),
+                phase_t::evaluation});
+        }
+#    endif
+        accumulate_global_counters(_pending);
+        _pending = chain_counters_t{};
+    }
+
+    auto counters() const noexcept -> chain_counters_t const&
+    {
+        return _totals;
+    }
+};
+#endif
+} // namespace detail
+
+DUAL_ANNEALING_NAMESPACE_END
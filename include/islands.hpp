@@ -0,0 +1,303 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file islands.hpp
+/// \brief Island model: independent chains which periodically exchange their
+/// best points over a pluggable transport.
+
+#pragma once
+
+#include "chain.hpp"
+#include "config.hpp"
+#include "observers.hpp"
+#include "random.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>   // std::max
+#include <cstddef>     // size_t
+#include <cstring>     // std::memcpy
+#include <limits>      // std::numeric_limits
+#include <memory>      // std::unique_ptr
+#include <optional>    // std::optional
+#include <type_traits> // std::true_type, std::false_type, std::void_t
+#include <utility>     // std::declval
+#include <vector>      // std::vector
+
+DA_NAMESPACE_BEGIN
+
+/// Which islands receive the best point of an island.
+enum class migration_topology_t {
+    ring,       ///< Island `r` sends to island `(r + 1) % size`
+    all_to_all, ///< Every island sends to all others
+    random,     ///< Every island sends to one other island chosen at random
+};
+
+/// Parameters of #minimize_islands.
+struct island_param_t {
+    /// Number of iterations between migrations.
+    size_t migration_interval = 50;
+    migration_topology_t topology = migration_topology_t::ring;
+    /// Whether an immigrant which is better than `current` replaces it (and
+    /// not just `best`), see #sa_chain_t::offer.
+    bool replace_current = true;
+};
+
+struct island_result_t {
+    /// Statistics of the chain on this island. `island.func` is the best
+    /// value found locally (including immigrants).
+    result_t island;
+    double   func;           ///< Best value found by any island
+    size_t   num_emigrants;  ///< Points sent to other islands
+    size_t   num_immigrants; ///< Points received from other islands
+};
+
+/// \brief Determines whether `T` can be used as a transport of
+/// #minimize_islands.
+///
+/// A transport `t` connects `t.size()` islands, one of which (`t.rank()`) is
+/// ours, and all of which work with points of the same dimension. It must
+/// provide:
+///   * `t.send(destination, x, func)` which starts sending the point `x`
+///     (a `gsl::span<float const>`) with function value `func` to island
+///     `destination` and returns without waiting for it to arrive. `x` may
+///     be modified as soon as `send` returns;
+///   * `t.receive(x)` which copies a point which has arrived into `x` (a
+///     `gsl::span<float>`) and returns its function value, or returns
+///     `std::nullopt` if there is none. It must not block;
+///   * `t.reduce_best(x, func)`, a collective operation, which returns the
+///     lowest `func` of all islands and copies the corresponding point into
+///     `x` on every island. Points which are still in flight are discarded,
+///     and the transport can be reused afterwards.
+///
+/// See #island_hub_t for islands running on threads of one process and
+/// #mpi_transport_t (requires `DA_USE_MPI`) for islands on MPI ranks.
+template <class T, class = void>
+struct is_island_transport : std::false_type {};
+
+template <class T>
+struct is_island_transport<
+    T,
+    std::void_t<
+        decltype(static_cast<size_t>(std::declval<T const&>().rank())),
+        decltype(static_cast<size_t>(std::declval<T const&>().size())),
+        decltype(std::declval<T&>().send(
+            std::declval<size_t>(), std::declval<gsl::span<float const>>(),
+            std::declval<double>())),
+        decltype(static_cast<std::optional<double>>(
+            std::declval<T&>().receive(std::declval<gsl::span<float>>()))),
+        decltype(static_cast<double>(std::declval<T&>().reduce_best(
+            std::declval<gsl::span<float>>(), std::declval<double>())))>>
+    : std::true_type {};
+
+template <class T>
+inline constexpr auto is_island_transport_v = is_island_transport<T>::value;
+
+/// \brief Transport of #minimize_islands for islands which run on threads of
+/// the same process.
+///
+/// Every island posts into the mailboxes of the others, which costs a copy
+/// and a short critical section per point. Use #transport to get the
+/// transport of a particular island.
+class island_hub_t {
+  public:
+    class transport_t {
+        friend class island_hub_t;
+
+        island_hub_t* _hub;
+        size_t        _rank;
+
+        transport_t(island_hub_t& hub, size_t const rank) noexcept
+            : _hub{&hub}, _rank{rank}
+        {}
+
+      public:
+        [[nodiscard]] auto rank() const noexcept -> size_t { return _rank; }
+        [[nodiscard]] auto size() const noexcept -> size_t
+        {
+            return _hub->size();
+        }
+
+        auto send(size_t const destination, gsl::span<float const> x,
+                  double const func) -> void
+        {
+            _hub->send(destination, x, func);
+        }
+
+        auto receive(gsl::span<float> x) -> std::optional<double>
+        {
+            return _hub->receive(_rank, x);
+        }
+
+        auto reduce_best(gsl::span<float> x, double const func) -> double
+        {
+            return _hub->reduce_best(x, func);
+        }
+    };
+
+    /// Creates a hub for \p size islands working with points of dimension
+    /// \p dim.
+    island_hub_t(size_t size, size_t dim);
+    ~island_hub_t() noexcept;
+
+    island_hub_t(island_hub_t const&) = delete;
+    island_hub_t(island_hub_t&&)      = delete;
+    auto operator=(island_hub_t const&) -> island_hub_t& = delete;
+    auto operator=(island_hub_t&&) -> island_hub_t& = delete;
+
+    [[nodiscard]] auto size() const noexcept -> size_t;
+    [[nodiscard]] auto dim() const noexcept -> size_t;
+
+    /// Returns the transport of island \p rank.
+    [[nodiscard]] auto transport(size_t rank) noexcept -> transport_t;
+
+  private:
+    auto send(size_t destination, gsl::span<float const> x, double func)
+        -> void;
+    auto receive(size_t rank, gsl::span<float> x) -> std::optional<double>;
+    auto reduce_best(gsl::span<float> x, double func) -> double;
+
+    struct impl_t;
+    std::unique_ptr<impl_t> _impl;
+};
+
+namespace detail {
+/// Sends the point (\p x, \p func) to the neighbours of island \p rank.
+template <class Transport, class Generator>
+auto emigrate(Transport& transport, migration_topology_t const topology,
+              Generator& generator, gsl::span<float const> x,
+              double const func) -> size_t
+{
+    auto const rank = static_cast<size_t>(transport.rank());
+    auto const size = static_cast<size_t>(transport.size());
+    if (size < 2) { return 0; }
+    switch (topology) {
+    case migration_topology_t::ring:
+        transport.send((rank + 1) % size, x, func);
+        return 1;
+    case migration_topology_t::all_to_all:
+        for (auto r = size_t{0}; r < size; ++r) {
+            if (r != rank) { transport.send(r, x, func); }
+        }
+        return size - 1;
+    case migration_topology_t::random: {
+        // Picks one of the other `size - 1` islands
+        auto const r = uniform_index(generator, size - 1);
+        transport.send(r < rank ? r : r + 1, x, func);
+        return 1;
+    }
+    default: return 0;
+    }
+}
+
+template <class Objective, class Generator, class Workspace, class Transport,
+          class Observer>
+auto minimize_islands_in(Objective&& obj, gsl::span<float> x,
+                         param_t const&        parameters,
+                         island_param_t const& island_parameters,
+                         Generator& generator, Workspace& workspace,
+                         Transport& transport, Observer&& observer)
+    -> island_result_t
+{
+    std::memcpy(workspace.current.x.data(), x.data(),
+                x.size() * sizeof(float));
+    sa_chain_t<Objective&, Generator, Workspace> chain{obj, workspace,
+                                                       parameters, generator};
+    auto const interval =
+        std::max<size_t>(island_parameters.migration_interval, 1);
+    auto driver         = driver_state_t{parameters};
+    auto immigrant      = std::vector<float>(x.size());
+    auto emigrated      = std::numeric_limits<double>::infinity();
+    auto num_emigrants  = size_t{0};
+    auto num_immigrants = size_t{0};
+    while (chain.iteration() < parameters.num_iter && driver.patience != 0
+           && !out_of_budget(chain, parameters)) {
+        auto const accepted = chain.num_accepted();
+        chain();
+        if (chain.iteration() % interval == 0) {
+            // Points may arrive at any time, but merging them only every
+            // `interval` iterations keeps the chains independent in between.
+            while (auto const func = transport.receive(immigrant)) {
+                ++num_immigrants;
+                chain.offer(immigrant, *func,
+                            island_parameters.replace_current);
+            }
+            // Only improvements are worth the traffic
+            if (workspace.best.func < emigrated) {
+                chain.sync_best();
+                num_emigrants +=
+                    emigrate(transport, island_parameters.topology, generator,
+                             workspace.best.x, workspace.best.func);
+                emigrated = workspace.best.func;
+            }
+        }
+        driver.update(parameters, workspace);
+        maybe_reanneal(chain, parameters, driver, x.size(),
+                       chain.num_accepted() - accepted);
+        if (observe(chain, workspace, observer)) { break; }
+    }
+    chain.sync_best();
+    std::memcpy(x.data(), workspace.best.x.data(), x.size() * sizeof(float));
+    auto const island = make_result(chain, workspace, driver.num_restarts);
+    auto const func   = transport.reduce_best(x, island.func);
+    return island_result_t{island, func, num_emigrants, num_immigrants};
+}
+} // namespace detail
+
+/// \brief Runs an island of the island model.
+///
+/// Every island (e.g. an MPI rank or a thread) calls this function with its
+/// own \p transport and \p generator, and runs its own chain starting at
+/// \p x. Every `migration_interval` iterations, an island merges the points
+/// which have arrived in the meantime (see #sa_chain_t::offer) and, if its
+/// best point improved since it last did so, sends it to its neighbours in
+/// `topology`. Sending and receiving never wait for other islands, so
+/// communication overlaps with annealing.
+///
+/// Upon return, \p x holds the best point found by any island on every
+/// island. Since that requires all islands to finish, the function blocks
+/// until they have.
+template <class Objective, class Generator, class Transport,
+          class Observer = no_observer_t,
+          class          = std::enable_if_t<is_island_transport_v<Transport>
+                                   && is_observer_v<Observer>>>
+auto minimize_islands(Objective&& obj, gsl::span<float> x,
+                      param_t const&        parameters,
+                      island_param_t const& island_parameters,
+                      Generator& generator, Transport& transport,
+                      Observer observer = {}) -> island_result_t
+{
+    auto&& buffers   = detail::workspace_from(thread_local_pool(), x.size());
+    auto   workspace = buffers.workspace();
+    return detail::minimize_islands_in(std::forward<Objective>(obj), x,
+                                       parameters, island_parameters,
+                                       generator, workspace, transport,
+                                       observer);
+}
+
+DA_NAMESPACE_END
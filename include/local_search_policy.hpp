@@ -0,0 +1,262 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include "assert.hpp"
+#include "config.hpp"
+#include "thread_pool.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>   // std::max_element
+#include <cstddef>     // size_t
+#include <cstring>     // std::memcpy
+#include <tuple>       // std::tuple, std::apply
+#include <type_traits> // std::is_invocable_r
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// \brief A point which local search could start from.
+///
+/// Passed to local search policies whenever the best point of the chain
+/// improves.
+struct local_search_candidate_t {
+    gsl::span<float const> x;           ///< Only valid during the call
+    double                 func;        ///< Function value at #x
+    size_t                 iteration;   ///< Number of finished iterations
+    size_t                 num_f_evals; ///< Total evaluations so far
+    /// Evaluations spent in local search so far (included in #num_f_evals)
+    size_t num_local_search_f_evals;
+};
+
+/// \brief Determines whether `T` can be used as a local search policy.
+///
+/// A policy `p` is a callable such that `p(candidate)` returns whether local
+/// search should be run from `candidate` (a #local_search_candidate_t) right
+/// away. Policies may be stateful: they are only consulted from the thread
+/// running #minimize.
+template <class T>
+inline constexpr auto is_local_search_policy_v =
+    std::is_invocable_r_v<bool, T&, local_search_candidate_t const&>;
+
+/// \brief Runs local search on every improvement of the best point.
+///
+/// This is the default and matches the behaviour of #minimize without a
+/// policy.
+struct always_polish_t {
+    constexpr auto operator()(local_search_candidate_t const& /*unused*/) const
+        noexcept -> bool
+    {
+        return true;
+    }
+};
+
+/// \brief Caps the share of evaluations spent in local search.
+///
+/// A candidate is polished only if local search has so far used at most
+/// #fraction of all function evaluations. Since L-BFGS on a bad candidate
+/// can easily cost more than a whole annealing iteration, this keeps
+/// expensive objectives from spending their entire budget on polishing.
+struct budget_fraction_t {
+    double fraction;
+
+    constexpr auto operator()(local_search_candidate_t const& c) const noexcept
+        -> bool
+    {
+        return static_cast<double>(c.num_local_search_f_evals)
+               <= fraction * static_cast<double>(c.num_f_evals);
+    }
+};
+
+/// \brief Skips candidates which are close to previously polished ones.
+///
+/// Consecutive improvements often lie in the same basin, and polishing all of
+/// them converges to the same local minimum over and over. A candidate is
+/// accepted only if its Euclidean distance to every previously accepted
+/// candidate exceeds the radius. Accepted candidates are remembered, so the
+/// cost of a query grows linearly with the number of local searches.
+class min_distance_t {
+    float              _radius_squared;
+    size_t             _dim;
+    std::vector<float> _polished; ///< Accepted candidates, one after another
+
+    auto distance_squared(gsl::span<float const> x, size_t const i) const
+        noexcept -> float
+    {
+        auto const* y     = _polished.data() + i * _dim;
+        auto        total = 0.0f;
+        for (auto k = size_t{0}; k < _dim; ++k) {
+            auto const d = x[k] - y[k];
+            total += d * d;
+        }
+        return total;
+    }
+
+  public:
+    explicit min_distance_t(float const radius)
+        : _radius_squared{radius * radius}, _dim{0}, _polished{}
+    {}
+
+    auto operator()(local_search_candidate_t const& c) -> bool
+    {
+        if (_dim == 0) { _dim = c.x.size(); }
+        DUAL_ANNEALING_ASSERT(c.x.size() == _dim, "incompatible dimensions");
+        for (auto i = size_t{0}; i < num_polished(); ++i) {
+            if (!(distance_squared(c.x, i) > _radius_squared)) { return false; }
+        }
+        _polished.insert(_polished.end(), c.x.begin(), c.x.end());
+        return true;
+    }
+
+    /// Number of candidates which were accepted so far.
+    [[nodiscard]] auto num_polished() const noexcept -> size_t
+    {
+        return _dim == 0 ? 0 : _polished.size() / _dim;
+    }
+};
+
+/// \brief Combination of several policies which polishes a candidate only if
+/// all of them agree.
+///
+/// Policies are consulted from left to right and evaluation stops at the
+/// first refusal. Since stateful policies such as #min_distance_t record the
+/// candidates they accept, they should come last.
+template <class... Policies> class all_of_t {
+    std::tuple<Policies...> _policies;
+
+  public:
+    explicit constexpr all_of_t(Policies... policies)
+        : _policies{std::move(policies)...}
+    {}
+
+    auto operator()(local_search_candidate_t const& c) -> bool
+    {
+        return std::apply(
+            [&c](auto&... policies) { return (policies(c) && ...); },
+            _policies);
+    }
+};
+
+/// Creates an #all_of_t.
+template <class... Policies>
+constexpr auto all_of(Policies... policies) -> all_of_t<Policies...>
+{
+    return all_of_t<Policies...>{std::move(policies)...};
+}
+
+/// \brief Collects the best candidates and polishes them in parallel.
+///
+/// Instead of running local search on every improvement, the pool keeps the
+/// #capacity lowest candidates seen since the last flush. Every #interval
+/// iterations (and once more at the end) #minimize runs L-BFGS from all of
+/// them concurrently on the threads of a #thread_pool_t and merges the best
+/// result back into the chain. Each task works with its own copy of the
+/// objective; pass `std::ref(obj)` to share a single (thread-safe) instance.
+///
+/// \note The pool must outlive the policy.
+class candidate_pool_t {
+    size_t             _capacity;
+    size_t             _interval;
+    thread_pool_t*     _pool;
+    size_t             _dim;
+    std::vector<float>  _xs;    ///< Candidates, one after another
+    std::vector<double> _funcs; ///< Function values at #_xs
+
+  public:
+    /// \p capacity and \p interval must be positive.
+    candidate_pool_t(size_t const capacity, size_t const interval,
+                     thread_pool_t& pool)
+        : _capacity{capacity}
+        , _interval{interval}
+        , _pool{&pool}
+        , _dim{0}
+        , _xs{}
+        , _funcs{}
+    {
+        DUAL_ANNEALING_ASSERT(capacity > 0, "capacity must be positive");
+        DUAL_ANNEALING_ASSERT(interval > 0, "interval must be positive");
+    }
+
+    /// Records \p c and always returns `false`: candidates are polished in
+    /// batches rather than right away.
+    auto operator()(local_search_candidate_t const& c) -> bool
+    {
+        if (_dim == 0) { _dim = c.x.size(); }
+        DUAL_ANNEALING_ASSERT(c.x.size() == _dim, "incompatible dimensions");
+        auto slot = size();
+        if (slot == _capacity) {
+            // Replace the worst candidate if `c` is better
+            slot = static_cast<size_t>(
+                std::max_element(_funcs.begin(), _funcs.end())
+                - _funcs.begin());
+            if (!(c.func < _funcs[slot])) { return false; }
+        }
+        else {
+            _xs.resize(_xs.size() + _dim);
+            _funcs.push_back(c.func);
+        }
+        std::memcpy(_xs.data() + slot * _dim, c.x.data(),
+                    _dim * sizeof(float));
+        _funcs[slot] = c.func;
+        return false;
+    }
+
+    /// Whether the pool should be flushed after iteration \p iteration.
+    [[nodiscard]] auto due(size_t const iteration) const noexcept -> bool
+    {
+        return size() != 0 && iteration % _interval == 0;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t
+    {
+        return _funcs.size();
+    }
+    [[nodiscard]] auto pool() const noexcept -> thread_pool_t&
+    {
+        return *_pool;
+    }
+    /// Location of the \p i'th candidate. Local search works in-place.
+    [[nodiscard]] auto x(size_t const i) noexcept -> gsl::span<float>
+    {
+        return {_xs.data() + i * _dim, _dim};
+    }
+    [[nodiscard]] auto func(size_t const i) const noexcept -> double
+    {
+        return _funcs[i];
+    }
+    /// Forgets all candidates.
+    auto clear() noexcept -> void
+    {
+        _xs.clear();
+        _funcs.clear();
+    }
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -0,0 +1,94 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file mpi_transport.hpp
+/// \brief MPI transport of the island model, see #minimize_islands.
+
+#pragma once
+
+#include "config.hpp"
+
+#if !defined(DA_USE_MPI)
+#    error "mpi_transport.hpp requires building with DA_USE_MPI"
+#endif
+
+#include <gsl/gsl-lite.hpp>
+#include <mpi.h>
+
+#include <cstddef>  // size_t
+#include <memory>   // std::unique_ptr
+#include <optional> // std::optional
+
+DA_NAMESPACE_BEGIN
+
+/// \brief Transport of #minimize_islands for islands which run on the ranks
+/// of an MPI communicator.
+///
+/// Points are sent with `MPI_Isend` from buffers owned by the transport, and
+/// one `MPI_Irecv` is always posted, so neither #send nor #receive waits for
+/// other ranks. MPI only makes progress inside MPI calls, i.e. when the
+/// island model merges immigrants every `migration_interval` iterations.
+///
+/// The transport works on a duplicate of the communicator, so its messages
+/// never mix with those of the application. It must be destroyed before
+/// `MPI_Finalize`. Only the thread which created it may use it, so
+/// `MPI_THREAD_FUNNELED` is enough.
+class mpi_transport_t {
+  public:
+    /// Creates a transport for points of dimension \p dim. This is a
+    /// collective operation on \p comm.
+    mpi_transport_t(MPI_Comm comm, size_t dim);
+    ~mpi_transport_t() noexcept;
+
+    mpi_transport_t(mpi_transport_t const&) = delete;
+    mpi_transport_t(mpi_transport_t&&) noexcept;
+    auto operator=(mpi_transport_t const&) -> mpi_transport_t& = delete;
+    auto operator=(mpi_transport_t&&) noexcept -> mpi_transport_t&;
+
+    [[nodiscard]] auto rank() const noexcept -> size_t;
+    [[nodiscard]] auto size() const noexcept -> size_t;
+    [[nodiscard]] auto dim() const noexcept -> size_t;
+
+    auto send(size_t destination, gsl::span<float const> x, double func)
+        -> void;
+    auto receive(gsl::span<float> x) -> std::optional<double>;
+
+    /// \brief Collective: returns the lowest \p func of all ranks and copies
+    /// the corresponding point into \p x.
+    ///
+    /// Ranks first exchange how many points they have sent to each other
+    /// and receive (and drop) the ones which are still in flight, so all
+    /// requests complete and the transport can be reused afterwards.
+    auto reduce_best(gsl::span<float> x, double func) -> double;
+
+  private:
+    struct impl_t;
+    std::unique_ptr<impl_t> _impl;
+};
+
+DA_NAMESPACE_END
@@ -0,0 +1,515 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cstddef>     // size_t
+#include <functional>  // std::reference_wrapper
+#include <type_traits> // std::true_type, std::false_type, std::void_t
+#include <utility>     // std::declval, std::pair
+
+/// \file objective.hpp
+/// \brief Detection of the optional member functions of objectives, and
+/// helpers which call them (or fall back to something sensible).
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+namespace detail {
+
+/// \brief Determines whether `T` has a member function `wrap` which can be
+/// called with a single argument of type `X`.
+///
+/// In other words, if we have an object `t` of type `T` and `x` of type `X`,
+/// this trait determines whether `t.wrap(x)` is a valid expression.
+template <class T, class X, class = void>
+struct has_wrap_mem_fn : std::false_type {};
+
+template <class T, class X>
+struct has_wrap_mem_fn<
+    T, X, std::void_t<decltype(std::declval<T>().wrap(std::declval<X>()))>>
+    : std::true_type {};
+
+template <class T, class X>
+inline constexpr auto has_wrap_mem_fn_v = has_wrap_mem_fn<T, X>::value;
+
+/// \brief Determines whether `T` has a member function `bounds()`.
+///
+/// Objectives use it to expose a #box_bounds_t, which then replaces `wrap`.
+template <class T, class = void> struct has_bounds_mem_fn : std::false_type {};
+
+template <class T>
+struct has_bounds_mem_fn<T, std::void_t<decltype(std::declval<T>().bounds())>>
+    : std::true_type {};
+
+template <class T>
+inline constexpr auto has_bounds_mem_fn_v = has_bounds_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `value` which can be
+/// called with a single argument of type `gsl::span<float const>`.
+///
+/// In other words, if we have an object `t` of type `T` and `x` of type
+/// `gsl::span<float const>`, this trait determines whether `t.value(x)` is a
+/// valid expression.
+template <class T, class = void> struct has_value_mem_fn : std::false_type {};
+
+template <class T>
+struct has_value_mem_fn<T, std::void_t<decltype(std::declval<T>().value(
+                               std::declval<gsl::span<float const>>()))>>
+    : std::true_type {};
+
+template <class T>
+inline constexpr auto has_value_mem_fn_v = has_value_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `value_from_diff` which
+/// can be called with `std::pair<gsl::span<float const>, double>` and
+/// `std::pair<size_t, float>`.
+///
+/// In other words, if we have an object `t` of type `T`, `x` of type
+/// `std::pair<gsl::span<float const>, double>`, and `y` of type
+/// `std::pair<size_t, float>`, this trait determines whether
+/// `t.value_from_diff(x, y)` is a valid expression.
+template <class T, class = void>
+struct has_value_from_diff_mem_fn : std::false_type {};
+
+template <class T>
+struct has_value_from_diff_mem_fn<
+    T, std::void_t<decltype(std::declval<T>().value_from_diff(
+           std::declval<std::pair<gsl::span<float const>, double>>(),
+           std::declval<std::pair<size_t, float>>()))>> : std::true_type {};
+
+template <class T>
+inline constexpr auto has_value_from_diff_mem_fn_v =
+    has_value_from_diff_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function
+/// `value_from_sparse_diff` which can be called with
+/// `std::pair<gsl::span<float const>, double>` and
+/// `gsl::span<std::pair<size_t, float> const>`.
+///
+/// `t.value_from_sparse_diff(current, diff)` should return the function value
+/// at `current.first` with the coordinates `diff[m].first` replaced by
+/// `diff[m].second` (indices in \p diff are distinct), given that the value
+/// at `current.first` is `current.second`. It is the multi-coordinate
+/// generalisation of `value_from_diff` and is used for block moves (see
+/// #param_t::block_size).
+template <class T, class = void>
+struct has_value_from_sparse_diff_mem_fn : std::false_type {};
+
+template <class T>
+struct has_value_from_sparse_diff_mem_fn<
+    T, std::void_t<decltype(std::declval<T>().value_from_sparse_diff(
+           std::declval<std::pair<gsl::span<float const>, double>>(),
+           std::declval<gsl::span<std::pair<size_t, float> const>>()))>>
+    : std::true_type {};
+
+template <class T>
+inline constexpr auto has_value_from_sparse_diff_mem_fn_v =
+    has_value_from_sparse_diff_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `value_batch` which
+/// can be called with `gsl::span<float const>`, `size_t`, and
+/// `gsl::span<double>`.
+///
+/// `t.value_batch(xs, n, out)` should evaluate the objective at `n` points
+/// stored contiguously (row-major) in `xs` and write the function values to
+/// `out`.
+template <class T, class = void>
+struct has_value_batch_mem_fn : std::false_type {};
+
+template <class T>
+struct has_value_batch_mem_fn<
+    T, std::void_t<decltype(std::declval<T>().value_batch(
+           std::declval<gsl::span<float const>>(), std::declval<size_t>(),
+           std::declval<gsl::span<double>>()))>> : std::true_type {};
+
+template <class T>
+inline constexpr auto has_value_batch_mem_fn_v =
+    has_value_batch_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `value_soa` which can
+/// be called with `gsl::span<float const>`, `size_t`, and `gsl::span<double>`.
+///
+/// `t.value_soa(xs, width, out)` should evaluate the objective at `width`
+/// points stored coordinate-major (structure-of-arrays) in `xs`, i.e.
+/// `xs[j * width + l]` is the `j`'th coordinate of point `l`, and write the
+/// function values to `out`. It is used by #minimize_batch and lets the
+/// objective vectorise across problems.
+template <class T, class = void>
+struct has_value_soa_mem_fn : std::false_type {};
+
+template <class T>
+struct has_value_soa_mem_fn<
+    T, std::void_t<decltype(std::declval<T>().value_soa(
+           std::declval<gsl::span<float const>>(), std::declval<size_t>(),
+           std::declval<gsl::span<double>>()))>> : std::true_type {};
+
+template <class T>
+inline constexpr auto has_value_soa_mem_fn_v = has_value_soa_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `coordinate_deltas`
+/// which can be called with `gsl::span<float const>`, `gsl::span<float
+/// const>`, and `gsl::span<double>`.
+///
+/// `t.coordinate_deltas(x, ys, out)` should write to `out[i]` the change in
+/// the function value if the `i`'th coordinate of `x` is replaced with
+/// `ys[i]` and all other coordinates are kept. It lets #sa_chain_t process
+/// all single-coordinate moves of an iteration in one pass. Unless `t` also
+/// has a #has_coupling_mem_fn member, the objective is assumed to be
+/// separable.
+template <class T, class = void>
+struct has_coordinate_deltas_mem_fn : std::false_type {};
+
+template <class T>
+struct has_coordinate_deltas_mem_fn<
+    T, std::void_t<decltype(std::declval<T>().coordinate_deltas(
+           std::declval<gsl::span<float const>>(),
+           std::declval<gsl::span<float const>>(),
+           std::declval<gsl::span<double>>()))>> : std::true_type {};
+
+template <class T>
+inline constexpr auto has_coordinate_deltas_mem_fn_v =
+    has_coordinate_deltas_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `coupling` which can
+/// be called without arguments.
+///
+/// `t.coupling()` should return the smallest `b` such that the change in the
+/// function value due to the `i`'th coordinate depends only on coordinates
+/// `j` with `|i - j| <= b`. For example, `b = 0` for separable objectives and
+/// `b = 1` for the Rosenbrock function.
+template <class T, class = void>
+struct has_coupling_mem_fn : std::false_type {};
+
+template <class T>
+struct has_coupling_mem_fn<
+    T, std::void_t<decltype(static_cast<size_t>(std::declval<T>().coupling()))>>
+    : std::true_type {};
+
+template <class T>
+inline constexpr auto has_coupling_mem_fn_v = has_coupling_mem_fn<T>::value;
+
+/// \brief Determines whether `T` implements the incremental evaluation
+/// protocol.
+///
+/// An objective `t` implements the protocol if the following expressions are
+/// valid:
+///   * `t.reset(x)` where `x` is of type `gsl::span<float const>`. It tells the
+///     objective that the current point of the chain is now `x`. The objective
+///     may (re-)build its internal caches at this point.
+///   * `t.propose(i, y)` where `i` is of type `size_t` and `y` -- `float`. It
+///     returns the change in the function value (as a `double`) if the `i`'th
+///     coordinate of the current point is replaced with `y`.
+///   * `t.commit()` which accepts the last proposed move.
+///   * `t.rollback()` which rejects the last proposed move.
+///
+/// Every `propose` is followed by exactly one `commit` or `rollback`.
+template <class T, class = void>
+struct has_incremental_protocol : std::false_type {};
+
+template <class T>
+struct has_incremental_protocol<
+    T,
+    std::void_t<decltype(std::declval<T>().reset(
+                    std::declval<gsl::span<float const>>())),
+                decltype(static_cast<double>(std::declval<T>().propose(
+                    std::declval<size_t>(), std::declval<float>()))),
+                decltype(std::declval<T>().commit()),
+                decltype(std::declval<T>().rollback())>> : std::true_type {};
+
+template <class T>
+inline constexpr auto has_incremental_protocol_v =
+    has_incremental_protocol<T>::value;
+
+template <class T> struct unwrap_reference { using type = T; };
+template <class T> struct unwrap_reference<std::reference_wrapper<T>> {
+    using type = T;
+};
+
+/// Type of the "real" objective behind \p T which may be a
+/// `std::reference_wrapper`.
+template <class T>
+using unwrap_reference_t =
+    typename unwrap_reference<std::remove_cv_t<std::remove_reference_t<T>>>::type;
+
+template <class T> constexpr auto unwrap(T& x) noexcept -> T& { return x; }
+template <class T>
+constexpr auto unwrap(std::reference_wrapper<T> x) noexcept -> T&
+{
+    return x.get();
+}
+
+template <class Objective, class = void,
+          class = std::enable_if_t<!has_wrap_mem_fn_v<Objective&, float>>>
+auto do_wrap(Objective& /*unused*/, float const /*unused*/) noexcept -> void
+{
+    constexpr auto always_false = !std::is_same_v<Objective, Objective>;
+    static_assert(always_false, "Objective is missing 'wrap' member function.");
+}
+
+template <class Objective,
+          class = std::enable_if_t<has_wrap_mem_fn_v<Objective&, float>>>
+DA_FORCEINLINE auto do_wrap(Objective& obj, float const x) noexcept(
+    noexcept(std::declval<Objective&>().wrap(std::declval<float>()))) -> float
+{
+    return obj.wrap(x);
+}
+
+template <class Objective>
+DA_FORCEINLINE auto
+do_wrap(std::reference_wrapper<Objective> obj,
+        float const x) noexcept(noexcept(do_wrap(std::declval<Objective&>(),
+                                                 std::declval<float>())))
+    -> float
+{
+    return do_wrap(obj.get(), x);
+}
+
+/// \brief Returns \p x mapped into the domain of the \p i'th coordinate.
+///
+/// Uses `bounds().wrap(i, x)` if available and `wrap(x)` otherwise.
+template <class Objective>
+DA_FORCEINLINE auto do_wrap_one(Objective& obj, size_t const i, float const x)
+    -> float
+{
+    if constexpr (has_bounds_mem_fn_v<unwrap_reference_t<Objective>&>) {
+        return unwrap(obj).bounds().wrap(i, x);
+    }
+    else {
+        static_cast<void>(i);
+        return do_wrap(obj, x);
+    }
+}
+
+/// \brief Computes `out[i] = wrap(current[i] + out[i])` for all `i`.
+///
+/// Prefers `bounds().wrap(out)`, then the bulk hook `wrap(out)`, and falls
+/// back to calling `wrap(x)` for each coordinate.
+template <class Objective>
+DA_FORCEINLINE auto do_wrap_step(Objective&             obj,
+                                 gsl::span<float const> current,
+                                 gsl::span<float>       out) -> void
+{
+    using T = unwrap_reference_t<Objective>&;
+    if constexpr (has_bounds_mem_fn_v<T>
+                  || has_wrap_mem_fn_v<T, gsl::span<float>>) {
+        for (auto i = size_t{0}; i < out.size(); ++i) {
+            out[i] += current[i];
+        }
+        if constexpr (has_bounds_mem_fn_v<T>) {
+            unwrap(obj).bounds().wrap(out);
+        }
+        else {
+            unwrap(obj).wrap(out);
+        }
+    }
+    else {
+        for (auto i = size_t{0}; i < out.size(); ++i) {
+            out[i] = do_wrap(obj, current[i] + out[i]);
+        }
+    }
+}
+
+template <class Objective, class = void,
+          class = std::enable_if_t<!has_value_mem_fn_v<Objective&>>>
+auto do_value(Objective& /*unused*/, gsl::span<float const> /*unused*/) noexcept
+    -> void
+{
+    constexpr auto always_false = !std::is_same_v<Objective, Objective>;
+    static_assert(always_false,
+                  "Objective is missing 'value' member function.");
+}
+
+template <class Objective,
+          class = std::enable_if_t<has_value_mem_fn_v<Objective&>>>
+DA_FORCEINLINE auto
+do_value(Objective& obj, gsl::span<float const> x) noexcept(noexcept(
+    std::declval<Objective&>().value(std::declval<gsl::span<float const>>())))
+    -> double
+{
+    return obj.value(x);
+}
+
+template <class Objective>
+DA_FORCEINLINE auto do_value(
+    std::reference_wrapper<Objective> obj,
+    gsl::span<float const>
+        x) noexcept(noexcept(do_value(std::declval<Objective&>(),
+                                      std::declval<gsl::span<float const>>())))
+    -> double
+{
+    return do_value(obj.get(), x);
+}
+
+template <class Objective, class = void,
+          class = std::enable_if_t<!has_value_from_diff_mem_fn_v<Objective&>>>
+DA_FORCEINLINE auto do_value_from_diff(
+    Objective& obj, std::pair<gsl::span<float const>, double> current,
+    std::pair<size_t, float>
+        diff) noexcept(noexcept(do_value(std::declval<Objective&>(),
+                                         std::declval<
+                                             gsl::span<float const>>())))
+    -> double
+{
+    auto undo = gsl::finally(
+        [p = current.first.data(), i = diff.first,
+         x = current.first[diff.first]]() { const_cast<float*>(p)[i] = x; });
+    const_cast<float*>(current.first.data())[diff.first] = diff.second;
+    return do_value(obj, current.first);
+}
+
+template <class Objective,
+          class = std::enable_if_t<has_value_from_diff_mem_fn_v<Objective&>>>
+DA_FORCEINLINE auto do_value_from_diff(
+    Objective& obj, std::pair<gsl::span<float const>, double> current,
+    std::pair<size_t, float>
+        diff) noexcept(noexcept(std::declval<Objective&>()
+                                    .value_from_diff(
+                                        std::declval<std::pair<
+                                            gsl::span<float const>, double>>(),
+                                        std::declval<
+                                            std::pair<size_t, float>>())))
+    -> double
+{
+    return obj.value_from_diff(current, diff);
+}
+
+template <class Objective>
+DA_FORCEINLINE auto do_value_from_diff(
+    std::reference_wrapper<Objective>         obj,
+    std::pair<gsl::span<float const>, double> current,
+    std::pair<size_t, float>
+        diff) noexcept(noexcept(do_value_from_diff(std::declval<Objective&>(),
+                                                   std::declval<std::pair<
+                                                       gsl::span<float const>,
+                                                       double>>(),
+                                                   std::declval<std::pair<
+                                                       size_t, float>>())))
+    -> double
+{
+    return do_value_from_diff(obj.get(), current, diff);
+}
+
+/// \brief Function value after replacing several coordinates of
+/// `current.first`.
+///
+/// Uses `value_from_sparse_diff` if available. Otherwise, the moves are
+/// applied one by one using `value_from_diff` (O(k) calls) or all at once
+/// followed by a call to `value` (O(D)). \p current is restored in both
+/// cases. The second elements of \p diff are used as scratch space but hold
+/// their original values on return.
+template <class Objective>
+auto do_value_from_sparse_diff(
+    Objective& obj, std::pair<gsl::span<float const>, double> current,
+    gsl::span<std::pair<size_t, float>> diff) -> double
+{
+    using T = unwrap_reference_t<Objective>&;
+    if constexpr (has_value_from_sparse_diff_mem_fn_v<T>) {
+        return unwrap(obj).value_from_sparse_diff(
+            current, gsl::span<std::pair<size_t, float> const>{diff});
+    }
+    else {
+        // Swapping is its own inverse, so doing it twice restores both
+        // `current` and `diff`.
+        auto*      x       = const_cast<float*>(current.first.data());
+        auto       applied = size_t{0};
+        auto const undo    = gsl::finally([x, diff, &applied]() {
+            for (auto m = size_t{0}; m < applied; ++m) {
+                std::swap(x[diff[m].first], diff[m].second);
+            }
+        });
+        if constexpr (has_value_from_diff_mem_fn_v<T>) {
+            auto func = current.second;
+            for (; applied < diff.size(); ++applied) {
+                auto& [i, y] = diff[applied];
+                func         = do_value_from_diff(
+                    obj, std::make_pair(current.first, func),
+                    std::make_pair(i, y));
+                std::swap(x[i], y);
+            }
+            return func;
+        }
+        else {
+            for (; applied < diff.size(); ++applied) {
+                std::swap(x[diff[applied].first], diff[applied].second);
+            }
+            return do_value(obj, current.first);
+        }
+    }
+}
+
+/// Returns `coupling()` if \p Objective has it and `0` otherwise.
+template <class Objective>
+DA_FORCEINLINE auto do_coupling(Objective& obj) -> size_t
+{
+    if constexpr (has_coupling_mem_fn_v<unwrap_reference_t<Objective>&>) {
+        return static_cast<size_t>(unwrap(obj).coupling());
+    }
+    else {
+        static_cast<void>(obj);
+        return 0;
+    }
+}
+
+/// Calls `reset` if \p Objective implements the incremental evaluation
+/// protocol and does nothing otherwise.
+template <class Objective>
+DA_FORCEINLINE auto do_reset(Objective& obj, gsl::span<float const> x) -> void
+{
+    if constexpr (has_incremental_protocol_v<unwrap_reference_t<Objective>&>) {
+        unwrap(obj).reset(x);
+    }
+}
+
+template <class Objective>
+DA_FORCEINLINE auto do_propose(Objective& obj, size_t const i, float const x)
+    -> double
+{
+    return static_cast<double>(unwrap(obj).propose(i, x));
+}
+
+template <class Objective> DA_FORCEINLINE auto do_commit(Objective& obj) -> void
+{
+    if constexpr (has_incremental_protocol_v<unwrap_reference_t<Objective>&>) {
+        unwrap(obj).commit();
+    }
+}
+
+template <class Objective>
+DA_FORCEINLINE auto do_rollback(Objective& obj) -> void
+{
+    if constexpr (has_incremental_protocol_v<unwrap_reference_t<Objective>&>) {
+        unwrap(obj).rollback();
+    }
+}
+
+} // namespace detail
+
+DUAL_ANNEALING_NAMESPACE_END
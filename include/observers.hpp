@@ -0,0 +1,162 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <atomic>      // std::atomic
+#include <chrono>      // std::chrono::steady_clock
+#include <cstddef>     // size_t
+#include <tuple>       // std::tuple, std::apply
+#include <type_traits> // std::is_invocable_r
+#include <utility>     // std::move
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// State of the chain passed to observers after each iteration.
+struct iteration_info_t {
+    size_t iteration;    ///< Number of finished iterations
+    double current_func; ///< Function value at the current point
+    double best_func;    ///< Best function value found so far
+    size_t num_f_evals;  ///< Number of function evaluations so far
+    double acceptance;   ///< Acceptance rate so far
+    float  t_V;          ///< Visiting temperature of the last iteration
+};
+
+/// What an observer wants #minimize to do next.
+enum class observer_action_t { proceed, stop };
+
+/// \brief Determines whether `T` can be used as an observer.
+///
+/// An observer `o` is a callable such that `o(info)` returns an
+/// #observer_action_t where `info` is an #iteration_info_t.
+template <class T>
+inline constexpr auto is_observer_v =
+    std::is_invocable_r_v<observer_action_t, T&, iteration_info_t const&>;
+
+/// \brief Observer which never stops the minimisation.
+///
+/// It is the default, and #minimize skips the observer machinery entirely for
+/// it.
+struct no_observer_t {
+    constexpr auto operator()(iteration_info_t const& /*unused*/) const noexcept
+        -> observer_action_t
+    {
+        return observer_action_t::proceed;
+    }
+};
+
+/// Stops as soon as the best function value is at most #target.
+struct target_value_t {
+    double target;
+
+    constexpr auto operator()(iteration_info_t const& info) const noexcept
+        -> observer_action_t
+    {
+        return info.best_func <= target ? observer_action_t::stop
+                                        : observer_action_t::proceed;
+    }
+};
+
+/// \brief Stops when the wall-clock budget is exhausted.
+///
+/// The clock starts ticking when the observer is constructed. The check
+/// happens after each iteration, so the budget may be exceeded by the
+/// duration of one iteration.
+class time_budget_t {
+    std::chrono::steady_clock::time_point _deadline;
+
+  public:
+    explicit time_budget_t(std::chrono::steady_clock::duration const budget)
+        : _deadline{std::chrono::steady_clock::now() + budget}
+    {}
+
+    auto operator()(iteration_info_t const& /*unused*/) const noexcept
+        -> observer_action_t
+    {
+        return std::chrono::steady_clock::now() >= _deadline
+                   ? observer_action_t::stop
+                   : observer_action_t::proceed;
+    }
+};
+
+/// \brief Stops once the flag is set, e.g. from another thread.
+///
+/// The flag must outlive the observer.
+class cancellation_t {
+    std::atomic<bool> const* _flag;
+
+  public:
+    explicit constexpr cancellation_t(std::atomic<bool> const& flag) noexcept
+        : _flag{&flag}
+    {}
+
+    auto operator()(iteration_info_t const& /*unused*/) const noexcept
+        -> observer_action_t
+    {
+        return _flag->load(std::memory_order_relaxed)
+                   ? observer_action_t::stop
+                   : observer_action_t::proceed;
+    }
+};
+
+/// \brief Combination of several observers which stops as soon as any of
+/// them asks to.
+///
+/// All observers are called on every iteration (i.e. there is no
+/// short-circuiting), so stateful observers such as metric exporters see
+/// every iteration.
+template <class... Observers> class any_of_t {
+    std::tuple<Observers...> _observers;
+
+  public:
+    explicit constexpr any_of_t(Observers... observers)
+        : _observers{std::move(observers)...}
+    {}
+
+    auto operator()(iteration_info_t const& info) -> observer_action_t
+    {
+        return std::apply(
+            [&info](auto&... observers) {
+                auto stop = false;
+                ((stop |= observers(info) == observer_action_t::stop), ...);
+                return stop ? observer_action_t::stop
+                            : observer_action_t::proceed;
+            },
+            _observers);
+    }
+};
+
+template <class... Observers>
+constexpr auto any_of(Observers... observers) -> any_of_t<Observers...>
+{
+    return any_of_t<Observers...>{std::move(observers)...};
+}
+
+DUAL_ANNEALING_NAMESPACE_END
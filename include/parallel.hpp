@@ -0,0 +1,267 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "chain.hpp"
+#include "config.hpp"
+#include "thread_pool.hpp"
+
+#include <gsl/gsl-lite.hpp>
+#include <lbfgs/lbfgs.hpp>
+
+#include <atomic>    // std::atomic
+#include <cstddef>   // size_t
+#include <cstring>   // std::memcpy
+#include <limits>    // std::numeric_limits
+#include <mutex>     // std::mutex, std::lock_guard
+#include <stdexcept> // std::invalid_argument
+#include <vector>    // std::vector
+
+DA_NAMESPACE_BEGIN
+
+/// \brief Best point found so far by a group of chains running in parallel.
+///
+/// Reading the function value (#func) is a single atomic load, so chains can
+/// query it as often as they like. Updates take a lock, but only when they
+/// actually improve the global best, which happens rarely.
+class global_best_t {
+    std::atomic<double> _func;  ///< Function value at #_x.
+    std::atomic<size_t> _chain; ///< Index of the chain which found #_x.
+    mutable std::mutex  _mutex; ///< Protects #_x.
+    std::vector<float>  _x;     ///< Location of the best point.
+
+  public:
+    explicit global_best_t(size_t const dim)
+        : _func{std::numeric_limits<double>::infinity()}
+        , _chain{std::numeric_limits<size_t>::max()}
+        , _mutex{}
+        , _x(dim)
+    {}
+
+    global_best_t(global_best_t const&) = delete;
+    global_best_t(global_best_t&&)      = delete;
+    auto operator=(global_best_t const&) -> global_best_t& = delete;
+    auto operator=(global_best_t&&) -> global_best_t& = delete;
+
+    [[nodiscard]] auto func() const noexcept -> double
+    {
+        return _func.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] auto chain() const noexcept -> size_t
+    {
+        return _chain.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] auto dim() const noexcept -> size_t { return _x.size(); }
+
+    /// \brief Replaces the global best with (\p func, \p x) if \p func is
+    /// lower than #func().
+    ///
+    /// Returns whether the global best was updated.
+    auto update(size_t const chain, double const func,
+                gsl::span<float const> x) -> bool
+    {
+        DUAL_ANNEALING_ASSERT(x.size() == _x.size(), "incompatible dimensions");
+        // Cheap check first: most calls don't improve the global best.
+        if (!(func < this->func())) { return false; }
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (!(func < _func.load(std::memory_order_relaxed))) { return false; }
+        std::memcpy(_x.data(), x.data(), x.size() * sizeof(float));
+        _chain.store(chain, std::memory_order_release);
+        _func.store(func, std::memory_order_release);
+        return true;
+    }
+
+    /// Copies the location of the global best into \p x.
+    auto copy_to(gsl::span<float> x) const -> void
+    {
+        DUAL_ANNEALING_ASSERT(x.size() == _x.size(), "incompatible dimensions");
+        std::lock_guard<std::mutex> lock{_mutex};
+        std::memcpy(x.data(), _x.data(), x.size() * sizeof(float));
+    }
+};
+
+struct parallel_result_t {
+    result_t              best;       ///< Result of the most successful chain
+    size_t                best_chain; ///< Index of the most successful chain
+    std::vector<result_t> chains;     ///< Per-chain statistics
+};
+
+namespace detail {
+template <class Objective, class Run>
+auto minimize_parallel_impl(Objective const& obj, gsl::span<float> x,
+                            gsl::span<float const> starting_points,
+                            thread_pool_t& pool, global_best_t& global_best,
+                            Run&& run) -> parallel_result_t
+{
+    if (x.empty() || starting_points.size() % x.size() != 0) {
+        throw std::invalid_argument{
+            "minimize_parallel: size of `starting_points` is not a multiple "
+            "of the dimension of `x`"};
+    }
+    if (global_best.dim() != x.size()) {
+        throw std::invalid_argument{
+            "minimize_parallel: `global_best` has wrong dimension"};
+    }
+    auto const dim        = x.size();
+    auto const num_chains = starting_points.size() / dim;
+    if (num_chains == 0) {
+        throw std::invalid_argument{
+            "minimize_parallel: at least one starting point is required"};
+    }
+
+    std::vector<result_t> results(num_chains);
+    // Final points of all chains
+    std::vector<float> points(starting_points.begin(), starting_points.end());
+    pool.for_each(num_chains, [&](size_t const i) {
+        // Every chain gets its own copy of the objective such that objectives
+        // with internal state (caches, etc.) work out of the box. Pass
+        // `std::ref(obj)` to share a single (thread-safe) instance instead.
+        auto       local_obj = obj;
+        auto const local_x   = gsl::span<float>{points.data() + i * dim, dim};
+        results[i] = run(local_obj, local_x, i,
+                         [&global_best, i](workspace_t const& workspace) {
+                             global_best.update(i, workspace.best.func,
+                                                workspace.best.x);
+                         });
+        // Chains which stop early (e.g. due to patience) don't report their
+        // final state in `on_iteration`.
+        global_best.update(i, results[i].func, local_x);
+    });
+
+    // `global_best` may have been used (or seeded) before, so it only serves
+    // for monitoring and the result is determined from `results`.
+    auto best_chain = num_chains;
+    auto best_func  = std::numeric_limits<double>::infinity();
+    for (auto i = size_t{0}; i < num_chains; ++i) {
+        if (results[i].func < best_func) {
+            best_func  = results[i].func;
+            best_chain = i;
+        }
+    }
+    if (best_chain == num_chains) {
+        // None of the chains managed to find a finite function value. We
+        // report the first one and leave x untouched.
+        best_chain = 0;
+    }
+    else {
+        std::memcpy(x.data(), points.data() + best_chain * dim,
+                    dim * sizeof(float));
+    }
+    return parallel_result_t{results[best_chain], best_chain,
+                             std::move(results)};
+}
+} // namespace detail
+
+/// \brief Runs multiple independent annealing chains in parallel.
+///
+/// Chain `i` starts at `starting_points[i * x.size() : (i + 1) * x.size()]`
+/// and uses a random number generator obtained by calling
+/// `make_generator(i)`. Chains are distributed over the threads of \p pool.
+/// Upon return, \p x contains the best point found by any of the chains.
+///
+/// \p global_best is updated after every iteration of every chain, so it can
+/// be polled from another thread to monitor progress. It is not reset, and
+/// its previous contents don't affect the result: the best chain is chosen
+/// from the per-chain results.
+///
+/// \note Every chain works with its own copy of \p obj.
+template <class Objective, class GeneratorFactory>
+auto minimize_parallel(Objective const& obj, gsl::span<float> x,
+                       gsl::span<float const> starting_points,
+                       param_t const&         parameters,
+                       GeneratorFactory&& make_generator, thread_pool_t& pool,
+                       global_best_t& global_best) -> parallel_result_t
+{
+    return detail::minimize_parallel_impl(
+        obj, x, starting_points, pool, global_best,
+        [&parameters, &make_generator](auto& local_obj, gsl::span<float> y,
+                                       size_t const i, auto&& on_iteration) {
+            auto generator = make_generator(i);
+            return detail::minimize_impl(local_obj, y, parameters, generator,
+                                         on_iteration);
+        });
+}
+
+/// \brief Runs multiple independent annealing chains with local search in
+/// parallel.
+///
+/// See the other overload for details.
+template <class Objective, class GeneratorFactory>
+auto minimize_parallel(Objective const& obj, gsl::span<float> x,
+                       gsl::span<float const>           starting_points,
+                       param_t const&                   parameters,
+                       tcm::lbfgs::lbfgs_param_t const& local_search_parameters,
+                       GeneratorFactory&& make_generator, thread_pool_t& pool,
+                       global_best_t& global_best) -> parallel_result_t
+{
+    return detail::minimize_parallel_impl(
+        obj, x, starting_points, pool, global_best,
+        [&parameters, &local_search_parameters, &make_generator](
+            auto& local_obj, gsl::span<float> y, size_t const i,
+            auto&& on_iteration) {
+            auto generator = make_generator(i);
+            return detail::minimize_impl(local_obj, y, parameters,
+                                         local_search_parameters, generator,
+                                         on_iteration);
+        });
+}
+
+/// Same as above, but without monitoring of the global best.
+template <class Objective, class GeneratorFactory>
+auto minimize_parallel(Objective const& obj, gsl::span<float> x,
+                       gsl::span<float const> starting_points,
+                       param_t const&         parameters,
+                       GeneratorFactory&& make_generator, thread_pool_t& pool)
+    -> parallel_result_t
+{
+    global_best_t global_best{x.size()};
+    return minimize_parallel(obj, x, starting_points, parameters,
+                             std::forward<GeneratorFactory>(make_generator),
+                             pool, global_best);
+}
+
+/// Same as above, but without monitoring of the global best.
+template <class Objective, class GeneratorFactory>
+auto minimize_parallel(Objective const& obj, gsl::span<float> x,
+                       gsl::span<float const>           starting_points,
+                       param_t const&                   parameters,
+                       tcm::lbfgs::lbfgs_param_t const& local_search_parameters,
+                       GeneratorFactory&& make_generator, thread_pool_t& pool)
+    -> parallel_result_t
+{
+    global_best_t global_best{x.size()};
+    return minimize_parallel(obj, x, starting_points, parameters,
+                             local_search_parameters,
+                             std::forward<GeneratorFactory>(make_generator),
+                             pool, global_best);
+}
+
+DA_NAMESPACE_END
@@ -0,0 +1,307 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "assert.hpp"
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>   // std::copy_n, std::max
+#include <cmath>       // std::exp, std::log, std::sqrt
+#include <cstddef>     // size_t
+#include <cstdint>     // uint32_t, uint64_t
+#include <limits>      // std::numeric_limits
+#include <random>      // std::uniform_int_distribution
+#include <type_traits> // std::is_unsigned_v
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+namespace detail {
+/// Returns whether `Generator` produces uniformly distributed unsigned
+/// integers of exactly `Bits` bits.
+template <class Generator, unsigned Bits>
+constexpr auto produces_full_range() noexcept -> bool
+{
+    using result_type = typename Generator::result_type;
+    if constexpr (!std::is_unsigned_v<result_type>
+                  || std::numeric_limits<result_type>::digits != Bits) {
+        return false;
+    }
+    else {
+        return Generator::min() == 0
+               && Generator::max() == std::numeric_limits<result_type>::max();
+    }
+}
+
+/// Draws 32 uniformly distributed random bits from \p generator.
+template <class Generator>
+DA_FORCEINLINE auto random_bits32(Generator& generator) -> std::uint32_t
+{
+    if constexpr (produces_full_range<Generator, 32>()) {
+        return static_cast<std::uint32_t>(generator());
+    }
+    else if constexpr (produces_full_range<Generator, 64>()) {
+        // High bits of 64-bit generators are usually of better quality
+        return static_cast<std::uint32_t>(generator() >> 32U);
+    }
+    else {
+        return std::uniform_int_distribution<std::uint32_t>{}(generator);
+    }
+}
+
+/// Returns a uniformly distributed float in `[0, 1)` with 24 random bits.
+template <class Generator>
+DA_FORCEINLINE auto uniform_float(Generator& generator) -> float
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+    return static_cast<float>(random_bits32(generator) >> 8U)
+           * 5.9604644775390625e-8f;
+}
+
+/// Returns a uniformly distributed float in `(0, 1)`, i.e. it is safe to take
+/// the logarithm of it.
+template <class Generator>
+DA_FORCEINLINE auto uniform_float_open(Generator& generator) -> float
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+    return (static_cast<float>(random_bits32(generator) >> 9U) + 0.5f)
+           * 1.1920928955078125e-7f;
+}
+
+/// \brief Returns a uniformly distributed index in `[0, n)`.
+///
+/// Uses Lemire's multiply-and-shift without the rejection step, i.e. the
+/// bias is of order `n / 2^32`, which is fine for picking coordinates.
+/// \p n must not exceed `2^32`.
+template <class Generator>
+DA_FORCEINLINE auto uniform_index(Generator& generator, size_t const n)
+    -> size_t
+{
+    DUAL_ANNEALING_ASSERT(n <= (std::uint64_t{1} << 32U), "`n` is too big");
+    return static_cast<size_t>(
+        (static_cast<std::uint64_t>(random_bits32(generator))
+         * static_cast<std::uint64_t>(n))
+        >> 32U);
+}
+
+/// \brief Lookup tables for the Ziggurat algorithm.
+///
+/// See George Marsaglia and Wai Wan Tsang, "The Ziggurat Method for
+/// Generating Random Variables", Journal of Statistical Software 5 (2000).
+struct ziggurat_tables_t {
+    static constexpr auto size = size_t{128};
+    std::uint32_t         k[size]; ///< Thresholds for the fast path
+    float                 w[size]; ///< Width of the layers divided by 2^31
+    float                 f[size]; ///< Density at the layer boundaries
+};
+
+/// Returns the (lazily initialised) tables for the standard normal
+/// distribution.
+DA_EXPORT auto normal_ziggurat_tables() noexcept -> ziggurat_tables_t const&;
+
+/// Number of floats produced by one call to #normal_block.
+inline constexpr auto normal_block_size = size_t{32};
+
+/// \brief Transforms #normal_block_size uniformly distributed 32-bit integers
+/// into as many normally distributed floats with zero mean and standard
+/// deviation \p stddev.
+///
+/// We use the Box–Muller transform with polynomial approximations of `log`,
+/// `sin`, and `cos` (see `src/random.cpp`). The kernel is compiled for
+/// multiple instruction sets (AVX-512, AVX2, and baseline x86-64) and the best
+/// one which the CPU supports is selected at load time.
+DA_EXPORT auto normal_block(std::uint32_t const* DUAL_ANNEALING_RESTRICT bits,
+                            float* DUAL_ANNEALING_RESTRICT out,
+                            float stddev) noexcept -> void;
+
+/// \brief Fills \p out with normally distributed floats with zero mean and
+/// standard deviation \p stddev.
+template <class Generator>
+auto fill_normal(Generator& generator, gsl::span<float> out,
+                 float const stddev) -> void
+{
+    std::uint32_t bits[normal_block_size];
+    auto*         first = out.data();
+    auto          size  = out.size();
+    for (; size >= normal_block_size; size -= normal_block_size) {
+        for (auto& b : bits) {
+            b = random_bits32(generator);
+        }
+        normal_block(bits, first, stddev);
+        first += normal_block_size;
+    }
+    if (size != 0) {
+        // For the tail we generate a whole new block and throw away the parts
+        // we don't need.
+        float buffer[normal_block_size];
+        for (auto& b : bits) {
+            b = random_bits32(generator);
+        }
+        normal_block(bits, buffer, stddev);
+        std::copy_n(buffer, size, first);
+    }
+}
+} // namespace detail
+
+/// \brief Standard normal distribution using the Ziggurat method.
+///
+/// Unlike `std::normal_distribution` it produces the same stream of numbers
+/// regardless of the standard library. About 99% of the samples only need one
+/// draw of 32 bits, one table lookup, and one multiplication.
+///
+/// \warning It __does not__ model the `RandomNumberDistribution` concept.
+class normal_distribution_t {
+    detail::ziggurat_tables_t const* _tables;
+
+    template <class Generator>
+    DA_NOINLINE auto tail(Generator& generator, std::int32_t hz,
+                          size_t iz) const -> float
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+        constexpr auto r = 3.442620f; // Start of the right tail
+        for (;;) {
+            auto const x = static_cast<float>(hz) * _tables->w[iz];
+            if (iz == 0) {
+                // Sampling from the tail
+                float y, z;
+                do {
+                    y = -std::log(detail::uniform_float_open(generator)) / r;
+                    z = -std::log(detail::uniform_float_open(generator));
+                } while (z + z < y * y);
+                return hz > 0 ? r + y : -r - y;
+            }
+            if (_tables->f[iz]
+                    + detail::uniform_float(generator)
+                          * (_tables->f[iz - 1] - _tables->f[iz])
+                < std::exp(-0.5f * x * x)) {
+                return x;
+            }
+            hz = static_cast<std::int32_t>(detail::random_bits32(generator));
+            iz = static_cast<size_t>(hz) & (detail::ziggurat_tables_t::size - 1);
+            if (abs(hz) < _tables->k[iz]) {
+                return static_cast<float>(hz) * _tables->w[iz];
+            }
+        }
+    }
+
+    static constexpr auto abs(std::int32_t const x) noexcept -> std::uint32_t
+    {
+        // NOTE: this works for INT32_MIN as well
+        return x < 0 ? std::uint32_t{0} - static_cast<std::uint32_t>(x)
+                     : static_cast<std::uint32_t>(x);
+    }
+
+  public:
+    using result_type = float;
+
+    normal_distribution_t() noexcept
+        : _tables{&detail::normal_ziggurat_tables()}
+    {}
+
+    template <class Generator>
+    DA_FORCEINLINE auto operator()(Generator& generator) const -> float
+    {
+        auto const hz =
+            static_cast<std::int32_t>(detail::random_bits32(generator));
+        auto const iz =
+            static_cast<size_t>(hz) & (detail::ziggurat_tables_t::size - 1);
+        if (DUAL_ANNEALING_LIKELY(abs(hz) < _tables->k[iz])) {
+            return static_cast<float>(hz) * _tables->w[iz];
+        }
+        return tail(generator, hz, iz);
+    }
+};
+
+/// \brief Gamma distribution with unit scale using the method of Marsaglia
+/// and Tsang.
+///
+/// See George Marsaglia and Wai Wan Tsang, "A Simple Method for Generating
+/// Gamma Variables", ACM Transactions on Mathematical Software 26 (2000). For
+/// `shape < 1` we sample with `shape + 1` and multiply by `U^(1/shape)`.
+///
+/// \note For small shapes `U^(1/shape)` underflows regularly. We therefore
+/// clamp results from below at the smallest normal float such that
+/// `1 / sqrt(x)` stays finite.
+///
+/// \warning It __does not__ model the `RandomNumberDistribution` concept.
+class gamma_distribution_t {
+    float                 _shape;
+    float                 _d; ///< `shape - 1/3` (or `shape + 2/3` if boosted)
+    float                 _c; ///< `1 / sqrt(9 d)`
+    normal_distribution_t _normal;
+
+  public:
+    using result_type = float;
+
+    explicit gamma_distribution_t(float const shape) noexcept
+        : _shape{}, _d{}, _c{}, _normal{}
+    {
+        param(shape);
+    }
+
+    [[nodiscard]] constexpr auto shape() const noexcept { return _shape; }
+
+    auto param(float const shape) noexcept -> void
+    {
+        DUAL_ANNEALING_ASSERT(shape > 0.0f, "`shape` must be positive");
+        _shape = shape;
+        _d     = (shape < 1.0f ? shape + 1.0f : shape) - 1.0f / 3.0f;
+        _c     = 1.0f / std::sqrt(9.0f * _d);
+    }
+
+    template <class Generator> auto operator()(Generator& generator) const
+        -> float
+    {
+        float x, v;
+        for (;;) {
+            do {
+                x = _normal(generator);
+                v = 1.0f + _c * x;
+            } while (v <= 0.0f);
+            v            = v * v * v;
+            auto const u = detail::uniform_float_open(generator);
+            auto const x_2 = x * x;
+            // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+            if (u < 1.0f - 0.0331f * x_2 * x_2) { break; }
+            if (std::log(u) < 0.5f * x_2 + _d * (1.0f - v + std::log(v))) {
+                break;
+            }
+        }
+        auto const result = _d * v;
+        if (_shape >= 1.0f) { return result; }
+        // U^(1/shape) written such that underflow results in 0 rather than
+        // NaN or infinity.
+        auto const boost =
+            std::exp(std::log(detail::uniform_float_open(generator)) / _shape);
+        return std::max(result * boost, std::numeric_limits<float>::min());
+    }
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -0,0 +1,231 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "buffers.hpp"
+#include "chain.hpp"
+#include "config.hpp"
+#include "thread_pool.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm>   // std::min
+#include <cmath>       // std::exp, std::pow
+#include <cstddef>     // size_t
+#include <cstring>     // std::memcpy
+#include <limits>      // std::numeric_limits
+#include <memory>      // std::unique_ptr
+#include <random>      // std::uniform_real_distribution
+#include <stdexcept>   // std::invalid_argument
+#include <type_traits> // std::decay_t
+#include <vector>      // std::vector
+
+DA_NAMESPACE_BEGIN
+
+/// \brief Parameters of the replica-exchange (parallel tempering) driver.
+///
+/// Replica `k` (`0 <= k < num_replicas`) runs at visiting temperature
+/// `t_V[k] = t_V_min * (t_V_max / t_V_min)^(k / (num_replicas - 1))` and
+/// acceptance temperature `t_A[k]` which is defined analogously. I.e. both
+/// ladders are geometric with replica `0` being the coldest one.
+struct replica_param_t {
+    size_t num_replicas;  ///< Number of replicas K
+    float  t_V_min;       ///< Visiting temperature of the coldest replica
+    float  t_V_max;       ///< Visiting temperature of the hottest replica
+    float  t_A_min;       ///< Acceptance temperature of the coldest replica
+    float  t_A_max;       ///< Acceptance temperature of the hottest replica
+    size_t num_sweeps;    ///< Maximal number of Markov chain steps per replica
+    size_t swap_interval; ///< Number of steps between exchange attempts
+    double target;        ///< Stop as soon as a replica reaches this value
+};
+
+struct replica_exchange_result_t {
+    result_t best;       ///< Total statistics and the best function value
+    size_t   best_replica; ///< Index of the replica which found the best point
+    std::vector<double> swap_acceptance; ///< Between replicas k and k + 1
+};
+
+namespace detail {
+inline auto geometric_ladder(float const min, float const max,
+                             size_t const k, size_t const n) noexcept -> float
+{
+    if (n == 1) { return min; }
+    auto const t = static_cast<float>(k) / static_cast<float>(n - 1);
+    return min * std::pow(max / min, t);
+}
+} // namespace detail
+
+/// \brief Minimises \p obj using replica exchange.
+///
+/// Every replica is an #sa_chain_t which runs #sa_chain_t::step at its own
+/// fixed temperature. Steps of different replicas run in parallel on \p pool.
+/// Every `swap_interval` steps we attempt to exchange the current states of
+/// neighbouring replicas (alternating between even and odd pairs). Since the
+/// Tsallis acceptance rule has no natural exchange counterpart, swaps use the
+/// Metropolis criterion `min(1, exp((E_k - E_{k+1}) * (1/t_A[k] -
+/// 1/t_A[k+1])))`.
+///
+/// The exchange itself is O(1): only the `current` points of the workspaces
+/// are swapped, i.e. the buffers change owners and no data is copied.
+///
+/// All replicas start at \p x. Replica `k` uses `make_generator(k)` as its
+/// source of randomness and `make_generator(num_replicas)` is used for the
+/// exchange decisions. Upon return \p x contains the best point found.
+///
+/// \note Similar to #minimize_parallel, every replica works with its own copy
+/// of \p obj.
+template <class Objective, class GeneratorFactory>
+auto replica_exchange(Objective const& obj, gsl::span<float> x,
+                      param_t const&         parameters,
+                      replica_param_t const& replica_parameters,
+                      GeneratorFactory&& make_generator, thread_pool_t& pool)
+    -> replica_exchange_result_t
+{
+    using objective_type = std::decay_t<Objective>;
+    using generator_type = std::decay_t<decltype(make_generator(size_t{0}))>;
+    using chain_type     = sa_chain_t<objective_type, generator_type>;
+
+    auto const num_replicas = replica_parameters.num_replicas;
+    if (num_replicas == 0) {
+        throw std::invalid_argument{
+            "replica_exchange: at least one replica is required"};
+    }
+    if (replica_parameters.swap_interval == 0) {
+        throw std::invalid_argument{
+            "replica_exchange: swap_interval must be positive"};
+    }
+
+    // NOTE: chains keep references to workspaces and generators, so these
+    // vectors must never reallocate.
+    std::vector<sa_buffers_t>   buffers;
+    std::vector<workspace_t>    workspaces;
+    std::vector<generator_type> generators;
+    std::vector<float>          t_V(num_replicas);
+    std::vector<float>          t_A(num_replicas);
+    buffers.reserve(num_replicas);
+    workspaces.reserve(num_replicas);
+    generators.reserve(num_replicas);
+    for (auto k = size_t{0}; k < num_replicas; ++k) {
+        buffers.emplace_back(x.size());
+        workspaces.push_back(buffers.back().workspace());
+        std::memcpy(workspaces.back().current.x.data(), x.data(),
+                    x.size() * sizeof(float));
+        generators.push_back(make_generator(k));
+        t_V[k] = detail::geometric_ladder(replica_parameters.t_V_min,
+                                          replica_parameters.t_V_max, k,
+                                          num_replicas);
+        t_A[k] = detail::geometric_ladder(replica_parameters.t_A_min,
+                                          replica_parameters.t_A_max, k,
+                                          num_replicas);
+    }
+    auto swap_generator = make_generator(num_replicas);
+
+    std::vector<std::unique_ptr<chain_type>> chains(num_replicas);
+    pool.for_each(num_replicas, [&](size_t const k) {
+        chains[k] = std::make_unique<chain_type>(obj, workspaces[k], parameters,
+                                                 generators[k]);
+    });
+
+    auto const best_replica = [&workspaces]() {
+        auto best = size_t{0};
+        for (auto k = size_t{1}; k < workspaces.size(); ++k) {
+            if (workspaces[k].best.func < workspaces[best].best.func) {
+                best = k;
+            }
+        }
+        return best;
+    };
+
+    std::vector<size_t> num_attempts(num_replicas > 1 ? num_replicas - 1 : 0);
+    std::vector<size_t> num_swaps(num_attempts.size());
+    auto                sweep = size_t{0};
+    auto                round = size_t{0};
+    while (sweep < replica_parameters.num_sweeps
+           && workspaces[best_replica()].best.func > replica_parameters.target) {
+        auto const steps = std::min(replica_parameters.swap_interval,
+                                    replica_parameters.num_sweeps - sweep);
+        pool.for_each(num_replicas, [&](size_t const k) {
+            for (auto i = size_t{0}; i < steps; ++i) {
+                (*chains[k]).step(t_V[k], t_A[k]);
+            }
+        });
+        sweep += steps;
+
+        // Even rounds try pairs (0, 1), (2, 3), ..., odd rounds -- (1, 2),
+        // (3, 4), ...
+        for (auto k = round % 2; k + 1 < num_replicas; k += 2) {
+            auto& cold = workspaces[k].current;
+            auto& hot  = workspaces[k + 1].current;
+            auto const log_P =
+                (cold.func - hot.func)
+                * (1.0 / static_cast<double>(t_A[k])
+                   - 1.0 / static_cast<double>(t_A[k + 1]));
+            ++num_attempts[k];
+            if (log_P >= 0.0
+                || std::uniform_real_distribution<double>{}(swap_generator)
+                       < std::exp(log_P)) {
+                using std::swap;
+                chains[k]->sync_best();
+                chains[k + 1]->sync_best();
+                swap(cold, hot);
+                chains[k]->current_changed();
+                chains[k + 1]->current_changed();
+                ++num_swaps[k];
+            }
+        }
+        ++round;
+    }
+
+    auto const best  = best_replica();
+    auto       total = result_t{/*func=*/workspaces[best].best.func,
+                          /*num_iter=*/sweep,
+                          /*num_f_evals=*/0,
+                          /*acceptance=*/0.0};
+    for (auto const& chain : chains) {
+        total.num_f_evals += chain->num_f_evals();
+        total.acceptance += chain->acceptance();
+        total.num_accepted += chain->num_accepted();
+    }
+    total.acceptance /= static_cast<double>(num_replicas);
+    chains[best]->sync_best();
+    std::memcpy(x.data(), workspaces[best].best.x.data(),
+                x.size() * sizeof(float));
+
+    std::vector<double> swap_acceptance(num_attempts.size());
+    for (auto k = size_t{0}; k < num_attempts.size(); ++k) {
+        swap_acceptance[k] =
+            num_attempts[k] == 0
+                ? std::numeric_limits<double>::quiet_NaN()
+                : static_cast<double>(num_swaps[k])
+                      / static_cast<double>(num_attempts[k]);
+    }
+    return replica_exchange_result_t{total, best, std::move(swap_acceptance)};
+}
+
+DA_NAMESPACE_END
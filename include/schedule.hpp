@@ -0,0 +1,159 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file schedule.hpp
+/// \brief Temperature schedule and acceptance rule of generalised simulated
+/// annealing, with the expensive parts computed ahead of time.
+
+#pragma once
+
+#include "assert.hpp"
+#include "config.hpp"
+#include "tsallis_distribution.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cmath>   // std::pow
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
+#include <vector>  // std::vector
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+namespace detail {
+/// Visiting temperature `t_V` of iteration \p i.
+inline auto visiting_temperature(float const q_V, float const t_0,
+                                 size_t const i) noexcept -> float
+{
+    auto const num = t_0 * (std::pow(2.0f, q_V - 1.0f) - 1.0f);
+    auto const den = std::pow(static_cast<float>(2 + i), q_V - 1.0f) - 1.0f;
+    return num / den;
+}
+
+/// \brief The Tsallis acceptance rule for a fixed `q_A`.
+///
+/// A move which increases the energy by `dE >= 0` is accepted with
+/// probability `p = [1 + (q_A - 1) dE / t_A]^(1 / (1 - q_A))`, i.e. if
+/// `u <= p` for a uniform `u`. When `n = 1 - q_A` is a small integer (e.g.
+/// `n = 6` for the usual `q_A = -5`) we test the equivalent `u^n <= p^n`
+/// instead, which costs a few multiplications rather than a `std::pow`.
+class acceptance_rule_t {
+    float    _q_A;
+    float    _exponent; ///< `1 / (1 - q_A)`
+    unsigned _power;    ///< `1 - q_A` if it is a small integer, 0 otherwise
+
+    static constexpr auto max_power = 64U;
+
+    static auto integer_power(float x, unsigned n) noexcept -> float
+    {
+        auto r = 1.0f;
+        for (; n != 0; n >>= 1U) {
+            if ((n & 1U) != 0) { r *= x; }
+            x *= x;
+        }
+        return r;
+    }
+
+  public:
+    explicit acceptance_rule_t(float const q_A) noexcept
+        : _q_A{q_A}, _exponent{1.0f / (1.0f - q_A)}, _power{0}
+    {
+        auto const n = 1.0f - q_A;
+        if (n >= 1.0f && n <= static_cast<float>(max_power)
+            && static_cast<float>(static_cast<unsigned>(n)) == n) {
+            _power = static_cast<unsigned>(n);
+        }
+    }
+
+    [[nodiscard]] auto q_A() const noexcept -> float { return _q_A; }
+
+    /// \brief Probability of accepting a move which increases the energy by
+    /// \p dE >= 0 at acceptance temperature \p t_A.
+    [[nodiscard]] auto probability(float const dE, float const t_A) const
+        noexcept -> float
+    {
+        // Eq. (5)
+        auto const factor = 1.0f + (_q_A - 1.0f) * dE / t_A;
+        return factor <= 0.0f ? 0.0f : std::pow(factor, _exponent);
+    }
+
+    /// \brief Whether a move with energy difference \p dE is accepted given
+    /// a uniform random number \p u in `[0, 1)`.
+    [[nodiscard]] DA_FORCEINLINE auto accepts(float const u, float const dE,
+                                              float const t_A) const noexcept
+        -> bool
+    {
+        // Always accept moves that reduce the energy
+        if (dE < 0.0f) { return true; }
+        if (_power == 0) { return u <= probability(dE, t_A); }
+        auto const factor = 1.0f + (_q_A - 1.0f) * dE / t_A;
+        return factor > 0.0f && integer_power(u, _power) <= factor;
+    }
+
+    /// \brief Bulk version of the above, i.e. `out[i] = accepts(u[i], dE[i],
+    /// t_A)` for all `i`.
+    ///
+    /// Uses SIMD instructions when `1 - q_A` is a small integer.
+    auto accepts(gsl::span<float const> u, gsl::span<float const> dE,
+                 float t_A, gsl::span<std::uint8_t> out) const noexcept
+        -> void;
+};
+} // namespace detail
+
+/// \brief Visiting temperatures and Tsallis parameters of all iterations.
+///
+/// Every iteration of #sa_chain_t otherwise spends three `std::pow` calls on
+/// its temperatures. That's noticeable for small problems, particularly when
+/// many chains with the same parameters are run. Build the table once and
+/// point #param_t::temperatures to it to share it between chains.
+class temperature_table_t {
+    float                                           _q_V;
+    float                                           _t_0;
+    std::vector<tsallis_distribution_t::param_type> _params;
+
+  public:
+    /// Precomputes the schedule for the first \p num_iter iterations.
+    temperature_table_t(float q_V, float t_0, size_t num_iter);
+
+    [[nodiscard]] auto q_V() const noexcept -> float { return _q_V; }
+    [[nodiscard]] auto t_0() const noexcept -> float { return _t_0; }
+    [[nodiscard]] auto size() const noexcept -> size_t
+    {
+        return _params.size();
+    }
+
+    /// Parameters of the visiting distribution in iteration \p i.
+    [[nodiscard]] auto operator[](size_t const i) const noexcept
+        -> tsallis_distribution_t::param_type const&
+    {
+        DUAL_ANNEALING_ASSERT(i < size(), "index out of bounds");
+        return _params[i];
+    }
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -0,0 +1,193 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "assert.hpp"
+#include "config.hpp"
+#include "objective.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <cstddef>     // size_t
+#include <type_traits> // std::enable_if_t
+#include <utility>     // std::declval, std::pair, std::move
+
+DA_NAMESPACE_BEGIN
+
+namespace detail {
+/// \brief Determines whether `T` has a member function `term` which can be
+/// called with `size_t` and `float`.
+template <class T, class = void> struct has_term_mem_fn : std::false_type {};
+
+template <class T>
+struct has_term_mem_fn<T, std::void_t<decltype(std::declval<T>().term(
+                              std::declval<size_t>(), std::declval<float>()))>>
+    : std::true_type {};
+
+template <class T>
+inline constexpr auto has_term_mem_fn_v = has_term_mem_fn<T>::value;
+
+/// \brief Determines whether `T` has a member function `derivative` which can
+/// be called with `size_t` and `float`.
+template <class T, class = void>
+struct has_derivative_mem_fn : std::false_type {};
+
+template <class T>
+struct has_derivative_mem_fn<
+    T, std::void_t<decltype(std::declval<T>().derivative(
+           std::declval<size_t>(), std::declval<float>()))>> : std::true_type {
+};
+
+template <class T>
+inline constexpr auto has_derivative_mem_fn_v = has_derivative_mem_fn<T>::value;
+} // namespace detail
+
+/// \brief Objective of the form `f(x) = Σᵢ term(i, xᵢ)`.
+///
+/// The user only provides the terms, i.e. an object `terms` for which
+/// `terms.term(i, x)` returns the contribution of the `i`'th coordinate. From
+/// it #separable_t builds everything #sa_chain_t needs:
+///
+///   * `value` which sums all the terms;
+///   * `value_from_diff` which costs two evaluations of `term` instead of D;
+///   * `value_from_sparse_diff` which costs `2k` for a move of `k`
+///     coordinates;
+///   * `coordinate_deltas` for sweeping over all coordinates in one pass;
+///   * `value_and_gradient` (only if `terms.derivative(i, x)` is a valid
+///     expression) for the local search;
+///   * `wrap` (only if `terms.wrap(x)` is a valid expression, and similarly
+///     for the bulk `wrap(gsl::span<float>)`);
+///   * `bounds` (only if `terms.bounds()` is a valid expression).
+template <class Terms> class separable_t {
+    static_assert(detail::has_term_mem_fn_v<Terms const&>,
+                  "Terms is missing 'term' member function.");
+
+    Terms _terms;
+
+    auto term(size_t const i, float const x) const -> double
+    {
+        return static_cast<double>(_terms.term(i, x));
+    }
+
+  public:
+    using terms_type = Terms;
+
+    constexpr separable_t() = default;
+    explicit constexpr separable_t(Terms terms) noexcept(
+        std::is_nothrow_move_constructible_v<Terms>)
+        : _terms{std::move(terms)}
+    {}
+
+    [[nodiscard]] constexpr auto terms() const noexcept -> Terms const&
+    {
+        return _terms;
+    }
+
+    auto value(gsl::span<float const> x) const -> double
+    {
+        auto sum = 0.0;
+        for (auto i = size_t{0}; i < x.size(); ++i) {
+            sum += term(i, x[i]);
+        }
+        return sum;
+    }
+
+    auto value_from_diff(std::pair<gsl::span<float const>, double> current,
+                         std::pair<size_t, float> diff) const -> double
+    {
+        auto const [i, x] = diff;
+        return current.second - term(i, current.first[i]) + term(i, x);
+    }
+
+    auto value_from_sparse_diff(
+        std::pair<gsl::span<float const>, double> current,
+        gsl::span<std::pair<size_t, float> const> diff) const -> double
+    {
+        auto func = current.second;
+        for (auto const& [i, x] : diff) {
+            func += term(i, x) - term(i, current.first[i]);
+        }
+        return func;
+    }
+
+    auto coordinate_deltas(gsl::span<float const> x, gsl::span<float const> ys,
+                           gsl::span<double> out) const -> void
+    {
+        DUAL_ANNEALING_ASSERT(x.size() == ys.size() && x.size() == out.size(),
+                              "incompatible dimensions");
+        for (auto i = size_t{0}; i < x.size(); ++i) {
+            out[i] = term(i, ys[i]) - term(i, x[i]);
+        }
+    }
+
+    template <class T = Terms,
+              class   = std::enable_if_t<detail::has_derivative_mem_fn_v<T const&>>>
+    auto value_and_gradient(gsl::span<float const> x, gsl::span<float> g) const
+        -> double
+    {
+        DUAL_ANNEALING_ASSERT(x.size() == g.size(), "incompatible dimensions");
+        // Two separate loops such that each of them can be vectorised if the
+        // terms are simple enough.
+        for (auto i = size_t{0}; i < x.size(); ++i) {
+            g[i] = static_cast<float>(_terms.derivative(i, x[i]));
+        }
+        return value(x);
+    }
+
+    template <class T = Terms,
+              class   = std::enable_if_t<detail::has_wrap_mem_fn_v<T const&, float>>>
+    auto wrap(float const x) const -> float
+    {
+        return _terms.wrap(x);
+    }
+
+    template <class T = Terms,
+              class   = std::enable_if_t<
+                  detail::has_wrap_mem_fn_v<T const&, gsl::span<float>>>>
+    auto wrap(gsl::span<float> x) const -> void
+    {
+        _terms.wrap(x);
+    }
+
+    template <class T = Terms,
+              class   = std::enable_if_t<detail::has_bounds_mem_fn_v<T const&>>>
+    auto bounds() const -> decltype(std::declval<T const&>().bounds())
+    {
+        return _terms.bounds();
+    }
+};
+
+template <class Terms>
+constexpr auto make_separable(Terms&& terms)
+    -> separable_t<std::decay_t<Terms>>
+{
+    return separable_t<std::decay_t<Terms>>{std::forward<Terms>(terms)};
+}
+
+DA_NAMESPACE_END
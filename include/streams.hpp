@@ -0,0 +1,233 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <array>       // std::array
+#include <cstddef>     // size_t
+#include <cstdint>     // uint32_t, uint64_t
+#include <limits>      // std::numeric_limits
+#include <type_traits> // std::true_type, std::false_type
+#include <utility>     // std::declval
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// \brief Philox4x32-10 counter-based random number generator.
+///
+/// See Salmon et al., "Parallel random numbers: as easy as 1, 2, 3" (SC'11).
+/// The output is a bijection of a 128-bit counter keyed by the 64-bit seed,
+/// so generators are cheap to construct, have no state worth speaking of,
+/// and can jump to any position in O(1).
+///
+/// The counter is split into a 64-bit \p stream (usually the chain id) and
+/// a 64-bit position within the stream. #sa_chain_t calls #set_iteration at
+/// the start of each iteration, so that the random numbers used by iteration
+/// `i` are a function of `(seed, stream, i)` only. Hence any iteration of
+/// any chain can be replayed in isolation given the state of the chain.
+///
+/// \note Because of the above, two chains driven by the same generator
+/// (e.g. successive calls to #minimize) see the same random numbers. Use a
+/// separate stream per chain, see #stream_factory_t.
+///
+/// Satisfies the UniformRandomBitGenerator requirements.
+class philox4x32_t {
+  public:
+    using result_type = std::uint32_t;
+    /// Number of outputs produced by one application of the bijection.
+    static constexpr auto block_size = size_t{4};
+    using block_type                 = std::array<std::uint32_t, 4>;
+    using key_type                   = std::array<std::uint32_t, 2>;
+
+  private:
+    key_type                     _key;     ///< Seed
+    block_type                   _counter; ///< Position and stream
+    block_type                   _block;   ///< Output of the current counter
+    /// Number of already consumed elements of #_block.
+    std::uint32_t _used;
+
+    static constexpr auto mulhilo(std::uint32_t const a, std::uint32_t const b,
+                                  std::uint32_t& hi) noexcept -> std::uint32_t
+    {
+        auto const p = static_cast<std::uint64_t>(a) * b;
+        hi           = static_cast<std::uint32_t>(p >> 32U);
+        return static_cast<std::uint32_t>(p);
+    }
+
+  public:
+    /// \brief The Philox4x32-10 bijection of counter \p c keyed by \p k.
+    ///
+    /// Same as `philox4x32<10>` of Random123, whose known-answer vectors it
+    /// reproduces. The generator's output is `bijection(counter, seed)`.
+    static constexpr auto bijection(block_type c, key_type k) noexcept
+        -> block_type
+    {
+        constexpr auto m0 = std::uint32_t{0xD2511F53};
+        constexpr auto m1 = std::uint32_t{0xCD9E8D57};
+        constexpr auto w0 = std::uint32_t{0x9E3779B9};
+        constexpr auto w1 = std::uint32_t{0xBB67AE85};
+        for (auto round = 0; round < 10; ++round) {
+            if (round != 0) {
+                k[0] += w0;
+                k[1] += w1;
+            }
+            std::uint32_t hi0 = 0;
+            std::uint32_t hi1 = 0;
+            auto const    lo0 = mulhilo(m0, c[0], hi0);
+            auto const    lo1 = mulhilo(m1, c[2], hi1);
+            c = block_type{hi1 ^ c[1] ^ k[0], lo1, hi0 ^ c[3] ^ k[1], lo0};
+        }
+        return c;
+    }
+
+  private:
+    /// 64-bit position within the stream.
+    constexpr auto position() const noexcept -> std::uint64_t
+    {
+        return (static_cast<std::uint64_t>(_counter[1]) << 32U) | _counter[0];
+    }
+
+    constexpr auto set_position(std::uint64_t const n) noexcept -> void
+    {
+        _counter[0] = static_cast<std::uint32_t>(n);
+        _counter[1] = static_cast<std::uint32_t>(n >> 32U);
+    }
+
+  public:
+    /// \brief Creates the generator for stream \p stream of \p seed.
+    ///
+    /// Different streams of the same seed are statistically independent.
+    explicit constexpr philox4x32_t(std::uint64_t const seed   = 0,
+                                    std::uint64_t const stream = 0) noexcept
+        : _key{static_cast<std::uint32_t>(seed),
+               static_cast<std::uint32_t>(seed >> 32U)}
+        , _counter{0, 0, static_cast<std::uint32_t>(stream),
+                   static_cast<std::uint32_t>(stream >> 32U)}
+        , _block{}
+        , _used{block_size}
+    {}
+
+    static constexpr auto min() noexcept -> result_type { return 0; }
+    static constexpr auto max() noexcept -> result_type
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr auto operator()() noexcept -> result_type
+    {
+        if (DUAL_ANNEALING_UNLIKELY(_used == block_size)) {
+            _block = bijection(_counter, _key);
+            set_position(position() + 1);
+            _used = 0;
+        }
+        return _block[_used++];
+    }
+
+    /// \brief Advances the generator by \p n outputs in O(1).
+    constexpr auto discard(std::uint64_t n) noexcept -> void
+    {
+        auto const left = static_cast<std::uint64_t>(block_size - _used);
+        if (n <= left) {
+            _used += static_cast<std::uint32_t>(n);
+            return;
+        }
+        n -= left;
+        // Skip whole blocks and then regenerate the partial one
+        set_position(position() + (n - 1) / block_size);
+        _used = block_size;
+        (*this)();
+        _used = static_cast<std::uint32_t>((n - 1) % block_size + 1);
+    }
+
+    /// Returns the stream passed to the constructor.
+    constexpr auto stream() const noexcept -> std::uint64_t
+    {
+        return (static_cast<std::uint64_t>(_counter[3]) << 32U) | _counter[2];
+    }
+
+    /// \brief Moves to the beginning of the sub-stream of iteration \p i.
+    ///
+    /// Every iteration gets `2^34` numbers, which is more than any iteration
+    /// of the annealing schedule could consume.
+    constexpr auto set_iteration(std::uint64_t const i) noexcept -> void
+    {
+        set_position(i << 32U);
+        _used = block_size;
+    }
+
+    friend constexpr auto operator==(philox4x32_t const& a,
+                                     philox4x32_t const& b) noexcept -> bool
+    {
+        // Unused parts of `_block` don't matter, and `_block` itself is a
+        // function of the rest.
+        return a._key == b._key && a._counter == b._counter
+               && a._used == b._used;
+    }
+
+    friend constexpr auto operator!=(philox4x32_t const& a,
+                                     philox4x32_t const& b) noexcept -> bool
+    {
+        return !(a == b);
+    }
+};
+
+/// \brief A `GeneratorFactory` for #minimize_parallel and #replica_exchange
+/// which returns stream `i` of a fixed seed for chain `i`.
+///
+/// As the stream only depends on the chain id, results are bit-identical
+/// regardless of the number of threads and of scheduling, and a single chain
+/// can be re-run on its own via `minimize(..., streams(i))`.
+///
+/// `Generator` must be constructible as `Generator{seed, stream}`, e.g.
+/// #philox4x32_t or `pcg32`.
+template <class Generator = philox4x32_t> struct stream_factory_t {
+    std::uint64_t seed;
+
+    auto operator()(size_t const chain) const -> Generator
+    {
+        return Generator{seed, static_cast<std::uint64_t>(chain)};
+    }
+};
+
+namespace detail {
+/// Checks whether `T` has a `set_iteration(i)` member function, see
+/// #philox4x32_t::set_iteration.
+template <class T, class = void>
+struct has_set_iteration_mem_fn : std::false_type {};
+
+template <class T>
+struct has_set_iteration_mem_fn<
+    T, std::void_t<decltype(std::declval<T&>().set_iteration(
+           std::declval<std::uint64_t>()))>> : std::true_type {};
+
+template <class T>
+constexpr auto has_set_iteration_mem_fn_v = has_set_iteration_mem_fn<T>::value;
+} // namespace detail
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -0,0 +1,79 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef>    // size_t
+#include <functional> // std::function
+#include <memory>     // std::unique_ptr
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// \brief A fixed-size pool of worker threads.
+///
+/// The pool only supports one kind of job: "run this task for every index in
+/// `[0, n)`". This is all the parallel drivers in this library need, and it
+/// allows us to get away without task queues and futures.
+///
+/// \note The thread calling #for_each participates in the computation, i.e. a
+/// pool with `num_threads` threads spawns `num_threads - 1` workers.
+class thread_pool_t {
+  public:
+    /// \brief Creates a pool with \p num_threads threads.
+    ///
+    /// \p num_threads == 0 means "use `std::thread::hardware_concurrency()`".
+    explicit thread_pool_t(size_t num_threads = 0);
+    ~thread_pool_t() noexcept;
+
+    thread_pool_t(thread_pool_t const&) = delete;
+    thread_pool_t(thread_pool_t&&)      = delete;
+    auto operator=(thread_pool_t const&) -> thread_pool_t& = delete;
+    auto operator=(thread_pool_t&&) -> thread_pool_t& = delete;
+
+    /// Returns the number of threads (including the calling one) which
+    /// execute tasks.
+    [[nodiscard]] auto num_threads() const noexcept -> size_t;
+
+    /// \brief Calls `task(i)` for every `i` in `[0, n)` and blocks until all
+    /// calls have finished.
+    ///
+    /// The order in which indices are processed is unspecified. If some calls
+    /// throw, the first exception is re-thrown after all other tasks have
+    /// finished. Calling #for_each from within a task is allowed, the nested
+    /// job is then executed sequentially on the calling thread.
+    auto for_each(size_t n, std::function<void(size_t)> const& task)
+        -> void;
+
+  private:
+    struct impl_t;
+    std::unique_ptr<impl_t> _impl;
+};
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -30,14 +30,23 @@
 
 #include "assert.hpp"
 #include "config.hpp"
+#include "random.hpp"
 
-#include <cmath>  // std::sqrt, std::pow
-#include <random> // std::normal_distribution, std::gamma_distribution
+#include <gsl/gsl-lite.hpp>
+
+#include <cmath>   // std::sqrt, std::pow
+#include <numeric> // std::accumulate
 
 DUAL_ANNEALING_NAMESPACE_BEGIN
 
 /// \brief Tsallis distribution.
 ///
+/// Samples are obtained by dividing a normally distributed number by the
+/// square root of a gamma distributed one [@Schanze2006]. We use our own
+/// #normal_distribution_t and #gamma_distribution_t for this rather than the
+/// ones from the standard library: they are faster and produce identical
+/// streams on all platforms.
+///
 /// \warning It __does not__ model the `RandomNumberDistribution` concept.
 struct tsallis_distribution_t {
     using real_type   = float;
@@ -121,9 +130,7 @@ struct tsallis_distribution_t {
 
     explicit tsallis_distribution_t(real_type const q_V,
                                     real_type const t_V) noexcept
-        : _gamma_dist{get_p(q_V), real_type{1}}
-        , _normal_dist{real_type{0}, real_type{1}}
-        , _params{q_V, t_V}
+        : _gamma_dist{get_p(q_V)}, _normal_dist{}, _params{q_V, t_V}
     {}
 
     tsallis_distribution_t(tsallis_distribution_t const&) noexcept = default;
@@ -142,14 +149,12 @@ struct tsallis_distribution_t {
         return _params;
     }
 
-    constexpr auto param(param_type const& params) noexcept -> void
+    auto param(param_type const& params) noexcept -> void
     {
         // NOTE: this is an optimisation since gamma_distribution has some
         // internal state which we don't want to screw up needlessly.
         if (_params.q_V() != params.q_V()) {
-            _gamma_dist.param(
-                typename std::gamma_distribution<real_type>::param_type{
-                    get_p(params.q_V()), real_type{1}});
+            _gamma_dist.param(get_p(params.q_V()));
         }
         _params = params;
     }
@@ -170,10 +175,48 @@ struct tsallis_distribution_t {
     {
         auto const u = _gamma_dist(generator);
         auto const y = _params.s() * std::sqrt(u);
-        return [normal_dist =
-                    std::normal_distribution<real_type>{real_type{0},
-                                                        real_type{1} / y},
-                &generator]() mutable { return normal_dist(generator); };
+        return [normal_dist = _normal_dist, scale = real_type{1} / y,
+                &generator]() { return scale * normal_dist(generator); };
+    }
+
+    /// \brief Draws a vector from the N-D distribution where `N =
+    /// out.size()` and stores it in \p out.
+    ///
+    /// This is equivalent to calling the function returned by #many `N`
+    /// times, but much faster since normally distributed numbers are
+    /// generated in bulk using SIMD instructions (see
+    /// `detail::normal_block`).
+    template <class Generator>
+    auto fill(Generator& generator, gsl::span<float> out) -> void
+    {
+        detail::fill_normal(generator, out, scale(generator));
+    }
+
+    /// \brief Draws `out.size()` independent samples from the 1D
+    /// distribution and stores them in \p out.
+    ///
+    /// Same distribution as calling #operator() for every element, but the
+    /// normally distributed parts are generated in bulk.
+    template <class Generator>
+    auto fill_independent(Generator& generator, gsl::span<float> out) -> void
+    {
+        detail::fill_normal(generator, out, real_type{1});
+        for (auto& x : out) {
+            x *= scale(generator);
+        }
+    }
+
+    /// \brief Draws the scale of an N-D sample.
+    ///
+    /// An N-D sample is `scale(generator)` times a vector of N independent
+    /// standard normal numbers. This allows to generate the normal numbers of
+    /// many samples in bulk.
+    template <class Generator>
+    [[nodiscard]] auto scale(Generator& generator) noexcept -> real_type
+    {
+        auto const u = _gamma_dist(generator);
+        auto const y = _params.s() * std::sqrt(u);
+        return real_type{1} / y;
     }
 
     template <int64_t D = -1> auto exact() const noexcept
@@ -217,9 +260,9 @@ struct tsallis_distribution_t {
     }
 
   private:
-    std::gamma_distribution<real_type>  _gamma_dist;
-    std::normal_distribution<real_type> _normal_dist;
-    param_type                          _params;
+    gamma_distribution_t  _gamma_dist;
+    normal_distribution_t _normal_dist;
+    param_type            _params;
 };
 
 DUAL_ANNEALING_NAMESPACE_END
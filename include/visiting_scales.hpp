@@ -0,0 +1,135 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file visiting_scales.hpp
+/// \brief Per-coordinate scales of the visiting distribution which adapt to a
+/// target acceptance rate.
+
+#pragma once
+
+#include "assert.hpp"
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+
+#include <algorithm> // std::clamp
+#include <cstddef>   // size_t
+#include <cstring>   // std::memcpy
+#include <vector>    // std::vector
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+namespace detail {
+/// \brief Scales by which steps of the visiting distribution are multiplied,
+/// one per coordinate.
+///
+/// After every single-coordinate move, the scale `s_i` of its coordinate is
+/// updated as `log(s_i) += rate * (accepted - target)`. The fixed point is an
+/// acceptance rate of `target`: coordinates on which most moves are rejected
+/// take smaller steps, and those on which most are accepted larger ones.
+/// This is a Robbins-Monro style update which costs one multiplication per
+/// move and needs no windows of statistics.
+///
+/// A default-constructed object is disabled and doesn't allocate.
+class visiting_scales_t {
+    std::vector<float>  _scales;
+    std::vector<size_t> _num_accepted; ///< Accepted moves per coordinate
+    float               _grow;   ///< Factor applied after an accepted move
+    float               _shrink; ///< Factor applied after a rejected move
+
+  public:
+    static constexpr auto min_scale = 1e-6f;
+    static constexpr auto max_scale = 1e6f;
+
+    visiting_scales_t() noexcept
+        : _scales{}, _num_accepted{}, _grow{1.0f}, _shrink{1.0f}
+    {}
+
+    /// \brief Enables the scales for \p dim coordinates if \p target is
+    /// positive, and disables them otherwise.
+    ///
+    /// All scales start at `1`.
+    auto init(size_t dim, float target, float rate) -> void;
+
+    /// Number of scales #init creates.
+    [[nodiscard]] static constexpr auto size(size_t const dim,
+                                             float const  target) noexcept
+        -> size_t
+    {
+        return target > 0.0f ? dim : 0;
+    }
+
+    [[nodiscard]] auto enabled() const noexcept -> bool
+    {
+        return !_scales.empty();
+    }
+
+    [[nodiscard]] auto operator[](size_t const i) const noexcept -> float
+    {
+        return _scales[i];
+    }
+
+    /// Multiplies the step \p steps of all coordinates by their scales.
+    auto apply(gsl::span<float> steps) const noexcept -> void;
+
+    /// Accounts for a single-coordinate move of coordinate \p i.
+    auto update(size_t const i, bool const accepted) noexcept -> void
+    {
+        _num_accepted[i] += accepted ? size_t{1} : size_t{0};
+        _scales[i] = std::clamp(_scales[i] * (accepted ? _grow : _shrink),
+                                min_scale, max_scale);
+    }
+
+    [[nodiscard]] auto scales() const noexcept -> gsl::span<float const>
+    {
+        return _scales;
+    }
+
+    /// Returns the number of accepted single-coordinate moves per coordinate.
+    [[nodiscard]] auto num_accepted() const noexcept
+        -> gsl::span<size_t const>
+    {
+        return _num_accepted;
+    }
+
+    /// \brief Continues from \p scales and \p num_accepted which were saved
+    /// from an enabled object with the same parameters.
+    auto restore(gsl::span<float const>  scales,
+                 gsl::span<size_t const> num_accepted) noexcept -> void
+    {
+        DUAL_ANNEALING_ASSERT(scales.size() == _scales.size()
+                                  && num_accepted.size() == _scales.size(),
+                              "incompatible dimensions");
+        std::memcpy(_scales.data(), scales.data(), scales.size_bytes());
+        std::memcpy(_num_accepted.data(), num_accepted.data(),
+                    num_accepted.size_bytes());
+    }
+};
+} // namespace detail
+
+DUAL_ANNEALING_NAMESPACE_END
@@ -0,0 +1,350 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include "assert.hpp"
+#include "config.hpp"
+
+#include <gsl/gsl-lite.hpp>
+#include <lbfgs/lbfgs.hpp>
+
+#include <algorithm> // std::max, std::copy
+#include <cmath>     // std::sqrt
+#include <cstddef>   // size_t
+#include <limits>    // std::numeric_limits
+#include <vector>    // std::vector
+
+DUAL_ANNEALING_NAMESPACE_BEGIN
+
+/// \brief Parameters of local search which reuses curvature information
+/// between calls.
+///
+/// Passing these instead of plain `tcm::lbfgs::lbfgs_param_t` to #minimize
+/// makes #sa_chain_t keep the L-BFGS history of the previous local search and
+/// continue from it. Successive local searches usually start in the same or
+/// a nearby basin, so the old history is a much better initial Hessian
+/// approximation than the identity.
+struct warm_start_param_t {
+    /// Only `m`, `epsilon` and `max_iter` are used.
+    tcm::lbfgs::lbfgs_param_t lbfgs;
+    /// \brief The history is dropped when the new starting point is further
+    /// than this (Euclidean distance) from where the previous local search
+    /// ended.
+    ///
+    /// Curvature measured in a distant basin is more likely to mislead the
+    /// first steps than to help them.
+    float reset_distance = 1.0f;
+    /// Maximal number of backtracking steps in the line search.
+    size_t max_linesearch = 20;
+};
+
+/// \brief Persistent state of a warm-started L-BFGS.
+///
+/// Stores the last `m` pairs `(s, y)` of position and gradient differences
+/// in ring buffers together with the scratch space needed by
+/// #detail::minimize_warm, so repeated local searches don't allocate.
+class lbfgs_history_t {
+    size_t              _m;     ///< Capacity of the history
+    size_t              _dim;   ///< Dimension of the problem
+    size_t              _size;  ///< Number of stored pairs
+    size_t              _first; ///< Index of the oldest pair in the ring
+    std::vector<float>  _s;     ///< Position differences, `_m x _dim`
+    std::vector<float>  _y;     ///< Gradient differences, `_m x _dim`
+    std::vector<double> _rho;   ///< `1 / (y . s)` of every pair
+    std::vector<double> _alpha; ///< Scratch space of the two-loop recursion
+    std::vector<float>  _anchor; ///< Where the previous run ended
+    bool                _has_anchor;
+    std::vector<float>  _scratch; ///< Gradient, direction, trial point, etc.
+
+    static auto dot(gsl::span<float const> a, float const* b) noexcept
+        -> double
+    {
+        auto total = 0.0;
+        for (auto i = size_t{0}; i < a.size(); ++i) {
+            total += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+        }
+        return total;
+    }
+
+    auto slot(size_t const i) const noexcept -> size_t
+    {
+        return (_first + i) % _m;
+    }
+
+  public:
+    lbfgs_history_t() noexcept
+        : _m{0}
+        , _dim{0}
+        , _size{0}
+        , _first{0}
+        , _s{}
+        , _y{}
+        , _rho{}
+        , _alpha{}
+        , _anchor{}
+        , _has_anchor{false}
+        , _scratch{}
+    {}
+
+    /// \brief Prepares the history for `m` pairs of dimension `dim`.
+    ///
+    /// Allocates only on the first call or when the shape changes, in which
+    /// case the history is also cleared.
+    auto reserve(size_t const m, size_t const dim) -> void
+    {
+        DUAL_ANNEALING_ASSERT(m > 0, "history must not be empty");
+        if (m == _m && dim == _dim) { return; }
+        _m   = m;
+        _dim = dim;
+        _s.resize(m * dim);
+        _y.resize(m * dim);
+        _rho.resize(m);
+        _alpha.resize(m);
+        _anchor.resize(dim);
+        _scratch.resize(4 * dim);
+        clear();
+    }
+
+    /// Forgets all pairs (but keeps the memory).
+    auto clear() noexcept -> void
+    {
+        _size       = 0;
+        _first      = 0;
+        _has_anchor = false;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> size_t { return _size; }
+    [[nodiscard]] auto dim() const noexcept -> size_t { return _dim; }
+
+    /// \brief Scratch buffer number \p i (`i < 4`) of size #dim().
+    [[nodiscard]] auto scratch(size_t const i) noexcept -> gsl::span<float>
+    {
+        return {_scratch.data() + i * _dim, _dim};
+    }
+
+    /// \brief Records a step from \p x_old to \p x_new.
+    ///
+    /// Pairs violating the curvature condition `s . y > 0` are skipped since
+    /// they would make the Hessian approximation indefinite. Returns whether
+    /// the pair was stored. Skipped pairs leave the history untouched.
+    auto push(gsl::span<float const> x_old, gsl::span<float const> x_new,
+              gsl::span<float const> g_old, gsl::span<float const> g_new)
+        -> bool
+    {
+        auto ys = 0.0;
+        auto ss = 0.0;
+        auto xx = 0.0;
+        for (auto k = size_t{0}; k < _dim; ++k) {
+            auto const s_k = static_cast<double>(x_new[k] - x_old[k]);
+            auto const y_k = static_cast<double>(g_new[k] - g_old[k]);
+            ys += s_k * y_k;
+            ss += s_k * s_k;
+            xx += static_cast<double>(x_new[k]) * static_cast<double>(x_new[k]);
+        }
+        // Steps close to the resolution of `float` (the last few steps of a
+        // converged run) give mostly rounding noise. Such pairs would poison
+        // the history of the next run, so we don't store them.
+        constexpr auto min_relative_step = 1e-5;
+        if (!(ys > 0.0)
+            || ss < min_relative_step * min_relative_step * std::max(1.0, xx)) {
+            return false;
+        }
+        // When the history is full, the new pair replaces the oldest one
+        auto const i = _size < _m ? slot(_size) : _first;
+        auto*      s = _s.data() + i * _dim;
+        auto*      y = _y.data() + i * _dim;
+        for (auto k = size_t{0}; k < _dim; ++k) {
+            s[k] = x_new[k] - x_old[k];
+            y[k] = g_new[k] - g_old[k];
+        }
+        _rho[i] = 1.0 / ys;
+        if (_size < _m) { ++_size; }
+        else {
+            _first = (_first + 1) % _m;
+        }
+        return true;
+    }
+
+    /// \brief Computes the search direction `d = -H g` using the two-loop
+    /// recursion.
+    ///
+    /// With an empty history this is just the steepest descent direction.
+    auto direction(gsl::span<float const> g, gsl::span<float> d) -> void
+    {
+        for (auto k = size_t{0}; k < _dim; ++k) {
+            d[k] = -g[k];
+        }
+        if (_size == 0) { return; }
+        auto const q = gsl::span<float const>{d.data(), d.size()};
+        for (auto j = _size; j-- > 0;) {
+            auto const i = slot(j);
+            auto const* s = _s.data() + i * _dim;
+            auto const* y = _y.data() + i * _dim;
+            _alpha[i]     = _rho[i] * dot(q, s);
+            auto const a  = static_cast<float>(_alpha[i]);
+            for (auto k = size_t{0}; k < _dim; ++k) {
+                d[k] -= a * y[k];
+            }
+        }
+        {
+            // Scale by `s . y / y . y` of the newest pair, which is the usual
+            // estimate of the inverse Hessian along the last step.
+            auto const  i     = slot(_size - 1);
+            auto const* y     = _y.data() + i * _dim;
+            auto const  yy    = dot({y, _dim}, y);
+            auto const  gamma = static_cast<float>(1.0 / (_rho[i] * yy));
+            for (auto k = size_t{0}; k < _dim; ++k) {
+                d[k] *= gamma;
+            }
+        }
+        for (auto j = size_t{0}; j < _size; ++j) {
+            auto const  i    = slot(j);
+            auto const* s    = _s.data() + i * _dim;
+            auto const* y    = _y.data() + i * _dim;
+            auto const  beta = _rho[i] * dot(q, y);
+            auto const  c    = static_cast<float>(_alpha[i] - beta);
+            for (auto k = size_t{0}; k < _dim; ++k) {
+                d[k] += c * s[k];
+            }
+        }
+    }
+
+    /// Whether \p x is within \p radius of where the previous run ended.
+    [[nodiscard]] auto is_near(gsl::span<float const> x,
+                               float const radius) const noexcept -> bool
+    {
+        if (!_has_anchor) { return false; }
+        auto total = 0.0;
+        for (auto k = size_t{0}; k < _dim; ++k) {
+            auto const d = static_cast<double>(x[k] - _anchor[k]);
+            total += d * d;
+        }
+        return total <= static_cast<double>(radius) * radius;
+    }
+
+    /// Remembers \p x as the end point of the current run.
+    auto set_anchor(gsl::span<float const> x) -> void
+    {
+        std::copy(x.begin(), x.end(), _anchor.begin());
+        _has_anchor = true;
+    }
+};
+
+namespace detail {
+/// Same as `tcm::lbfgs::result_t`, but owned by this library.
+struct local_search_result_t {
+    tcm::lbfgs::status_t status;
+    double               func;
+    size_t               num_iter;
+};
+
+/// \brief L-BFGS with a backtracking (Armijo) line search which starts from
+/// and updates \p history.
+///
+/// \p value_and_gradient has the same signature as for `tcm::lbfgs::minimize`.
+/// Upon return \p x contains the final point.
+template <class Function>
+auto minimize_warm(Function&& value_and_gradient,
+                   warm_start_param_t const& params, lbfgs_history_t& history,
+                   gsl::span<float> x) -> local_search_result_t
+{
+    constexpr auto c_1    = 1e-4; // Sufficient decrease constant
+    auto const     dim    = x.size();
+    auto const     m      = std::max<size_t>(params.lbfgs.m, 1);
+    auto const     epsilon = static_cast<double>(params.lbfgs.epsilon);
+    history.reserve(m, dim);
+    if (!history.is_near(x, params.reset_distance)) { history.clear(); }
+
+    auto g     = history.scratch(0);
+    auto d     = history.scratch(1);
+    auto x_new = history.scratch(2);
+    auto g_new = history.scratch(3);
+    auto const norm = [](gsl::span<float const> v) {
+        auto total = 0.0;
+        for (auto const a : v) {
+            total += static_cast<double>(a) * static_cast<double>(a);
+        }
+        return std::sqrt(total);
+    };
+    auto const finish = [&history, x](tcm::lbfgs::status_t const status,
+                                      double const func, size_t const iter) {
+        history.set_anchor(x);
+        return local_search_result_t{status, func, iter};
+    };
+
+    auto func = static_cast<double>(value_and_gradient(
+        gsl::span<float const>{x.data(), dim}, g));
+    for (auto iter = size_t{0};
+         params.lbfgs.max_iter == 0 || iter < params.lbfgs.max_iter; ++iter) {
+        auto const g_norm = norm(g);
+        if (g_norm <= epsilon * std::max(1.0, norm(x))) {
+            return finish(tcm::lbfgs::status_t::success, func, iter);
+        }
+        history.direction(g, d);
+        auto dg = 0.0;
+        for (auto k = size_t{0}; k < dim; ++k) {
+            dg += static_cast<double>(d[k]) * static_cast<double>(g[k]);
+        }
+        if (!(dg < 0.0)) {
+            // Stale curvature which doesn't even give a descent direction:
+            // start over with steepest descent.
+            history.clear();
+            history.direction(g, d);
+            dg = -g_norm * g_norm;
+        }
+        // Without curvature information the length of `d` is meaningless, so
+        // the first trial step is normalised.
+        auto step = history.size() == 0 ? 1.0 / g_norm : 1.0;
+        auto func_new = std::numeric_limits<double>::quiet_NaN();
+        auto found    = false;
+        for (auto k = size_t{0}; k < params.max_linesearch; ++k, step *= 0.5) {
+            for (auto i = size_t{0}; i < dim; ++i) {
+                x_new[i] = x[i] + static_cast<float>(step) * d[i];
+            }
+            func_new = static_cast<double>(value_and_gradient(
+                gsl::span<float const>{x_new.data(), dim}, g_new));
+            if (func_new <= func + c_1 * step * dg) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return finish(tcm::lbfgs::status_t::minimum_step_reached, func,
+                          iter);
+        }
+        history.push(x, x_new, g, g_new);
+        std::copy(x_new.begin(), x_new.end(), x.begin());
+        std::copy(g_new.begin(), g_new.end(), g.begin());
+        func = func_new;
+    }
+    return finish(tcm::lbfgs::status_t::too_many_iterations, func,
+                  params.lbfgs.max_iter);
+}
+} // namespace detail
+
+DUAL_ANNEALING_NAMESPACE_END
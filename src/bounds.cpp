@@ -0,0 +1,184 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "bounds.hpp"
+#include "simd.hpp"
+
+#include <stdexcept> // std::invalid_argument
+
+DA_NAMESPACE_BEGIN
+
+namespace detail {
+namespace {
+#if defined(__GNUC__)
+// Vector versions of the helpers from bounds.hpp. They perform the same
+// operations, but results may differ in the last bits when the compiler
+// contracts them into FMAs for some targets and not for others.
+DA_FORCEINLINE auto floor_small(vfloat const& t) noexcept -> vfloat
+{
+    auto const i = __builtin_convertvector(__builtin_convertvector(t, vint),
+                                           vfloat);
+    vint const too_big = i > t;
+    return i + __builtin_convertvector(too_big, vfloat);
+}
+
+DA_FORCEINLINE auto clamp_small(vfloat const& t) noexcept -> vfloat
+{
+    constexpr auto big = 8388608.0f; // 2^23
+    vfloat const   lo  = vfloat{} - big;
+    vfloat const   hi  = vfloat{} + big;
+    auto const     y   = select(t > -big, t, lo);
+    return select(y > big, hi, y);
+}
+
+DA_FORCEINLINE auto wrap_periodic(vfloat const& x, vfloat const& lower,
+                                  vfloat const& upper, vfloat const& length,
+                                  vfloat const& inv_length) noexcept -> vfloat
+{
+    auto const t = clamp_small((x - lower) * inv_length);
+    auto const y = lower + (t - floor_small(t)) * length;
+    return select(y < upper, y, lower);
+}
+
+DA_FORCEINLINE auto wrap_reflecting(vfloat const& x, vfloat const& lower,
+                                    vfloat const& upper, vfloat const& length,
+                                    vfloat const& inv_length) noexcept
+    -> vfloat
+{
+    auto const t = clamp_small((x - lower) * inv_length);
+    auto const u = t - 2.0f * floor_small(0.5f * t);
+    // |1 - u| by clearing the sign bit
+    auto const d = bit_cast<vfloat>(bit_cast<vint>(1.0f - u) & 0x7fffffff);
+    auto const y = lower + (1.0f - d) * length;
+    auto const z = select(y < lower, lower, y);
+    return select(z > upper, upper, z);
+}
+#endif
+
+template <bool Periodic>
+DA_FORCEINLINE auto wrap_all(float* DUAL_ANNEALING_RESTRICT x,
+                             float const* DUAL_ANNEALING_RESTRICT lower,
+                             float const* DUAL_ANNEALING_RESTRICT upper,
+                             float const* DUAL_ANNEALING_RESTRICT length,
+                             float const* DUAL_ANNEALING_RESTRICT inv_length,
+                             size_t const n) noexcept -> void
+{
+    auto i = size_t{0};
+#if defined(__GNUC__)
+    for (; i + lanes <= n; i += lanes) {
+        auto const v = load(x + i);
+        auto const l = load(lower + i);
+        auto const u = load(upper + i);
+        auto const d = load(length + i);
+        auto const r = load(inv_length + i);
+        store(x + i, Periodic ? wrap_periodic(v, l, u, d, r)
+                              : wrap_reflecting(v, l, u, d, r));
+    }
+#endif
+    for (; i < n; ++i) {
+        if constexpr (Periodic) {
+            x[i] = detail::wrap_periodic(x[i], lower[i], upper[i],
+                                         length[i], inv_length[i]);
+        }
+        else {
+            x[i] = detail::wrap_reflecting(x[i], lower[i], upper[i],
+                                           length[i], inv_length[i]);
+        }
+    }
+}
+} // namespace
+} // namespace detail
+
+DA_EXPORT box_bounds_t::box_bounds_t(gsl::span<float const> lower,
+                                     gsl::span<float const> upper,
+                                     boundary_t const       boundary)
+    : _lower{lower.begin(), lower.end()}
+    , _upper{upper.begin(), upper.end()}
+    , _length{}
+    , _inv_length{}
+    , _boundary{boundary}
+{
+    if (lower.size() != upper.size()) {
+        throw std::invalid_argument{
+            "box_bounds_t: lower and upper have different sizes"};
+    }
+    init();
+}
+
+DA_EXPORT box_bounds_t::box_bounds_t(size_t const dim, float const lower,
+                                     float const      upper,
+                                     boundary_t const boundary)
+    : _lower(dim, lower)
+    , _upper(dim, upper)
+    , _length{}
+    , _inv_length{}
+    , _boundary{boundary}
+{
+    init();
+}
+
+auto box_bounds_t::init() -> void
+{
+    _length.resize(dim());
+    _inv_length.resize(dim());
+    for (auto i = size_t{0}; i < dim(); ++i) {
+        // Also rejects NaNs
+        if (!(_lower[i] < _upper[i])) {
+            throw std::invalid_argument{
+                "box_bounds_t: lower[i] < upper[i] does not hold"};
+        }
+        _length[i]     = _upper[i] - _lower[i];
+        _inv_length[i] = 1.0f / _length[i];
+    }
+}
+
+DA_EXPORT auto box_bounds_t::contains(gsl::span<float const> x) const noexcept
+    -> bool
+{
+    DUAL_ANNEALING_ASSERT(x.size() == dim(), "incompatible dimensions");
+    for (auto i = size_t{0}; i < x.size(); ++i) {
+        if (!(_lower[i] <= x[i] && x[i] <= _upper[i])) { return false; }
+    }
+    return true;
+}
+
+DA_TARGET_CLONES("avx512f", "avx2", "default")
+DA_EXPORT auto box_bounds_t::wrap(gsl::span<float> x) const noexcept -> void
+{
+    DUAL_ANNEALING_ASSERT(x.size() == dim(), "incompatible dimensions");
+    if (_boundary == boundary_t::periodic) {
+        detail::wrap_all<true>(x.data(), _lower.data(), _upper.data(),
+                               _length.data(), _inv_length.data(), x.size());
+    }
+    else {
+        detail::wrap_all<false>(x.data(), _lower.data(), _upper.data(),
+                                _length.data(), _inv_length.data(), x.size());
+    }
+}
+
+DA_NAMESPACE_END
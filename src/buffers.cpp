@@ -2,10 +2,16 @@
 
 #include <gsl/gsl-lite.hpp>
 
-#include <cstring>   // std::memset
+#include <algorithm> // std::max_element
 #include <memory>    // std::unique_ptr, std::aligned_alloc, etc.
+#include <mutex>     // std::mutex, std::lock_guard
 #include <optional>  // std::optional
 #include <stdexcept> // std::overflow_error, std::bad_alloc
+#include <vector>    // std::vector
+
+#if defined(__linux__)
+#    include <sys/mman.h> // mmap, munmap, madvise
+#endif
 
 DA_NAMESPACE_BEGIN
 
@@ -13,11 +19,23 @@ namespace detail {
 template <size_t N> struct buffers_base_t {
 
     static constexpr auto cache_line_size = 64UL;
+    /// Allocations of at least this many bytes use transparent huge pages.
+    static constexpr auto huge_page_size = 2UL * 1024UL * 1024UL;
 
   private:
     struct Deleter {
+        /// Length of the mapping if the memory was obtained from `mmap` and
+        /// `0` if it came from `std::aligned_alloc`.
+        size_t mapped = 0;
+
         template <class T> auto operator()(T* p) const noexcept -> void
         {
+#if defined(__linux__)
+            if (mapped != 0) {
+                ::munmap(p, mapped);
+                return;
+            }
+#endif
             // NOLINTNEXTLINE(cppcoreguidelines-owning-memory, cppcoreguidelines-no-malloc, hicpp-no-malloc)
             std::free(p);
         }
@@ -43,6 +61,21 @@ template <size_t N> struct buffers_base_t {
             throw std::overflow_error{
                 "integer overflow in allocate_buffer(size_t)"};
         }
+#if defined(__linux__)
+        if (size * sizeof(float) >= huge_page_size) {
+            // Pages of anonymous mappings are only allocated when first
+            // touched, i.e. on the NUMA node of the thread running the chain.
+            auto const length = align_up<huge_page_size>(size * sizeof(float));
+            auto* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) { throw std::bad_alloc{}; }
+            // Only a hint, so failures are fine
+            static_cast<void>(::madvise(p, length, MADV_HUGEPAGE));
+            // NOLINTNEXTLINE(cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+            return std::unique_ptr<float[], Deleter>{static_cast<float*>(p),
+                                                     Deleter{length}};
+        }
+#endif
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast, cppcoreguidelines-owning-memory)
         auto* p = reinterpret_cast<float*>(
             std::aligned_alloc(cache_line_size, size * sizeof(float)));
@@ -66,9 +99,22 @@ template <size_t N> struct buffers_base_t {
     auto operator=(buffers_base_t const&) -> buffers_base_t& = delete;
     auto operator=(buffers_base_t&&) noexcept -> buffers_base_t& = default;
 
+    /// Number of floats needed to store \p N buffers of size \p size.
+    static constexpr auto required_capacity(size_t const size) noexcept
+        -> size_t
+    {
+        return align_up<cache_line_size>(size) * N;
+    }
+
+    /// \brief Makes all buffers of size \p size.
+    ///
+    /// \note The contents of the buffers are unspecified afterwards. Zeroing
+    /// them here used to cost as much as a whole iteration for small problems
+    /// in large buffers, and for fresh mappings it would fault in all pages
+    /// on the calling thread.
     auto resize(size_t const size) -> void
     {
-        auto const required_capacity = align_up<cache_line_size>(size) * N;
+        auto const required_capacity = this->required_capacity(size);
         if (required_capacity > _capacity) { // Need to reallocate
             using std::swap;
             auto new_data = allocate_buffer(required_capacity);
@@ -77,8 +123,11 @@ template <size_t N> struct buffers_base_t {
         }
 
         _buffer_size = size;
-        // TODO(twesterhout): Profile and check whether we need to optimise this
-        std::memset(_data.get(), 0, _capacity * sizeof(float));
+    }
+
+    [[nodiscard]] constexpr auto capacity() const noexcept -> size_t
+    {
+        return _capacity;
     }
 
     [[nodiscard]] constexpr auto buffer_size() const noexcept -> size_t
@@ -108,6 +157,11 @@ auto sa_buffers_t::impl() noexcept -> impl_t&
     return *reinterpret_cast<impl_t*>(&_storage);
 }
 
+auto sa_buffers_t::impl() const noexcept -> impl_t const&
+{
+    return *reinterpret_cast<impl_t const*>(&_storage);
+}
+
 DA_EXPORT sa_buffers_t::sa_buffers_t() noexcept
 {
     static_assert(sizeof(impl_t) <= sizeof(storage_type));
@@ -122,6 +176,8 @@ DA_EXPORT sa_buffers_t::sa_buffers_t(size_t const size)
     ::new (static_cast<void*>(&_storage)) impl_t{size};
 }
 
+DA_EXPORT sa_buffers_t::~sa_buffers_t() noexcept { impl().~impl_t(); }
+
 DA_EXPORT sa_buffers_t::sa_buffers_t(sa_buffers_t&& other) noexcept
 {
     ::new (static_cast<void*>(&_storage)) impl_t{std::move(other.impl())};
@@ -146,6 +202,146 @@ DA_EXPORT auto sa_buffers_t::workspace() noexcept -> workspace_t
                        point_t{impl().get<2>()}};
 }
 
+DA_EXPORT auto sa_buffers_t::memory_usage() const noexcept -> size_t
+{
+    return impl().capacity() * sizeof(float);
+}
+
+struct workspace_pool_t::impl_t {
+    workspace_pool_param_t    params;
+    std::mutex                mutex;
+    std::vector<sa_buffers_t> idle;
+    size_t                    bytes_in_use = 0;
+    size_t                    bytes_idle   = 0;
+
+    /// Removes idle buffers `i` and returns it. Must be called with #mutex
+    /// held.
+    auto take(size_t const i) noexcept -> sa_buffers_t
+    {
+        auto buffers = std::move(idle[i]);
+        idle[i]      = std::move(idle.back());
+        idle.pop_back();
+        bytes_idle -= buffers.memory_usage();
+        return buffers;
+    }
+};
+
+DA_EXPORT workspace_pool_t::workspace_pool_t(
+    workspace_pool_param_t const& params)
+    : _impl{std::make_unique<impl_t>()}
+{
+    _impl->params = params;
+}
+
+DA_EXPORT workspace_pool_t::~workspace_pool_t() noexcept
+{
+    DUAL_ANNEALING_ASSERT(_impl->bytes_in_use == 0,
+                          "workspace_pool_t destroyed with active leases");
+}
+
+DA_EXPORT auto workspace_pool_t::acquire(size_t const size) -> lease_t
+{
+    using buffers_type = sa_buffers_t::impl_t;
+    auto const required =
+        buffers_type::required_capacity(size) * sizeof(float);
+    // Buffers freed to make room for the new allocation. Destroying them
+    // outside of the lock.
+    std::vector<sa_buffers_t> evicted;
+    {
+        std::lock_guard<std::mutex> lock{_impl->mutex};
+        auto&                       idle = _impl->idle;
+        auto                        best = idle.size();
+        for (auto i = size_t{0}; i < idle.size(); ++i) {
+            auto const bytes = idle[i].memory_usage();
+            if (bytes >= required
+                && (best == idle.size()
+                    || bytes < idle[best].memory_usage())) {
+                best = i;
+            }
+        }
+        if (best != idle.size()) {
+            auto buffers = _impl->take(best);
+            _impl->bytes_in_use += buffers.memory_usage();
+            buffers.resize(size); // Doesn't allocate
+            return lease_t{*this, std::move(buffers)};
+        }
+        auto const max_bytes = _impl->params.max_bytes;
+        // Doesn't fit even if we free all idle buffers
+        if (required > max_bytes
+            || _impl->bytes_in_use > max_bytes - required) {
+            throw std::bad_alloc{};
+        }
+        while (_impl->bytes_in_use + _impl->bytes_idle
+               > max_bytes - required) {
+            auto const largest = static_cast<size_t>(
+                std::max_element(idle.begin(), idle.end(),
+                                 [](auto const& a, auto const& b) {
+                                     return a.memory_usage()
+                                            < b.memory_usage();
+                                 })
+                - idle.begin());
+            evicted.push_back(_impl->take(largest));
+        }
+        // Reserve the memory before allocating outside of the lock
+        _impl->bytes_in_use += required;
+    }
+    evicted.clear();
+    try {
+        return lease_t{*this, sa_buffers_t{size}};
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock{_impl->mutex};
+        _impl->bytes_in_use -= required;
+        throw;
+    }
+}
+
+DA_EXPORT auto workspace_pool_t::release(sa_buffers_t buffers) noexcept
+    -> void
+{
+    auto const bytes = buffers.memory_usage();
+    std::lock_guard<std::mutex> lock{_impl->mutex};
+    _impl->bytes_in_use -= bytes;
+    if (_impl->bytes_idle + bytes > _impl->params.max_idle_bytes) { return; }
+    try {
+        _impl->idle.push_back(std::move(buffers));
+        _impl->bytes_idle += bytes;
+    }
+    catch (std::bad_alloc const&) {
+        // Out of memory: `buffers` are freed instead of being reused
+    }
+}
+
+DA_EXPORT auto workspace_pool_t::trim() noexcept -> void
+{
+    std::vector<sa_buffers_t> idle;
+    {
+        std::lock_guard<std::mutex> lock{_impl->mutex};
+        swap(idle, _impl->idle);
+        _impl->bytes_idle = 0;
+    }
+}
+
+DA_EXPORT auto workspace_pool_t::bytes_in_use() const noexcept -> size_t
+{
+    std::lock_guard<std::mutex> lock{_impl->mutex};
+    return _impl->bytes_in_use;
+}
+
+DA_EXPORT auto workspace_pool_t::bytes_idle() const noexcept -> size_t
+{
+    std::lock_guard<std::mutex> lock{_impl->mutex};
+    return _impl->bytes_idle;
+}
+
+DA_EXPORT auto thread_local_pool() noexcept -> workspace_pool_t&
+{
+    static thread_local workspace_pool_t pool{workspace_pool_param_t{
+        /*max_bytes=*/std::numeric_limits<size_t>::max(),
+        /*max_idle_bytes=*/size_t{16} * 1024 * 1024}};
+    return pool;
+}
+
 DA_EXPORT auto thread_local_workspace(size_t const size) noexcept
     -> std::optional<workspace_t>
 {
@@ -0,0 +1,414 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "dual_annealing.h"
+#include "chain.hpp"
+
+#include <pcg_random.hpp>
+
+#include <new>       // std::bad_alloc
+#include <stdexcept> // std::invalid_argument
+#include <string>    // std::string
+#include <variant>   // std::variant, std::visit
+
+struct da_generator {
+    std::variant<pcg32, pcg64, DA_NAMESPACE::philox4x32_t> generator;
+};
+
+DA_NAMESPACE_BEGIN
+
+namespace {
+/// Message returned by #da_last_error.
+auto last_error() -> std::string&
+{
+    static thread_local std::string message = "no error";
+    return message;
+}
+
+auto fail(da_status_t const status, char const* message) noexcept
+    -> da_status_t
+{
+    try {
+        last_error() = message;
+    }
+    catch (...) {
+    }
+    return status;
+}
+
+/// Converts the exception which is currently being handled.
+auto fail_with_current_exception() noexcept -> da_status_t
+{
+    try {
+        throw;
+    }
+    catch (std::bad_alloc const& e) {
+        return fail(DA_OUT_OF_MEMORY, e.what());
+    }
+    catch (std::invalid_argument const& e) {
+        return fail(DA_INVALID_ARGUMENT, e.what());
+    }
+    catch (std::exception const& e) {
+        return fail(DA_RUNTIME_ERROR, e.what());
+    }
+    catch (...) {
+        return fail(DA_RUNTIME_ERROR, "unknown exception");
+    }
+}
+
+/// \brief Objective which forwards to the callbacks of a #da_objective_t.
+///
+/// Missing callbacks are replaced by the same fallbacks #sa_chain_t would use
+/// for C++ objectives without the corresponding member functions.
+class c_objective_t {
+    da_objective_t const* _obj;
+
+  public:
+    explicit c_objective_t(da_objective_t const& obj) noexcept : _obj{&obj} {}
+
+    auto value(gsl::span<float const> x) const -> double
+    {
+        return (*_obj->value)(_obj->context, x.data(), x.size());
+    }
+
+    auto value_from_diff(
+        std::pair<gsl::span<float const>, double> const current,
+        std::pair<size_t, float> const diff) const -> double
+    {
+        if (_obj->value_from_diff != nullptr) {
+            return (*_obj->value_from_diff)(
+                _obj->context, current.first.data(), current.first.size(),
+                current.second, diff.first, diff.second);
+        }
+        // Same as detail::do_value_from_diff
+        auto*      x    = const_cast<float*>(current.first.data());
+        auto const old  = x[diff.first];
+        auto const undo = gsl::finally([x, i = diff.first, old]() {
+            x[i] = old;
+        });
+        x[diff.first] = diff.second;
+        return value(current.first);
+    }
+
+    auto value_and_gradient(gsl::span<float const> x, gsl::span<float> g)
+        -> double
+    {
+        if (_obj->value_and_gradient != nullptr) {
+            return (*_obj->value_and_gradient)(_obj->context, x.data(),
+                                               g.data(), x.size());
+        }
+        return detail::finite_difference_gradient(*this, x, g,
+                                                  finite_difference_param_t{});
+    }
+
+    [[nodiscard]] auto gradient_cost(size_t const dim) const noexcept
+        -> size_t
+    {
+        return _obj->value_and_gradient != nullptr
+                   ? 1
+                   : detail::finite_difference_cost(
+                       difference_scheme_t::forward, dim);
+    }
+
+    auto value_batch(gsl::span<float const> xs, size_t const n,
+                     gsl::span<double> out) const -> void
+    {
+        auto const dim = xs.size() / n;
+        if (_obj->value_batch != nullptr) {
+            (*_obj->value_batch)(_obj->context, xs.data(), n, dim, out.data());
+            return;
+        }
+        for (auto k = size_t{0}; k < n; ++k) {
+            out[k] = value(xs.subspan(k * dim, dim));
+        }
+    }
+
+    auto wrap(float const x) const -> float
+    {
+        return _obj->wrap != nullptr ? (*_obj->wrap)(_obj->context, x) : x;
+    }
+};
+
+/// #c_objective_t of a #da_objective_t with `lower` and `upper`.
+class c_box_objective_t : public c_objective_t {
+    box_bounds_t _bounds;
+
+  public:
+    c_box_objective_t(da_objective_t const& obj, size_t const dim)
+        : c_objective_t{obj}
+        , _bounds{gsl::span<float const>{obj.lower, dim},
+                  gsl::span<float const>{obj.upper, dim},
+                  obj.boundary == DA_BOUNDARY_REFLECTING
+                      ? boundary_t::reflecting
+                      : boundary_t::periodic}
+    {}
+
+    [[nodiscard]] auto bounds() const noexcept -> box_bounds_t const&
+    {
+        return _bounds;
+    }
+};
+
+/// Forwards to a #da_observer_t, if any.
+struct c_observer_t {
+    da_observer_t const* observer;
+
+    auto operator()(iteration_info_t const& info) const -> observer_action_t
+    {
+        if (observer == nullptr || observer->callback == nullptr) {
+            return observer_action_t::proceed;
+        }
+        auto const c_info = da_iteration_info_t{
+            /*iteration=*/info.iteration,
+            /*current_func=*/info.current_func,
+            /*best_func=*/info.best_func,
+            /*num_f_evals=*/info.num_f_evals,
+            /*acceptance=*/info.acceptance,
+            /*t_V=*/info.t_V};
+        return (*observer->callback)(observer->context, &c_info) != 0
+                   ? observer_action_t::stop
+                   : observer_action_t::proceed;
+    }
+};
+
+auto to_param(da_param_t const& p) noexcept -> param_t
+{
+    auto params               = param_t{p.q_V, p.q_A, p.t_0,
+                          static_cast<size_t>(p.num_iter),
+                          static_cast<size_t>(p.patience)};
+    params.batch_size         = static_cast<size_t>(p.batch_size);
+    params.block_size         = static_cast<size_t>(p.block_size);
+    params.max_restarts       = static_cast<size_t>(p.max_restarts);
+    params.restart_temp_ratio = p.restart_temp_ratio;
+    params.min_acceptance     = p.min_acceptance;
+    params.restart_from       = p.restart_from_random != 0
+                              ? restart_point_t::random
+                              : restart_point_t::best;
+    params.max_f_evals           = static_cast<size_t>(p.max_f_evals);
+    params.target_acceptance     = p.target_acceptance;
+    params.scale_adaptation_rate = p.scale_adaptation_rate;
+    return params;
+}
+
+auto to_lbfgs_param(da_local_search_param_t const& p) noexcept
+    -> tcm::lbfgs::lbfgs_param_t
+{
+    auto params     = tcm::lbfgs::lbfgs_param_t{};
+    params.m        = static_cast<size_t>(p.m);
+    params.epsilon  = p.epsilon;
+    params.max_iter = static_cast<size_t>(p.max_iter);
+    return params;
+}
+
+auto to_result(result_t const& r) noexcept -> da_result_t
+{
+    return da_result_t{/*func=*/r.func,
+                       /*num_iter=*/r.num_iter,
+                       /*num_f_evals=*/r.num_f_evals,
+                       /*acceptance=*/r.acceptance,
+                       /*num_local_search_f_evals=*/r.num_local_search_f_evals,
+                       /*num_restarts=*/r.num_restarts,
+                       /*num_accepted=*/r.num_accepted};
+}
+
+/// \brief The engine proper.
+///
+/// This is the only place which instantiates #minimize_in: once per
+/// objective adapter, generator and whether local search is enabled.
+template <class Objective>
+auto c_minimize(Objective& obj, gsl::span<float> x, param_t const& params,
+              tcm::lbfgs::lbfgs_param_t const* local_search,
+              da_generator_t& generator, workspace_t& workspace,
+              c_observer_t const observer) -> result_t
+{
+    return std::visit(
+        [&](auto& g) {
+            if (local_search != nullptr) {
+                return detail::minimize_in(obj, x, params, *local_search, g,
+                                           workspace,
+                                           detail::ignore_iteration_fn{},
+                                           observer, always_polish_t{});
+            }
+            return detail::minimize_in(obj, x, params, g, workspace,
+                                       detail::ignore_iteration_fn{},
+                                       observer);
+        },
+        generator.generator);
+}
+
+auto c_minimize(da_objective_t const& objective, gsl::span<float> x,
+                da_param_t const&              c_params,
+                da_local_search_param_t const* c_local_search,
+                da_generator_t& generator, float* buffer,
+                da_observer_t const* observer) -> result_t
+{
+    auto const params = to_param(c_params);
+    auto const local_search =
+        c_local_search != nullptr
+            ? std::optional{to_lbfgs_param(*c_local_search)}
+            : std::nullopt;
+    auto const* local_search_ptr =
+        local_search.has_value() ? &*local_search : nullptr;
+
+    auto const run = [&](workspace_t& workspace) {
+        if (objective.lower != nullptr) {
+            auto obj = c_box_objective_t{objective, x.size()};
+            return c_minimize(obj, x, params, local_search_ptr, generator,
+                              workspace, c_observer_t{observer});
+        }
+        auto obj = c_objective_t{objective};
+        return c_minimize(obj, x, params, local_search_ptr, generator,
+                          workspace, c_observer_t{observer});
+    };
+    if (buffer != nullptr) {
+        using point_t  = workspace_t::point_t;
+        auto const dim = x.size();
+        auto workspace =
+            workspace_t{point_t{gsl::span<float>{buffer, dim}},
+                        point_t{gsl::span<float>{buffer + dim, dim}},
+                        point_t{gsl::span<float>{buffer + 2 * dim, dim}}};
+        return run(workspace);
+    }
+    auto lease     = thread_local_pool().acquire(x.size());
+    auto workspace = lease.workspace();
+    return run(workspace);
+}
+} // namespace
+
+DA_NAMESPACE_END
+
+extern "C" {
+
+DA_EXPORT auto da_abi_version() -> int { return DA_ABI_VERSION; }
+
+DA_EXPORT auto da_last_error() -> char const*
+{
+    return DA_NAMESPACE::last_error().c_str();
+}
+
+DA_EXPORT auto da_param_init(da_param_t* const params) -> void
+{
+    if (params == nullptr) { return; }
+    *params = da_param_t{/*q_V=*/2.62f,
+                         /*q_A=*/-5.0f,
+                         /*t_0=*/5230.0f,
+                         /*num_iter=*/1000,
+                         /*patience=*/1000,
+                         /*batch_size=*/0,
+                         /*block_size=*/0,
+                         /*max_restarts=*/0,
+                         /*restart_temp_ratio=*/0.0f,
+                         /*min_acceptance=*/0.0f,
+                         /*restart_from_random=*/0,
+                         /*max_f_evals=*/0,
+                         /*target_acceptance=*/0.0f,
+                         /*scale_adaptation_rate=*/0.1f};
+}
+
+DA_EXPORT auto da_local_search_param_init(da_local_search_param_t* const params)
+    -> void
+{
+    if (params == nullptr) { return; }
+    auto const defaults = tcm::lbfgs::lbfgs_param_t{};
+    *params             = da_local_search_param_t{
+        /*m=*/defaults.m, /*epsilon=*/defaults.epsilon,
+        /*max_iter=*/defaults.max_iter};
+}
+
+DA_EXPORT auto da_generator_create(da_generator_kind_t const kind,
+                                   uint64_t const seed, uint64_t const stream)
+    -> da_generator_t*
+{
+    using DA_NAMESPACE::fail;
+    try {
+        switch (kind) {
+        case DA_GENERATOR_PCG32:
+            return new da_generator_t{pcg32{seed, stream}};
+        case DA_GENERATOR_PCG64:
+            return new da_generator_t{pcg64{seed, stream}};
+        case DA_GENERATOR_PHILOX:
+            return new da_generator_t{
+                DA_NAMESPACE::philox4x32_t{seed, stream}};
+        default:
+            fail(DA_INVALID_ARGUMENT, "unknown generator kind");
+            return nullptr;
+        } // end switch
+    }
+    catch (...) {
+        DA_NAMESPACE::fail_with_current_exception();
+        return nullptr;
+    }
+}
+
+DA_EXPORT auto da_generator_destroy(da_generator_t* const generator) -> void
+{
+    delete generator;
+}
+
+DA_EXPORT auto da_workspace_size(size_t const dim) -> size_t
+{
+    return 3 * dim;
+}
+
+DA_EXPORT auto da_minimize(da_objective_t const* const objective,
+                           float* const x, size_t const dim,
+                           da_param_t const* const              params,
+                           da_local_search_param_t const* const local_search,
+                           da_generator_t* const                generator,
+                           da_observer_t const* const           observer,
+                           float* const workspace, da_result_t* const result)
+    -> da_status_t
+{
+    using DA_NAMESPACE::fail;
+    if (objective == nullptr || objective->value == nullptr) {
+        return fail(DA_INVALID_ARGUMENT, "objective->value is NULL");
+    }
+    if ((objective->lower == nullptr) != (objective->upper == nullptr)) {
+        return fail(DA_INVALID_ARGUMENT,
+                    "objective->lower and objective->upper must either both "
+                    "be set or both be NULL");
+    }
+    if (x == nullptr || dim == 0) {
+        return fail(DA_INVALID_ARGUMENT, "x must be a non-empty array");
+    }
+    if (params == nullptr || generator == nullptr) {
+        return fail(DA_INVALID_ARGUMENT, "params and generator are required");
+    }
+    try {
+        auto const r = DA_NAMESPACE::c_minimize(*objective, {x, dim}, *params,
+                                                local_search, *generator,
+                                                workspace, observer);
+        if (result != nullptr) { *result = DA_NAMESPACE::to_result(r); }
+        return DA_SUCCESS;
+    }
+    catch (...) {
+        return DA_NAMESPACE::fail_with_current_exception();
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,441 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "checkpoint.hpp"
+
+#include <algorithm>    // std::max
+#include <cerrno>       // errno
+#include <cstddef>      // offsetof
+#include <cstring>      // std::memcpy, std::memcmp
+#include <memory>       // std::make_unique
+#include <stdexcept>    // std::runtime_error, std::invalid_argument
+#include <system_error> // std::system_error
+#include <utility>      // std::move
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>    // open
+#    include <sys/mman.h> // mmap, munmap, msync
+#    include <sys/stat.h> // fstat
+#    include <unistd.h>   // close, ftruncate
+#    define DA_HAS_MMAP 1
+#else
+#    define DA_HAS_MMAP 0
+#endif
+
+DA_NAMESPACE_BEGIN
+
+namespace {
+constexpr char magic[8]  = {'D', 'A', 'C', 'K', 'P', 'T', '\0', '\0'};
+constexpr auto version   = std::uint32_t{2};
+constexpr auto page_size = size_t{4096};
+constexpr auto num_slots = size_t{2};
+
+/// First page of the file.
+struct header_t {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t header_size; ///< `sizeof(header_t)`
+    std::uint64_t dim;
+    std::uint64_t generator_size;
+    std::uint64_t slot_size; ///< Bytes per slot, a multiple of #page_size
+    float         q_V;
+    float         q_A;
+    float         t_0;
+    /// `1` if slots hold adaptive visiting scales, `0` otherwise.
+    std::uint32_t has_scales;
+};
+
+/// Beginning of every slot. It is followed by `current.x`, `best.x`, the
+/// visiting scales (if any), the per-coordinate acceptance counts (if any),
+/// and the generator.
+struct record_t {
+    /// Number of the save which produced this slot. `0` means empty.
+    std::uint64_t      sequence;
+    std::uint64_t      checksum; ///< Of everything in the slot except itself
+    checkpoint_state_t state;
+};
+
+static_assert(sizeof(header_t) <= page_size);
+static_assert(sizeof(record_t) % sizeof(float) == 0);
+
+constexpr auto align_up(size_t const value, size_t const alignment) noexcept
+    -> size_t
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/// Number of floats following the record: `current.x`, `best.x`, and the
+/// scales.
+auto num_floats(header_t const& header) noexcept -> size_t
+{
+    return (2 + header.has_scales) * header.dim;
+}
+
+/// Bytes of a slot which are actually used.
+auto slot_used(header_t const& header) noexcept -> size_t
+{
+    return sizeof(record_t) + num_floats(header) * sizeof(float)
+           + header.has_scales * header.dim * sizeof(std::uint64_t)
+           + header.generator_size;
+}
+
+auto make_header(checkpoint_layout_t const& layout) -> header_t
+{
+    if (layout.num_scales != 0 && layout.num_scales != layout.dim) {
+        throw std::invalid_argument{
+            "checkpoint_t: num_scales must be either 0 or dim"};
+    }
+    header_t header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version        = version;
+    header.header_size    = sizeof(header_t);
+    header.dim            = layout.dim;
+    header.generator_size = layout.generator_size;
+    header.q_V            = layout.q_V;
+    header.q_A            = layout.q_A;
+    header.t_0            = layout.t_0;
+    header.has_scales     = layout.num_scales != 0 ? 1 : 0;
+    header.slot_size      = align_up(slot_used(header), page_size);
+    return header;
+}
+
+/// \brief 64-bit FNV-1a over whole words.
+///
+/// The tail which doesn't fill a word is zero-padded.
+auto checksum(std::byte const* data, size_t const size) noexcept
+    -> std::uint64_t
+{
+    constexpr auto prime = std::uint64_t{0x100000001b3};
+    auto           hash  = std::uint64_t{0xcbf29ce484222325};
+    auto           i     = size_t{0};
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word; // NOLINT(cppcoreguidelines-init-variables)
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    if (i != size) {
+        auto word = std::uint64_t{0};
+        std::memcpy(&word, data + i, size - i);
+        hash = (hash ^ word) * prime;
+    }
+    return hash;
+}
+
+[[noreturn]] auto throw_errno(char const* what) -> void
+{
+    throw std::system_error{errno, std::generic_category(), what};
+}
+} // namespace
+
+struct checkpoint_t::impl_t {
+    int        fd;
+    std::byte* data;
+    size_t     size;
+    header_t   header;
+    /// Slot of the newest valid state, or #num_slots if there is none.
+    size_t        newest;
+    std::uint64_t sequence; ///< Sequence number of the newest state
+    size_t        num_saved;
+    bool          resumed; ///< Whether the file held a state when opened
+
+    impl_t() noexcept
+        : fd{-1}
+        , data{nullptr}
+        , size{0}
+        , header{}
+        , newest{num_slots}
+        , sequence{0}
+        , num_saved{0}
+        , resumed{false}
+    {}
+
+    impl_t(impl_t const&) = delete;
+    impl_t(impl_t&&)      = delete;
+    auto operator=(impl_t const&) -> impl_t& = delete;
+    auto operator=(impl_t&&) -> impl_t& = delete;
+
+    ~impl_t() noexcept { unmap(); }
+
+    [[nodiscard]] auto slot(size_t const i) const noexcept -> std::byte*
+    {
+        return data + page_size + i * header.slot_size;
+    }
+
+    [[nodiscard]] auto slot_checksum(size_t const i) const noexcept
+        -> std::uint64_t
+    {
+        auto const* p    = slot(i);
+        auto const  used = slot_used(header);
+        // Skip the checksum itself, but include the sequence number
+        auto const skip = offsetof(record_t, checksum) + sizeof(std::uint64_t);
+        auto       hash = checksum(p, offsetof(record_t, checksum));
+        return hash ^ checksum(p + skip, used - skip);
+    }
+
+    [[nodiscard]] auto record(size_t const i) const noexcept -> record_t*
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return reinterpret_cast<record_t*>(slot(i));
+    }
+
+    [[nodiscard]] auto floats(size_t const i) const noexcept -> float*
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+        return reinterpret_cast<float*>(slot(i) + sizeof(record_t));
+    }
+
+    /// Per-coordinate acceptance counts, not necessarily aligned.
+    [[nodiscard]] auto counts(size_t const i) const noexcept -> std::byte*
+    {
+        return slot(i) + sizeof(record_t) + num_floats(header) * sizeof(float);
+    }
+
+    [[nodiscard]] auto generator(size_t const i) const noexcept -> std::byte*
+    {
+        return counts(i)
+               + header.has_scales * header.dim * sizeof(std::uint64_t);
+    }
+
+    [[nodiscard]] auto num_scales() const noexcept -> size_t
+    {
+        return header.has_scales * header.dim;
+    }
+
+    /// Finds the newest slot with a valid checksum.
+    auto scan() noexcept -> void
+    {
+        newest   = num_slots;
+        sequence = 0;
+        for (auto i = size_t{0}; i < num_slots; ++i) {
+            auto const seq = record(i)->sequence;
+            if (seq != 0 && seq > sequence
+                && record(i)->checksum == slot_checksum(i)) {
+                newest   = i;
+                sequence = seq;
+            }
+        }
+    }
+
+    auto unmap() noexcept -> void
+    {
+#if DA_HAS_MMAP
+        if (data != nullptr) {
+            ::munmap(data, size);
+            data = nullptr;
+        }
+        if (fd != -1) {
+            ::close(fd);
+            fd = -1;
+        }
+#endif
+    }
+};
+
+DA_EXPORT checkpoint_t::checkpoint_t(std::string path, size_t const interval)
+    : _path{std::move(path)}, _interval{std::max<size_t>(interval, 1)}, _impl{}
+{}
+
+DA_EXPORT checkpoint_t::~checkpoint_t() noexcept = default;
+DA_EXPORT checkpoint_t::checkpoint_t(checkpoint_t&&) noexcept = default;
+DA_EXPORT auto checkpoint_t::operator=(checkpoint_t&&) noexcept
+    -> checkpoint_t& = default;
+
+DA_EXPORT auto checkpoint_t::path() const noexcept -> std::string const&
+{
+    return _path;
+}
+
+DA_EXPORT auto checkpoint_t::interval() const noexcept -> size_t
+{
+    return _interval;
+}
+
+DA_EXPORT auto checkpoint_t::num_saved() const noexcept -> size_t
+{
+    return _impl != nullptr ? _impl->num_saved : 0;
+}
+
+DA_EXPORT auto checkpoint_t::resumed() const noexcept -> bool
+{
+    return _impl != nullptr && _impl->resumed;
+}
+
+DA_EXPORT auto checkpoint_t::open(checkpoint_layout_t const& layout) -> bool
+{
+#if DA_HAS_MMAP
+    auto impl       = std::make_unique<impl_t>();
+    impl->header    = make_header(layout);
+    auto const size = page_size + num_slots * impl->header.slot_size;
+
+    impl->fd = ::open(_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (impl->fd == -1) { throw_errno("checkpoint_t: open failed"); }
+    struct stat info {};
+    if (::fstat(impl->fd, &info) != 0) {
+        throw_errno("checkpoint_t: fstat failed");
+    }
+
+    auto const fresh = info.st_size == 0;
+    if (!fresh) {
+        header_t existing{};
+        if (static_cast<size_t>(info.st_size) < sizeof(existing)
+            || ::pread(impl->fd, &existing, sizeof(existing), 0)
+                   != static_cast<ssize_t>(sizeof(existing))
+            || std::memcmp(existing.magic, magic, sizeof(magic)) != 0) {
+            throw std::runtime_error{"checkpoint_t: '" + _path
+                                     + "' is not a checkpoint file"};
+        }
+        if (existing.version != version) {
+            throw std::runtime_error{"checkpoint_t: unsupported version of '"
+                                     + _path + "'"};
+        }
+        if (std::memcmp(&existing, &impl->header, sizeof(existing)) != 0) {
+            throw std::runtime_error{"checkpoint_t: '" + _path
+                                     + "' belongs to a different problem"};
+        }
+    }
+    if (static_cast<size_t>(info.st_size) != size
+        && ::ftruncate(impl->fd, static_cast<off_t>(size)) != 0) {
+        throw_errno("checkpoint_t: ftruncate failed");
+    }
+
+    auto* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     impl->fd, 0);
+    if (p == MAP_FAILED) { throw_errno("checkpoint_t: mmap failed"); }
+    impl->data = static_cast<std::byte*>(p);
+    impl->size = size;
+    if (fresh) {
+        std::memcpy(impl->data, &impl->header, sizeof(header_t));
+        if (::msync(impl->data, page_size, MS_SYNC) != 0) {
+            throw_errno("checkpoint_t: msync failed");
+        }
+    }
+    impl->scan();
+    impl->resumed = impl->newest != num_slots;
+    _impl         = std::move(impl);
+    return _impl->resumed;
+#else
+    static_cast<void>(layout);
+    throw std::runtime_error{
+        "checkpoint_t: not supported on this platform"};
+#endif
+}
+
+DA_EXPORT auto checkpoint_t::load(checkpoint_state_t&  state,
+                                  gsl::span<float>     current,
+                                  gsl::span<float>     best,
+                                  gsl::span<std::byte> generator,
+                                  gsl::span<float>     scales,
+                                  gsl::span<size_t>    scale_num_accepted) const
+    -> void
+{
+    if (_impl == nullptr || _impl->newest == num_slots) {
+        throw std::invalid_argument{"checkpoint_t: no state to load"};
+    }
+    auto const& header = _impl->header;
+    if (current.size() != header.dim || best.size() != header.dim
+        || generator.size() != header.generator_size) {
+        throw std::invalid_argument{"checkpoint_t: incompatible dimensions"};
+    }
+    if (scales.size() != _impl->num_scales()
+        || scale_num_accepted.size() != _impl->num_scales()) {
+        throw std::invalid_argument{"checkpoint_t: incompatible scales"};
+    }
+    auto const i = _impl->newest;
+    state        = _impl->record(i)->state;
+    std::memcpy(current.data(), _impl->floats(i), current.size_bytes());
+    std::memcpy(best.data(), _impl->floats(i) + header.dim, best.size_bytes());
+    std::memcpy(scales.data(), _impl->floats(i) + 2 * header.dim,
+                scales.size_bytes());
+    for (auto j = size_t{0}; j < scale_num_accepted.size(); ++j) {
+        auto count = std::uint64_t{0};
+        std::memcpy(&count, _impl->counts(i) + j * sizeof(count),
+                    sizeof(count));
+        scale_num_accepted[j] = static_cast<size_t>(count);
+    }
+    std::memcpy(generator.data(), _impl->generator(i), generator.size_bytes());
+}
+
+DA_EXPORT auto checkpoint_t::save(checkpoint_state_t const&  state,
+                                  gsl::span<float const>     current,
+                                  gsl::span<float const>     best,
+                                  gsl::span<std::byte const> generator,
+                                  gsl::span<float const>     scales,
+                                  gsl::span<size_t const> scale_num_accepted)
+    -> void
+{
+    if (_impl == nullptr) {
+        throw std::invalid_argument{"checkpoint_t: not open"};
+    }
+    auto const& header = _impl->header;
+    if (current.size() != header.dim || best.size() != header.dim
+        || generator.size() != header.generator_size) {
+        throw std::invalid_argument{"checkpoint_t: incompatible dimensions"};
+    }
+    if (scales.size() != _impl->num_scales()
+        || scale_num_accepted.size() != _impl->num_scales()) {
+        throw std::invalid_argument{"checkpoint_t: incompatible scales"};
+    }
+    // Never overwrite the newest state
+    auto const i   = _impl->newest == 0 ? size_t{1} : size_t{0};
+    auto*      rec = _impl->record(i);
+    rec->sequence  = _impl->sequence + 1;
+    rec->state     = state;
+    std::memcpy(_impl->floats(i), current.data(), current.size_bytes());
+    std::memcpy(_impl->floats(i) + header.dim, best.data(), best.size_bytes());
+    std::memcpy(_impl->floats(i) + 2 * header.dim, scales.data(),
+                scales.size_bytes());
+    for (auto j = size_t{0}; j < scale_num_accepted.size(); ++j) {
+        auto const count = static_cast<std::uint64_t>(scale_num_accepted[j]);
+        std::memcpy(_impl->counts(i) + j * sizeof(count), &count,
+                    sizeof(count));
+    }
+    std::memcpy(_impl->generator(i), generator.data(), generator.size_bytes());
+    rec->checksum = _impl->slot_checksum(i);
+#if DA_HAS_MMAP
+    // Only schedules the write-back, the kernel does it in the background
+    if (::msync(_impl->slot(i), header.slot_size, MS_ASYNC) != 0) {
+        throw_errno("checkpoint_t: msync failed");
+    }
+#endif
+    _impl->newest   = i;
+    _impl->sequence = rec->sequence;
+    ++_impl->num_saved;
+}
+
+DA_EXPORT auto checkpoint_t::close() -> void
+{
+    if (_impl == nullptr) { return; }
+#if DA_HAS_MMAP
+    if (::msync(_impl->data, _impl->size, MS_SYNC) != 0) {
+        throw_errno("checkpoint_t: msync failed");
+    }
+#endif
+    _impl.reset();
+}
+
+DA_NAMESPACE_END
@@ -0,0 +1,195 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "evaluation_cache.hpp"
+
+#include <cmath>         // std::round, std::abs
+#include <cstdint>       // int64_t, uint32_t, uint64_t
+#include <cstring>       // std::memcpy
+#include <iterator>      // std::prev
+#include <list>          // std::list
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+DA_NAMESPACE_BEGIN
+
+namespace {
+/// Key of \p x quantised with step \p tolerance.
+auto quantise(float const x, float const tolerance) noexcept -> std::int64_t
+{
+    // Keys of quantised coordinates have magnitudes below 2^62 and those of
+    // raw bit patterns have bit 62 set, so the two never collide
+    constexpr auto limit = 4611686018427387904.0; // 2^62
+    if (tolerance > 0.0f) {
+        auto const q = std::round(static_cast<double>(x)
+                                  / static_cast<double>(tolerance));
+        if (std::abs(q) < limit) { return static_cast<std::int64_t>(q); }
+    }
+    auto bits = std::uint32_t{0};
+    if (x != 0.0f) { std::memcpy(&bits, &x, sizeof(bits)); }
+    return static_cast<std::int64_t>(bits) | (std::int64_t{1} << 62U);
+}
+
+/// 64-bit FNV-1a over the keys of all coordinates.
+auto hash(std::vector<std::int64_t> const& key) noexcept -> std::uint64_t
+{
+    constexpr auto prime = std::uint64_t{0x100000001b3};
+    auto           h     = std::uint64_t{0xcbf29ce484222325};
+    for (auto const k : key) {
+        h = (h ^ static_cast<std::uint64_t>(k)) * prime;
+    }
+    return h;
+}
+} // namespace
+
+struct evaluation_cache_t::impl_t {
+    struct entry_t {
+        std::uint64_t             hash;
+        std::vector<std::int64_t> key;
+        double                    func;
+    };
+    using list_type = std::list<entry_t>;
+
+    list_type entries; ///< Most recently used first
+    /// Entries by hash. Points with equal hashes but different keys are
+    /// simply treated as misses.
+    std::unordered_map<std::uint64_t, list_type::iterator> index;
+    std::vector<std::int64_t> key; ///< Key of the last point looked up
+
+    auto compute_key(gsl::span<float const> x, float const tolerance)
+        -> std::uint64_t
+    {
+        key.resize(x.size());
+        for (auto i = size_t{0}; i < x.size(); ++i) {
+            key[i] = quantise(x[i], tolerance);
+        }
+        return hash(key);
+    }
+};
+
+DA_EXPORT evaluation_cache_t::evaluation_cache_t(
+    evaluation_cache_param_t const& params)
+    : _params{params}, _counters{0, 0}, _impl{std::make_unique<impl_t>()}
+{}
+
+DA_EXPORT evaluation_cache_t::~evaluation_cache_t() noexcept = default;
+
+DA_EXPORT evaluation_cache_t::evaluation_cache_t(
+    evaluation_cache_t const& other)
+    : evaluation_cache_t{other._params}
+{}
+
+DA_EXPORT evaluation_cache_t::evaluation_cache_t(
+    evaluation_cache_t&&) noexcept = default;
+
+DA_EXPORT auto evaluation_cache_t::operator=(evaluation_cache_t const& other)
+    -> evaluation_cache_t&
+{
+    if (this != &other) { *this = evaluation_cache_t{other._params}; }
+    return *this;
+}
+
+DA_EXPORT auto evaluation_cache_t::operator=(evaluation_cache_t&&) noexcept
+    -> evaluation_cache_t& = default;
+
+DA_EXPORT auto evaluation_cache_t::params() const noexcept
+    -> evaluation_cache_param_t const&
+{
+    return _params;
+}
+
+DA_EXPORT auto evaluation_cache_t::size() const noexcept -> size_t
+{
+    return _impl != nullptr ? _impl->entries.size() : 0;
+}
+
+DA_EXPORT auto evaluation_cache_t::counters() const noexcept
+    -> cache_counters_t
+{
+    return _counters;
+}
+
+DA_EXPORT auto evaluation_cache_t::find(gsl::span<float const> x)
+    -> std::optional<double>
+{
+    if (_impl == nullptr) {
+        ++_counters.misses;
+        return std::nullopt;
+    }
+    auto&      impl = *_impl;
+    auto const h    = impl.compute_key(x, _params.tolerance);
+    if (auto const it = impl.index.find(h);
+        it != impl.index.end() && it->second->key == impl.key) {
+        impl.entries.splice(impl.entries.begin(), impl.entries, it->second);
+        ++_counters.hits;
+        return it->second->func;
+    }
+    ++_counters.misses;
+    return std::nullopt;
+}
+
+DA_EXPORT auto evaluation_cache_t::insert(gsl::span<float const> x,
+                                          double const           func) -> void
+{
+    if (_params.capacity == 0) { return; }
+    // Moved-from caches allocate lazily, keeping the moves noexcept
+    if (_impl == nullptr) { _impl = std::make_unique<impl_t>(); }
+    auto&      impl = *_impl;
+    auto const h    = impl.compute_key(x, _params.tolerance);
+    if (auto const it = impl.index.find(h); it != impl.index.end()) {
+        // Either the same point or a hash collision, the newer one wins
+        it->second->key  = impl.key;
+        it->second->func = func;
+        impl.entries.splice(impl.entries.begin(), impl.entries, it->second);
+        return;
+    }
+    if (impl.entries.size() < _params.capacity) {
+        impl.entries.push_front(impl_t::entry_t{h, impl.key, func});
+        impl.index.emplace(h, impl.entries.begin());
+        return;
+    }
+    // Reuses the node of the least recently used entry (and its key's
+    // storage), so a full cache doesn't allocate
+    auto const last = std::prev(impl.entries.end());
+    auto       node = impl.index.extract(last->hash);
+    node.key()      = h;
+    impl.index.insert(std::move(node));
+    last->hash = h;
+    last->key  = impl.key;
+    last->func = func;
+    impl.entries.splice(impl.entries.begin(), impl.entries, last);
+}
+
+DA_EXPORT auto evaluation_cache_t::clear() noexcept -> void
+{
+    if (_impl == nullptr) { return; }
+    _impl->entries.clear();
+    _impl->index.clear();
+}
+
+DA_NAMESPACE_END
@@ -0,0 +1,209 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "instrumentation.hpp"
+
+#include <algorithm> // std::max
+#include <cstdint>   // std::intptr_t
+
+DA_NAMESPACE_BEGIN
+
+namespace {
+constexpr auto global_event_log_capacity = size_t{1} << 16;
+
+/// Atomic version of #chain_counters_t.
+struct global_counters_t {
+    struct phase_t {
+        std::atomic<std::uint64_t> time_ns;
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> num_accepted;
+        std::atomic<std::uint64_t> num_attempted;
+    };
+    std::array<phase_t, num_phases> phases;
+};
+
+auto the_global_counters() noexcept -> global_counters_t&
+{
+    static global_counters_t counters{};
+    return counters;
+}
+
+auto round_up_to_power_of_two(size_t const n) noexcept -> size_t
+{
+    auto result = size_t{1};
+    while (result < n) {
+        result <<= 1U;
+    }
+    return result;
+}
+} // namespace
+
+DA_EXPORT auto global_counters() noexcept -> chain_counters_t
+{
+    auto& counters = the_global_counters();
+    auto  result   = chain_counters_t{};
+    for (auto i = size_t{0}; i < num_phases; ++i) {
+        auto const& from = counters.phases[i];
+        auto&       to   = result.phases[i];
+        to.time_ns       = from.time_ns.load(std::memory_order_relaxed);
+        to.count         = from.count.load(std::memory_order_relaxed);
+        to.num_accepted  = from.num_accepted.load(std::memory_order_relaxed);
+        to.num_attempted = from.num_attempted.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+DA_EXPORT auto reset_global_counters() noexcept -> void
+{
+    for (auto& phase : the_global_counters().phases) {
+        phase.time_ns.store(0, std::memory_order_relaxed);
+        phase.count.store(0, std::memory_order_relaxed);
+        phase.num_accepted.store(0, std::memory_order_relaxed);
+        phase.num_attempted.store(0, std::memory_order_relaxed);
+    }
+}
+
+namespace detail {
+DA_EXPORT auto
+accumulate_global_counters(chain_counters_t const& diff) noexcept -> void
+{
+    auto& counters = the_global_counters();
+    for (auto i = size_t{0}; i < num_phases; ++i) {
+        auto const& from = diff.phases[i];
+        if (from.count == 0) { continue; }
+        auto& to = counters.phases[i];
+        to.time_ns.fetch_add(from.time_ns, std::memory_order_relaxed);
+        to.count.fetch_add(from.count, std::memory_order_relaxed);
+        to.num_accepted.fetch_add(from.num_accepted, std::memory_order_relaxed);
+        to.num_attempted.fetch_add(from.num_attempted,
+                                   std::memory_order_relaxed);
+    }
+}
+
+DA_EXPORT auto next_event_source() noexcept -> std::uint64_t
+{
+    static std::atomic<std::uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace detail
+
+// This is Dmitry Vyukov's bounded MPMC queue. Every slot carries a sequence
+// number which tells producers and consumers whether the slot is free for
+// writing or contains an event ready for reading.
+struct event_log_t::slot_t {
+    std::atomic<size_t> sequence;
+    event_t             event;
+};
+
+DA_EXPORT event_log_t::event_log_t(size_t const capacity)
+    : _slots{}, _mask{}, _head{0}, _tail{0}, _num_dropped{0}
+{
+    auto const size = round_up_to_power_of_two(std::max<size_t>(capacity, 2));
+    _slots.reset(new slot_t[size]);
+    _mask = size - 1;
+    for (auto i = size_t{0}; i < size; ++i) {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+DA_EXPORT event_log_t::~event_log_t() noexcept = default;
+
+DA_EXPORT auto event_log_t::capacity() const noexcept -> size_t
+{
+    return _mask + 1;
+}
+
+DA_EXPORT auto event_log_t::num_dropped() const noexcept
+    -> std::uint64_t
+{
+    return _num_dropped.load(std::memory_order_relaxed);
+}
+
+DA_EXPORT auto event_log_t::try_push(event_t const& event) noexcept -> bool
+{
+    auto position = _head.load(std::memory_order_relaxed);
+    for (;;) {
+        auto&      slot     = _slots[position & _mask];
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+        auto const diff     = static_cast<std::intptr_t>(sequence)
+                          - static_cast<std::intptr_t>(position);
+        if (diff == 0) {
+            if (_head.compare_exchange_weak(position, position + 1,
+                                            std::memory_order_relaxed)) {
+                slot.event = event;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            // The slot still holds an event from the previous round, i.e.
+            // the queue is full.
+            _num_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else {
+            position = _head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+DA_EXPORT auto event_log_t::try_pop(event_t& event) noexcept -> bool
+{
+    auto position = _tail.load(std::memory_order_relaxed);
+    for (;;) {
+        auto&      slot     = _slots[position & _mask];
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+        auto const diff     = static_cast<std::intptr_t>(sequence)
+                          - static_cast<std::intptr_t>(position + 1);
+        if (diff == 0) {
+            if (_tail.compare_exchange_weak(position, position + 1,
+                                            std::memory_order_relaxed)) {
+                event = slot.event;
+                slot.sequence.store(position + _mask + 1,
+                                    std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            // Nothing has been written to this slot yet, i.e. the queue is
+            // empty.
+            return false;
+        }
+        else {
+            position = _tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+DA_EXPORT auto global_event_log() noexcept -> event_log_t&
+{
+    static event_log_t log{global_event_log_capacity};
+    return log;
+}
+
+DA_NAMESPACE_END
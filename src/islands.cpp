@@ -0,0 +1,180 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "islands.hpp"
+
+#include <condition_variable> // std::condition_variable
+#include <cstring>            // std::memcpy
+#include <mutex>              // std::mutex, std::lock_guard, std::unique_lock
+#include <stdexcept>          // std::invalid_argument
+
+DA_NAMESPACE_BEGIN
+
+struct island_hub_t::impl_t {
+    struct message_t {
+        std::vector<float> x;
+        double             func;
+    };
+
+    struct mailbox_t {
+        std::mutex             mutex;
+        std::vector<message_t> messages;
+    };
+
+    /// State of one #reduce_best. Consecutive reductions alternate between
+    /// two of them, so the last island to arrive can reset the next one while
+    /// the others are still reading the current one.
+    struct reduction_t {
+        double             func;
+        std::vector<float> x;
+    };
+
+    size_t                       size;
+    size_t                       dim;
+    std::unique_ptr<mailbox_t[]> mailboxes; // NOLINT(modernize-avoid-c-arrays)
+
+    std::mutex              mutex; ///< Protects the fields below
+    std::condition_variable cv;
+    size_t                  arrived;    ///< Islands in the current reduction
+    size_t                  generation; ///< Number of finished reductions
+    reduction_t             reductions[2]; // NOLINT(modernize-avoid-c-arrays)
+
+    impl_t(size_t const _size, size_t const _dim)
+        : size{_size}
+        , dim{_dim}
+        // NOLINTNEXTLINE(modernize-avoid-c-arrays)
+        , mailboxes{std::make_unique<mailbox_t[]>(_size)}
+        , mutex{}
+        , cv{}
+        , arrived{0}
+        , generation{0}
+        , reductions{{std::numeric_limits<double>::infinity(),
+                      std::vector<float>(_dim)},
+                     {std::numeric_limits<double>::infinity(),
+                      std::vector<float>(_dim)}}
+    {}
+};
+
+DA_EXPORT island_hub_t::island_hub_t(size_t const size, size_t const dim)
+    : _impl{}
+{
+    if (size == 0) {
+        throw std::invalid_argument{"island_hub_t: there must be at least "
+                                    "one island"};
+    }
+    _impl = std::make_unique<impl_t>(size, dim);
+}
+
+DA_EXPORT island_hub_t::~island_hub_t() noexcept = default;
+
+DA_EXPORT auto island_hub_t::size() const noexcept -> size_t
+{
+    return _impl->size;
+}
+
+DA_EXPORT auto island_hub_t::dim() const noexcept -> size_t
+{
+    return _impl->dim;
+}
+
+DA_EXPORT auto island_hub_t::transport(size_t const rank) noexcept
+    -> transport_t
+{
+    DUAL_ANNEALING_ASSERT(rank < size(), "invalid rank");
+    return transport_t{*this, rank};
+}
+
+DA_EXPORT auto island_hub_t::send(size_t const           destination,
+                                  gsl::span<float const> x,
+                                  double const           func) -> void
+{
+    DUAL_ANNEALING_ASSERT(destination < size(), "invalid rank");
+    DUAL_ANNEALING_ASSERT(x.size() == dim(), "incompatible dimensions");
+    // Copy outside of the critical section
+    auto  message = impl_t::message_t{std::vector<float>(x.begin(), x.end()),
+                                     func};
+    auto& mailbox = _impl->mailboxes[destination];
+    std::lock_guard<std::mutex> lock{mailbox.mutex};
+    mailbox.messages.push_back(std::move(message));
+}
+
+DA_EXPORT auto island_hub_t::receive(size_t const rank, gsl::span<float> x)
+    -> std::optional<double>
+{
+    DUAL_ANNEALING_ASSERT(x.size() == dim(), "incompatible dimensions");
+    auto& mailbox = _impl->mailboxes[rank];
+    auto  message = impl_t::message_t{};
+    {
+        std::lock_guard<std::mutex> lock{mailbox.mutex};
+        if (mailbox.messages.empty()) { return std::nullopt; }
+        message = std::move(mailbox.messages.back());
+        mailbox.messages.pop_back();
+    }
+    std::memcpy(x.data(), message.x.data(), x.size() * sizeof(float));
+    return message.func;
+}
+
+DA_EXPORT auto island_hub_t::reduce_best(gsl::span<float> x, double const func)
+    -> double
+{
+    DUAL_ANNEALING_ASSERT(x.size() == dim(), "incompatible dimensions");
+    auto&                        impl = *_impl;
+    std::unique_lock<std::mutex> lock{impl.mutex};
+    auto const generation = impl.generation;
+    auto&      reduction  = impl.reductions[generation % 2];
+    if (func < reduction.func) {
+        reduction.func = func;
+        std::memcpy(reduction.x.data(), x.data(), x.size() * sizeof(float));
+    }
+    if (++impl.arrived == impl.size) {
+        // Everybody who read the other reduction has arrived here since
+        impl.reductions[(generation + 1) % 2].func =
+            std::numeric_limits<double>::infinity();
+        // Islands send before they arrive and nobody has left yet, so
+        // whatever is left in the mailboxes are stale points
+        for (auto r = size_t{0}; r < impl.size; ++r) {
+            std::lock_guard<std::mutex> mailbox_lock{impl.mailboxes[r].mutex};
+            impl.mailboxes[r].messages.clear();
+        }
+        impl.arrived = 0;
+        ++impl.generation;
+        impl.cv.notify_all();
+    }
+    else {
+        impl.cv.wait(lock, [&impl, generation]() {
+            return impl.generation != generation;
+        });
+    }
+    auto const best = reduction.func;
+    if (best < std::numeric_limits<double>::infinity()) {
+        std::memcpy(x.data(), reduction.x.data(), x.size() * sizeof(float));
+    }
+    return best;
+}
+
+DA_NAMESPACE_END
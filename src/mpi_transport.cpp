@@ -0,0 +1,259 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "mpi_transport.hpp"
+
+#include <algorithm> // std::fill
+#include <cmath>     // std::isnan
+#include <cstring>   // std::memcpy
+#include <limits>    // std::numeric_limits
+#include <numeric>   // std::accumulate
+#include <stdexcept> // std::runtime_error, std::invalid_argument
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+DA_NAMESPACE_BEGIN
+
+namespace {
+constexpr auto migration_tag = 0;
+
+auto check(int const code, char const* what) -> void
+{
+    if (code == MPI_SUCCESS) { return; }
+    char buffer[MPI_MAX_ERROR_STRING]; // NOLINT(modernize-avoid-c-arrays)
+    auto length = 0;
+    MPI_Error_string(code, buffer, &length);
+    throw std::runtime_error{std::string{"mpi_transport_t: "} + what + ": "
+                             + std::string{buffer, static_cast<size_t>(
+                                                       length)}};
+}
+} // namespace
+
+struct mpi_transport_t::impl_t {
+    /// A message is the function value followed by the point.
+    struct buffer_t {
+        std::vector<std::byte> bytes;
+        MPI_Request            request;
+    };
+
+    MPI_Comm              comm;
+    int                   rank;
+    int                   size;
+    size_t                dim;
+    buffer_t              incoming; ///< Target of the posted receive
+    std::vector<buffer_t> outgoing; ///< Sends which may still be in flight
+    std::vector<buffer_t> spare;    ///< Buffers of completed sends
+    std::vector<int>      num_sent;     ///< Per destination
+    std::vector<int>      num_received; ///< Per source
+
+    [[nodiscard]] auto message_size() const noexcept -> size_t
+    {
+        return sizeof(double) + dim * sizeof(float);
+    }
+
+    auto post_receive() -> void
+    {
+        check(MPI_Irecv(incoming.bytes.data(),
+                        static_cast<int>(incoming.bytes.size()), MPI_BYTE,
+                        MPI_ANY_SOURCE, migration_tag, comm,
+                        &incoming.request),
+              "MPI_Irecv failed");
+    }
+
+    /// Moves the buffers of completed sends to #spare.
+    auto collect_sends() -> void
+    {
+        for (auto i = outgoing.size(); i-- > 0;) {
+            auto done = 0;
+            check(MPI_Test(&outgoing[i].request, &done, MPI_STATUS_IGNORE),
+                  "MPI_Test failed");
+            if (done != 0) {
+                spare.push_back(std::move(outgoing[i]));
+                outgoing[i] = std::move(outgoing.back());
+                outgoing.pop_back();
+            }
+        }
+    }
+
+    /// Accounts for a completed receive from \p status and posts the next
+    /// one.
+    auto received(MPI_Status const& status) -> void
+    {
+        ++num_received[static_cast<size_t>(status.MPI_SOURCE)];
+        post_receive();
+    }
+};
+
+DA_EXPORT mpi_transport_t::mpi_transport_t(MPI_Comm const comm,
+                                           size_t const   dim)
+    : _impl{std::make_unique<impl_t>()}
+{
+    auto& impl = *_impl;
+    check(MPI_Comm_dup(comm, &impl.comm), "MPI_Comm_dup failed");
+    check(MPI_Comm_rank(impl.comm, &impl.rank), "MPI_Comm_rank failed");
+    check(MPI_Comm_size(impl.comm, &impl.size), "MPI_Comm_size failed");
+    impl.dim = dim;
+    impl.incoming.bytes.resize(impl.message_size());
+    impl.num_sent.assign(static_cast<size_t>(impl.size), 0);
+    impl.num_received.assign(static_cast<size_t>(impl.size), 0);
+    impl.post_receive();
+}
+
+DA_EXPORT mpi_transport_t::~mpi_transport_t() noexcept
+{
+    if (_impl == nullptr) { return; }
+    auto finalized = 0;
+    MPI_Finalized(&finalized);
+    if (finalized != 0) { return; }
+    auto& impl = *_impl;
+    // Only reached with requests in flight if #reduce_best wasn't called
+    MPI_Cancel(&impl.incoming.request);
+    MPI_Wait(&impl.incoming.request, MPI_STATUS_IGNORE);
+    for (auto& buffer : impl.outgoing) {
+        MPI_Cancel(&buffer.request);
+        MPI_Wait(&buffer.request, MPI_STATUS_IGNORE);
+    }
+    MPI_Comm_free(&impl.comm);
+}
+
+DA_EXPORT mpi_transport_t::mpi_transport_t(mpi_transport_t&&) noexcept =
+    default;
+DA_EXPORT auto mpi_transport_t::operator=(mpi_transport_t&&) noexcept
+    -> mpi_transport_t& = default;
+
+DA_EXPORT auto mpi_transport_t::rank() const noexcept -> size_t
+{
+    return static_cast<size_t>(_impl->rank);
+}
+
+DA_EXPORT auto mpi_transport_t::size() const noexcept -> size_t
+{
+    return static_cast<size_t>(_impl->size);
+}
+
+DA_EXPORT auto mpi_transport_t::dim() const noexcept -> size_t
+{
+    return _impl->dim;
+}
+
+DA_EXPORT auto mpi_transport_t::send(size_t const           destination,
+                                     gsl::span<float const> x,
+                                     double const           func) -> void
+{
+    auto& impl = *_impl;
+    if (destination >= size()) {
+        throw std::invalid_argument{"mpi_transport_t: invalid destination"};
+    }
+    if (x.size() != impl.dim) {
+        throw std::invalid_argument{"mpi_transport_t: incompatible dimension"};
+    }
+    impl.collect_sends();
+    auto buffer = impl_t::buffer_t{};
+    if (!impl.spare.empty()) {
+        buffer = std::move(impl.spare.back());
+        impl.spare.pop_back();
+    }
+    buffer.bytes.resize(impl.message_size());
+    std::memcpy(buffer.bytes.data(), &func, sizeof(double));
+    std::memcpy(buffer.bytes.data() + sizeof(double), x.data(),
+                x.size() * sizeof(float));
+    check(MPI_Isend(buffer.bytes.data(), static_cast<int>(buffer.bytes.size()),
+                    MPI_BYTE, static_cast<int>(destination), migration_tag,
+                    impl.comm, &buffer.request),
+          "MPI_Isend failed");
+    impl.outgoing.push_back(std::move(buffer));
+    ++impl.num_sent[destination];
+}
+
+DA_EXPORT auto mpi_transport_t::receive(gsl::span<float> x)
+    -> std::optional<double>
+{
+    auto& impl = *_impl;
+    if (x.size() != impl.dim) {
+        throw std::invalid_argument{"mpi_transport_t: incompatible dimension"};
+    }
+    auto done   = 0;
+    auto status = MPI_Status{};
+    check(MPI_Test(&impl.incoming.request, &done, &status), "MPI_Test failed");
+    if (done == 0) { return std::nullopt; }
+    auto func = 0.0;
+    std::memcpy(&func, impl.incoming.bytes.data(), sizeof(double));
+    std::memcpy(x.data(), impl.incoming.bytes.data() + sizeof(double),
+                x.size() * sizeof(float));
+    impl.received(status);
+    return func;
+}
+
+DA_EXPORT auto mpi_transport_t::reduce_best(gsl::span<float> x,
+                                            double const     func) -> double
+{
+    auto& impl = *_impl;
+    if (x.size() != impl.dim) {
+        throw std::invalid_argument{"mpi_transport_t: incompatible dimension"};
+    }
+    // Drain the points which are still in flight
+    auto expected = std::vector<int>(impl.num_sent.size());
+    check(MPI_Alltoall(impl.num_sent.data(), 1, MPI_INT, expected.data(), 1,
+                       MPI_INT, impl.comm),
+          "MPI_Alltoall failed");
+    auto remaining =
+        std::accumulate(expected.begin(), expected.end(), 0)
+        - std::accumulate(impl.num_received.begin(), impl.num_received.end(),
+                          0);
+    for (; remaining > 0; --remaining) {
+        auto status = MPI_Status{};
+        check(MPI_Wait(&impl.incoming.request, &status), "MPI_Wait failed");
+        impl.received(status);
+    }
+    // All sends have been matched now
+    for (auto& buffer : impl.outgoing) {
+        check(MPI_Wait(&buffer.request, MPI_STATUS_IGNORE), "MPI_Wait failed");
+        impl.spare.push_back(std::move(buffer));
+    }
+    impl.outgoing.clear();
+    std::fill(impl.num_sent.begin(), impl.num_sent.end(), 0);
+    std::fill(impl.num_received.begin(), impl.num_received.end(), 0);
+
+    struct {
+        double func;
+        int    rank;
+    } local{std::isnan(func) ? std::numeric_limits<double>::infinity() : func,
+            impl.rank},
+        global{};
+    check(MPI_Allreduce(&local, &global, 1, MPI_DOUBLE_INT, MPI_MINLOC,
+                        impl.comm),
+          "MPI_Allreduce failed");
+    if (global.func < std::numeric_limits<double>::infinity()) {
+        check(MPI_Bcast(x.data(), static_cast<int>(x.size()), MPI_FLOAT,
+                        global.rank, impl.comm),
+              "MPI_Bcast failed");
+    }
+    return global.func;
+}
+
+DA_NAMESPACE_END
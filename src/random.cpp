@@ -0,0 +1,190 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "random.hpp"
+#include "simd.hpp"
+
+#include <cmath>   // std::exp, std::log, std::sqrt, std::sin, std::cos
+#include <cstdint> // int32_t, uint32_t
+#include <cstring> // std::memcpy
+
+DA_NAMESPACE_BEGIN
+
+namespace detail {
+namespace {
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+constexpr auto two_pi = 6.28318530717958647692f;
+// 2^-23 and 2^-24
+constexpr auto inv_2_23 = 1.1920928955078125e-7f;
+constexpr auto inv_2_24 = 5.9604644775390625e-8f;
+
+#if defined(__GNUC__)
+static_assert(normal_block_size == 2 * lanes);
+
+/// \brief Natural logarithm for positive normal floats.
+///
+/// This is `logf` from the Cephes library. Maximal relative error is about
+/// `1e-7`.
+DA_FORCEINLINE auto log_approx(vfloat const& x) noexcept -> vfloat
+{
+    auto const bits = bit_cast<vint>(x);
+    auto       e    = ((bits >> 23) & 0xff) - 126;
+    // Mantissa in [0.5, 1)
+    auto m = bit_cast<vfloat>((bits & 0x007fffff) | 0x3f000000);
+    // Move the mantissa into [sqrt(0.5), sqrt(2))
+    vint const small = m < 0.707106781186547524f;
+    e += small;
+    m = m - 1.0f + bit_cast<vfloat>(small & bit_cast<vint>(m));
+
+    auto const z = m * m;
+    auto       y = 7.0376836292E-2f * m - 1.1514610310E-1f;
+    y            = y * m + 1.1676998740E-1f;
+    y            = y * m - 1.2420140846E-1f;
+    y            = y * m + 1.4249322787E-1f;
+    y            = y * m - 1.6668057665E-1f;
+    y            = y * m + 2.0000714765E-1f;
+    y            = y * m - 2.4999993993E-1f;
+    y            = y * m + 3.3333331174E-1f;
+    y            = y * m * z;
+
+    auto const f = __builtin_convertvector(e, vfloat);
+    y += -2.12194440e-4f * f;
+    y -= 0.5f * z;
+    return m + y + 0.693359375f * f;
+}
+
+/// Square root for positive normal floats using Newton iterations for the
+/// inverse square root.
+DA_FORCEINLINE auto sqrt_approx(vfloat const& x) noexcept -> vfloat
+{
+    auto y = bit_cast<vfloat>(0x5f375a86 - (bit_cast<vint>(x) >> 1));
+    auto const half_x = 0.5f * x;
+    y                 = y * (1.5f - half_x * y * y);
+    y                 = y * (1.5f - half_x * y * y);
+    y                 = y * (1.5f - half_x * y * y);
+    return x * y;
+}
+
+/// \brief Computes `sin(2πu)` and `cos(2πu)` for `u` in `[0, 1)`.
+///
+/// We reduce the argument exactly by splitting `4u` into an integer number of
+/// quadrants and a remainder in `[-1/2, 1/2]`, and then use Cephes
+/// polynomials on `[-π/4, π/4]`.
+DA_FORCEINLINE auto sincos_2pi(vfloat const& u, vfloat& sin,
+                               vfloat& cos) noexcept -> void
+{
+    auto const t = 4.0f * u;
+    auto const j = __builtin_convertvector(t + 0.5f, vint);
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers, readability-magic-numbers)
+    auto const r = (t - __builtin_convertvector(j, vfloat)) * 1.57079632679f;
+    auto const z = r * r;
+    auto const s =
+        ((-1.9515295891E-4f * z + 8.3321608736E-3f) * z - 1.6666654611E-1f)
+            * z * r
+        + r;
+    auto const c = ((2.443315711809948E-5f * z - 1.388731625493765E-3f) * z
+                    + 4.166664568298827E-2f)
+                       * z * z
+                   - 0.5f * z + 1.0f;
+    // sin(jπ/2 + r) and cos(jπ/2 + r) expressed through sin(r) and cos(r)
+    vint const swap = (j & 1) != 0;
+    sin = bit_cast<vfloat>(bit_cast<vint>(select(swap, c, s)) ^ ((j & 2) << 30));
+    cos = bit_cast<vfloat>(bit_cast<vint>(select(swap, s, c))
+                           ^ (((j + 1) & 2) << 30));
+}
+#endif
+} // namespace
+
+DA_EXPORT auto normal_ziggurat_tables() noexcept -> ziggurat_tables_t const&
+{
+    static ziggurat_tables_t const tables = []() {
+        // This is `zigset` from Marsaglia & Tsang (2000) for 128 layers.
+        constexpr auto m  = 2147483648.0; // 2^31
+        constexpr auto n  = ziggurat_tables_t::size;
+        constexpr auto vn = 9.91256303526217e-3; // Area of one layer
+        auto           dn = 3.442619855899;      // Start of the tail
+        auto           tn = dn;
+        auto const     q  = vn / std::exp(-0.5 * dn * dn);
+
+        ziggurat_tables_t t{};
+        t.k[0]     = static_cast<std::uint32_t>((dn / q) * m);
+        t.k[1]     = 0;
+        t.w[0]     = static_cast<float>(q / m);
+        t.w[n - 1] = static_cast<float>(dn / m);
+        t.f[0]     = 1.0f;
+        t.f[n - 1] = static_cast<float>(std::exp(-0.5 * dn * dn));
+        for (auto i = n - 2; i >= 1; --i) {
+            dn         = std::sqrt(-2.0 * std::log(vn / dn + std::exp(-0.5 * dn * dn)));
+            t.k[i + 1] = static_cast<std::uint32_t>((dn / tn) * m);
+            tn         = dn;
+            t.f[i]     = static_cast<float>(std::exp(-0.5 * dn * dn));
+            t.w[i]     = static_cast<float>(dn / m);
+        }
+        return t;
+    }();
+    return tables;
+}
+
+DA_TARGET_CLONES("avx512f", "avx2", "default")
+DA_EXPORT auto normal_block(std::uint32_t const* DUAL_ANNEALING_RESTRICT bits,
+                            float* DUAL_ANNEALING_RESTRICT out,
+                            float const stddev) noexcept -> void
+{
+#if defined(__GNUC__)
+    vint b1, b2;
+    std::memcpy(&b1, bits, sizeof(b1));
+    std::memcpy(&b2, bits + lanes, sizeof(b2));
+    // u1 in (0, 1) such that log(u1) is finite, u2 in [0, 1). NOTE: u1 uses
+    // only 23 bits so that `k + 1/2` is exactly representable as a float.
+    auto const u1 =
+        (__builtin_convertvector((b1 >> 9) & 0x007fffff, vfloat) + 0.5f)
+        * inv_2_23;
+    auto const u2 =
+        __builtin_convertvector((b2 >> 8) & 0x00ffffff, vfloat) * inv_2_24;
+    auto const r = stddev * sqrt_approx(-2.0f * log_approx(u1));
+    vfloat     sin, cos;
+    sincos_2pi(u2, sin, cos);
+    auto const z1 = r * cos;
+    auto const z2 = r * sin;
+    std::memcpy(out, &z1, sizeof(z1));
+    std::memcpy(out + lanes, &z2, sizeof(z2));
+#else
+    constexpr auto lanes = normal_block_size / 2;
+    for (auto i = size_t{0}; i < lanes; ++i) {
+        auto const u1 =
+            (static_cast<float>(bits[i] >> 9U) + 0.5f) * inv_2_23;
+        auto const u2 = static_cast<float>(bits[lanes + i] >> 8U) * inv_2_24;
+        auto const r  = stddev * std::sqrt(-2.0f * std::log(u1));
+        out[i]         = r * std::cos(two_pi * u2);
+        out[lanes + i] = r * std::sin(two_pi * u2);
+    }
+#endif
+}
+} // namespace detail
+
+DA_NAMESPACE_END
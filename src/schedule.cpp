@@ -0,0 +1,81 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "schedule.hpp"
+#include "simd.hpp"
+
+DA_NAMESPACE_BEGIN
+
+DA_EXPORT temperature_table_t::temperature_table_t(float const  q_V,
+                                                   float const  t_0,
+                                                   size_t const num_iter)
+    : _q_V{q_V}, _t_0{t_0}, _params{}
+{
+    _params.reserve(num_iter);
+    for (auto i = size_t{0}; i < num_iter; ++i) {
+        _params.emplace_back(q_V, detail::visiting_temperature(q_V, t_0, i));
+    }
+}
+
+namespace detail {
+DA_TARGET_CLONES("avx512f", "avx2", "default")
+DA_EXPORT auto acceptance_rule_t::accepts(gsl::span<float const>  u,
+                                          gsl::span<float const>  dE,
+                                          float const             t_A,
+                                          gsl::span<std::uint8_t> out) const
+    noexcept -> void
+{
+    DUAL_ANNEALING_ASSERT(u.size() == dE.size() && u.size() == out.size(),
+                          "incompatible dimensions");
+    auto       i = size_t{0};
+    auto const n = u.size();
+#if defined(__GNUC__)
+    if (_power != 0) {
+        for (; i + lanes <= n; i += lanes) {
+            auto const e      = load(dE.data() + i);
+            auto const factor = 1.0f + (_q_A - 1.0f) * e / t_A;
+            auto       x      = load(u.data() + i);
+            auto       r      = vfloat{} + 1.0f;
+            for (auto k = _power; k != 0; k >>= 1U) {
+                if ((k & 1U) != 0) { r *= x; }
+                x *= x;
+            }
+            vint const ok = (e < 0.0f) | ((factor > 0.0f) & (r <= factor));
+            for (auto l = size_t{0}; l < lanes; ++l) {
+                out[i + l] = static_cast<std::uint8_t>(ok[l] != 0);
+            }
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        out[i] = static_cast<std::uint8_t>(accepts(u[i], dE[i], t_A));
+    }
+}
+} // namespace detail
+
+DA_NAMESPACE_END
@@ -0,0 +1,94 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// \file
+/// \brief Portable SIMD vectors shared by the translation units in src/.
+///
+/// We use GCC/Clang vector extensions rather than intrinsics. The compiler
+/// then maps 16-wide vectors onto whatever registers the current target has:
+/// one zmm register with AVX-512, two ymm registers with AVX2, four xmm
+/// registers otherwise. Combined with #DA_TARGET_CLONES this gives good code
+/// for all three without writing it thrice.
+
+#pragma once
+
+#include "config.hpp"
+
+#include <cstddef> // size_t
+#include <cstdint> // int32_t
+#include <cstring> // std::memcpy
+
+#if defined(TCM_GCC)
+// All vector helpers are force-inlined into their callers, so the warning
+// about vector arguments changing the ABI is irrelevant. GCC only reports
+// it at the end of the translation unit, hence no push/pop.
+#    pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#if defined(__GNUC__)
+DA_NAMESPACE_BEGIN
+namespace detail {
+namespace {
+constexpr auto lanes = size_t{16};
+using vfloat = float __attribute__((vector_size(lanes * sizeof(float))));
+using vint   = std::int32_t __attribute__((vector_size(lanes * sizeof(float))));
+
+template <class To, class From>
+DA_FORCEINLINE auto bit_cast(From const& x) noexcept -> To
+{
+    static_assert(sizeof(To) == sizeof(From));
+    To y;
+    std::memcpy(&y, &x, sizeof(To));
+    return y;
+}
+
+/// Returns `mask ? a : b` lane-wise. Lanes of \p mask are either `0` or `-1`.
+DA_FORCEINLINE auto select(vint const& mask, vfloat const& a,
+                           vfloat const& b) noexcept -> vfloat
+{
+    return bit_cast<vfloat>((mask & bit_cast<vint>(a))
+                            | (~mask & bit_cast<vint>(b)));
+}
+
+/// Loads #lanes floats from a possibly unaligned address.
+DA_FORCEINLINE auto load(float const* p) noexcept -> vfloat
+{
+    vfloat x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+/// Stores #lanes floats to a possibly unaligned address.
+DA_FORCEINLINE auto store(float* p, vfloat const& x) noexcept -> void
+{
+    std::memcpy(p, &x, sizeof(x));
+}
+} // namespace
+} // namespace detail
+DA_NAMESPACE_END
+#endif
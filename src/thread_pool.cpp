@@ -0,0 +1,182 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "thread_pool.hpp"
+
+#include <algorithm>          // std::max
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <exception>          // std::exception_ptr
+#include <mutex>              // std::mutex
+#include <thread>             // std::thread
+#include <vector>             // std::vector
+
+DA_NAMESPACE_BEGIN
+
+namespace {
+/// Set to `true` on threads which are currently executing a task. We use it to
+/// detect nested calls to `thread_pool_t::for_each`.
+thread_local bool inside_task = false;
+
+struct job_t {
+    std::function<void(size_t)> const* task;
+    size_t                             size;
+    std::atomic<size_t>                next;
+    std::mutex                         error_mutex;
+    std::exception_ptr                 error;
+
+    job_t(std::function<void(size_t)> const& _task, size_t const _size)
+        : task{&_task}, size{_size}, next{0}, error_mutex{}, error{}
+    {}
+
+    auto run() noexcept -> void
+    {
+        inside_task = true;
+        for (;;) {
+            auto const i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= size) { break; }
+            try {
+                (*task)(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock{error_mutex};
+                if (!error) { error = std::current_exception(); }
+            }
+        }
+        inside_task = false;
+    }
+};
+} // namespace
+
+struct thread_pool_t::impl_t {
+    std::vector<std::thread> workers;
+    std::mutex               submit_mutex; ///< Serialises calls to for_each
+    std::mutex               mutex;        ///< Protects the fields below
+    std::condition_variable  start_cv;
+    std::condition_variable  done_cv;
+    job_t*                   job        = nullptr;
+    size_t                   generation = 0;
+    size_t                   pending    = 0; ///< Workers still busy with #job
+    bool                     stop       = false;
+
+    explicit impl_t(size_t const num_workers)
+    {
+        workers.reserve(num_workers);
+        for (auto i = size_t{0}; i < num_workers; ++i) {
+            workers.emplace_back([this]() noexcept { worker_loop(); });
+        }
+    }
+
+    impl_t(impl_t const&) = delete;
+    impl_t(impl_t&&)      = delete;
+    auto operator=(impl_t const&) -> impl_t& = delete;
+    auto operator=(impl_t&&) -> impl_t& = delete;
+
+    ~impl_t() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stop = true;
+        }
+        start_cv.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    auto worker_loop() noexcept -> void
+    {
+        auto                         seen = size_t{0};
+        std::unique_lock<std::mutex> lock{mutex};
+        for (;;) {
+            start_cv.wait(lock, [this, &seen]() {
+                return stop || generation != seen;
+            });
+            if (stop) { return; }
+            seen       = generation;
+            auto* task = job;
+            lock.unlock();
+            task->run();
+            lock.lock();
+            if (--pending == 0) { done_cv.notify_all(); }
+        }
+    }
+
+    auto for_each(size_t const n, std::function<void(size_t)> const& task)
+        -> void
+    {
+        job_t current{task, n};
+        if (workers.empty() || inside_task || n <= 1) {
+            // Nothing to distribute or we are already inside a task of this
+            // (or another) pool. Either way, doing the job on the current
+            // thread is the only sensible option.
+            auto const was_inside = inside_task;
+            current.run();
+            inside_task = was_inside;
+        }
+        else {
+            std::lock_guard<std::mutex> submit_lock{submit_mutex};
+            {
+                std::lock_guard<std::mutex> lock{mutex};
+                job     = &current;
+                pending = workers.size();
+                ++generation;
+            }
+            start_cv.notify_all();
+            current.run();
+            std::unique_lock<std::mutex> lock{mutex};
+            done_cv.wait(lock, [this]() { return pending == 0; });
+            job = nullptr;
+        }
+        if (current.error) { std::rethrow_exception(current.error); }
+    }
+};
+
+DA_EXPORT thread_pool_t::thread_pool_t(size_t num_threads)
+{
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    _impl = std::make_unique<impl_t>(num_threads - 1);
+}
+
+DA_EXPORT thread_pool_t::~thread_pool_t() noexcept = default;
+
+DA_EXPORT auto thread_pool_t::num_threads() const noexcept -> size_t
+{
+    return _impl->workers.size() + 1;
+}
+
+DA_EXPORT auto thread_pool_t::for_each(size_t const                      n,
+                                       std::function<void(size_t)> const& task)
+    -> void
+{
+    _impl->for_each(n, task);
+}
+
+DA_NAMESPACE_END
@@ -0,0 +1,63 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "visiting_scales.hpp"
+#include "assert.hpp"
+
+#include <cmath> // std::exp
+
+DA_NAMESPACE_BEGIN
+
+namespace detail {
+DA_EXPORT auto visiting_scales_t::init(size_t const dim, float const target,
+                                       float const rate) -> void
+{
+    if (!(target > 0.0f)) {
+        _scales.clear();
+        _num_accepted.clear();
+        return;
+    }
+    _scales.assign(dim, 1.0f);
+    _num_accepted.assign(dim, 0);
+    _grow   = std::exp(rate * (1.0f - target));
+    _shrink = std::exp(-rate * target);
+}
+
+DA_EXPORT auto visiting_scales_t::apply(gsl::span<float> const steps) const
+    noexcept -> void
+{
+    DUAL_ANNEALING_ASSERT(steps.size() == _scales.size(),
+                          "incompatible dimensions");
+    auto const* scales = _scales.data();
+    for (auto i = size_t{0}; i < steps.size(); ++i) {
+        steps[i] *= scales[i];
+    }
+}
+} // namespace detail
+
+DA_NAMESPACE_END
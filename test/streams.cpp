@@ -0,0 +1,91 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "streams.hpp"
+#include <catch2/catch.hpp>
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t, uint64_t
+
+using dual_annealing::philox4x32_t;
+
+TEST_CASE("Philox4x32-10 reproduces the Random123 known answers", "[streams]")
+{
+    // From kat_vectors of Random123
+    CHECK(philox4x32_t::bijection({0, 0, 0, 0}, {0, 0})
+          == philox4x32_t::block_type{0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                      0x9b00dbd8});
+    CHECK(philox4x32_t::bijection(
+              {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+              {0xffffffff, 0xffffffff})
+          == philox4x32_t::block_type{0x408f276d, 0x41c83b0e, 0xa20bc7c6,
+                                      0x6d5451fd});
+    CHECK(philox4x32_t::bijection(
+              {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+              {0xa4093822, 0x299f31d0})
+          == philox4x32_t::block_type{0xd16cfe09, 0x94fdcceb, 0x5001e420,
+                                      0x24126ea1});
+}
+
+TEST_CASE("philox4x32_t outputs the bijection of its counter", "[streams]")
+{
+    auto const seed   = std::uint64_t{0x299f31d0a4093822};
+    auto const stream = std::uint64_t{0x0370734413198a2e};
+    auto       g      = philox4x32_t{seed, stream};
+    for (auto position = std::uint32_t{0}; position < 3; ++position) {
+        auto const block = philox4x32_t::bijection(
+            {position, 0, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0});
+        for (auto const x : block) {
+            CHECK(g() == x);
+        }
+    }
+}
+
+TEST_CASE("discard(n) is the same as n calls to operator()", "[streams]")
+{
+    // All offsets within a block, and jumps which end in the same, the next
+    // and a much later block
+    for (auto offset = size_t{0}; offset <= philox4x32_t::block_size;
+         ++offset) {
+        for (auto const n : {0, 1, 2, 3, 4, 5, 7, 8, 9, 12, 13, 1001}) {
+            auto a = philox4x32_t{12345, 6};
+            for (auto i = size_t{0}; i < offset; ++i) {
+                a();
+            }
+            auto b = a;
+            a.discard(static_cast<std::uint64_t>(n));
+            for (auto i = 0; i < n; ++i) {
+                b();
+            }
+            CHECK(a == b);
+            for (auto i = 0; i < 9; ++i) {
+                CHECK(a() == b());
+            }
+        }
+    }
+}
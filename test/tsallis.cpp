@@ -0,0 +1,107 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "tsallis_distribution.hpp"
+#include <catch2/catch.hpp>
+#include <pcg_random.hpp>
+
+#include <cmath>   // std::abs
+#include <cstddef> // size_t
+#include <utility> // std::pair
+#include <vector>  // std::vector
+
+namespace {
+constexpr auto number_bins    = size_t{50};
+constexpr auto min            = -20.0;
+constexpr auto max            = 20.0;
+constexpr auto number_samples = size_t{1000000};
+
+/// Normalised histogram of `number_samples` samples from \p sample, which
+/// appends any number of samples to its argument.
+template <class Sampler> auto histogram(Sampler&& sample) -> std::vector<double>
+{
+    constexpr auto      bin_size = (max - min) / static_cast<double>(number_bins);
+    std::vector<double> bins(number_bins, 0.0);
+    std::vector<float>  xs;
+    while (xs.size() < number_samples) {
+        sample(xs);
+    }
+    for (auto const x : xs) {
+        auto const y = static_cast<double>(x);
+        if (y < min || y >= max) { continue; }
+        bins[static_cast<size_t>((y - min) / bin_size)] += 1.0;
+    }
+    for (auto& b : bins) {
+        b /= static_cast<double>(xs.size());
+    }
+    return bins;
+}
+
+auto l1_distance(std::vector<double> const& a, std::vector<double> const& b)
+    -> double
+{
+    auto d = 0.0;
+    for (auto i = size_t{0}; i < a.size(); ++i) {
+        d += std::abs(a[i] - b[i]);
+    }
+    return d;
+}
+} // namespace
+
+TEST_CASE("Bulk Tsallis samplers match operator()", "[tsallis]")
+{
+    // Correct samplers stay below 0.008 for these histogram sizes, and a 10%
+    // error in the scale of the bulk samples gives at least 0.02.
+    constexpr auto tolerance = 0.012;
+    constexpr auto dim       = size_t{10};
+    for (auto const& [q_V, t_V] : {std::pair{2.62f, 1.0f},
+                                  std::pair{1.5f, 0.5f},
+                                  std::pair{2.2f, 3.0f}}) {
+        pcg32                                  generator{12349827UL};
+        dual_annealing::tsallis_distribution_t dist{q_V, t_V};
+
+        auto const reference = histogram([&](auto& xs) {
+            xs.push_back(dist(generator));
+        });
+        auto const independent = histogram([&](auto& xs) {
+            xs.resize(xs.size() + dim);
+            dist.fill_independent(
+                generator, gsl::span<float>{xs.data() + xs.size() - dim, dim});
+        });
+        CHECK(l1_distance(reference, independent) < tolerance);
+
+        // Coordinates of one N-D sample share its scale, so we use many more
+        // samples than coordinates per sample.
+        auto const bulk = histogram([&](auto& xs) {
+            xs.resize(xs.size() + dim);
+            dist.fill(generator,
+                      gsl::span<float>{xs.data() + xs.size() - dim, dim});
+        });
+        CHECK(l1_distance(reference, bulk) < tolerance);
+    }
+}
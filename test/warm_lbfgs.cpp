@@ -0,0 +1,84 @@
+// Copyright (c) 2019, Tom Westerhout
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// * Neither the name of the copyright holder nor the names of its
+//   contributors may be used to endorse or promote products derived from
+//   this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "warm_lbfgs.hpp"
+#include <catch2/catch.hpp>
+
+#include <vector> // std::vector
+
+namespace {
+using dual_annealing::lbfgs_history_t;
+
+auto direction(lbfgs_history_t& history, std::vector<float> const& g)
+    -> std::vector<float>
+{
+    std::vector<float> d(g.size());
+    history.direction(g, d);
+    return d;
+}
+} // namespace
+
+TEST_CASE("Rejected pairs leave the L-BFGS history unchanged", "[warm_lbfgs]")
+{
+    auto const g = std::vector<float>{1.0f, -2.0f, 0.5f};
+    for (auto const m : {size_t{2}, size_t{3}}) {
+        lbfgs_history_t history;
+        history.reserve(m, 3);
+        // Two pairs with positive curvature. With m == 2 the history is full
+        // afterwards, so the next pair would go into the slot of the oldest.
+        REQUIRE(history.push(std::vector<float>{0.0f, 0.0f, 0.0f},
+                             std::vector<float>{1.0f, 0.0f, 0.0f},
+                             std::vector<float>{0.0f, 0.0f, 0.0f},
+                             std::vector<float>{2.0f, 0.5f, 0.0f}));
+        REQUIRE(history.push(std::vector<float>{1.0f, 0.0f, 0.0f},
+                             std::vector<float>{1.0f, 1.0f, 0.5f},
+                             std::vector<float>{2.0f, 0.5f, 0.0f},
+                             std::vector<float>{2.5f, 3.5f, 1.0f}));
+        auto const before = direction(history, g);
+
+        // Negative curvature: s . y < 0
+        CHECK(!history.push(std::vector<float>{1.0f, 1.0f, 0.5f},
+                            std::vector<float>{2.0f, 1.0f, 0.5f},
+                            std::vector<float>{2.5f, 3.5f, 1.0f},
+                            std::vector<float>{1.0f, 3.5f, 1.0f}));
+        // Step below the resolution of `float`
+        CHECK(!history.push(std::vector<float>{1.0f, 1.0f, 0.5f},
+                            std::vector<float>{1.0f, 1.0f, 0.5f},
+                            std::vector<float>{2.5f, 3.5f, 1.0f},
+                            std::vector<float>{3.0f, 3.5f, 1.0f}));
+        CHECK(history.size() == 2);
+        CHECK(direction(history, g) == before);
+
+        // Whereas an accepted pair does change the direction
+        CHECK(history.push(std::vector<float>{1.0f, 1.0f, 0.5f},
+                           std::vector<float>{1.0f, 2.0f, 0.5f},
+                           std::vector<float>{2.5f, 3.5f, 1.0f},
+                           std::vector<float>{2.5f, 4.0f, 1.0f}));
+        CHECK(direction(history, g) != before);
+    }
+}